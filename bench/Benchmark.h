@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+inline volatile std::uint64_t sink = 0;
+
+/// Keeps the compiler from optimising away work whose result is unused.
+template <typename T> void DoNotOptimize(const T &value) {
+  sink = static_cast<std::uint64_t>(value);
+}
+
+struct Options {
+  std::string filter;
+  std::chrono::milliseconds sampleTime{50};
+  int samples = 5;
+};
+
+/// Reports every measurement as one JSON object per line so runs of
+/// different builds can be diffed and compared by scripts.
+class Runner {
+public:
+  Runner(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--filter" && i + 1 < argc) {
+        mOptions.filter = argv[++i];
+      } else if (arg == "--sample-ms" && i + 1 < argc) {
+        mOptions.sampleTime = std::chrono::milliseconds(std::stoul(argv[++i]));
+      } else if (arg == "--samples" && i + 1 < argc) {
+        mOptions.samples = std::max(1, std::stoi(argv[++i]));
+      } else {
+        mArguments.push_back(arg);
+      }
+    }
+  }
+
+  /// Arguments not consumed by the runner, e.g. ROM paths.
+  const std::vector<std::string> &GetArguments() const { return mArguments; }
+  const Options &GetOptions() const { return mOptions; }
+
+  bool Enabled(const std::string &name) const {
+    return name.find(mOptions.filter) != std::string::npos;
+  }
+
+  /// Calls the body repeatedly, each call performs opsPerCall operations.
+  /// The reported time is the median over all samples.
+  void Run(const std::string &name, std::uint64_t opsPerCall,
+           const std::function<void()> &body) {
+    if (!Enabled(name)) {
+      return;
+    }
+    using Clock = std::chrono::steady_clock;
+
+    // Grow the batch until one batch takes a measurable amount of time.
+    const auto target = std::chrono::nanoseconds(mOptions.sampleTime) / 10;
+    std::uint64_t calls = 1;
+    while (true) {
+      const auto start = Clock::now();
+      for (std::uint64_t i = 0; i < calls; ++i) {
+        body();
+      }
+      if (Clock::now() - start >= target ||
+          calls >= (1ULL << 40)) {
+        break;
+      }
+      calls *= 2;
+    }
+    calls *= 10;
+
+    std::vector<double> nsPerOp;
+    for (int sample = 0; sample < mOptions.samples; ++sample) {
+      const auto start = Clock::now();
+      for (std::uint64_t i = 0; i < calls; ++i) {
+        body();
+      }
+      const std::chrono::duration<double, std::nano> elapsed =
+          Clock::now() - start;
+      nsPerOp.push_back(elapsed.count() / (calls * opsPerCall));
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    Report(name, calls * opsPerCall, nsPerOp[nsPerOp.size() / 2]);
+  }
+
+  /// Reports a measurement taken by the caller.
+  void Report(const std::string &name, std::uint64_t ops, double nsPerOp,
+              const std::string &extra = "") {
+    std::cout << std::dec << std::fixed << std::setprecision(3)
+              << "{\"name\": \"" << name
+              << "\", \"ops\": " << ops << ", \"ns_per_op\": " << nsPerOp
+              << ", \"ops_per_sec\": " << 1e9 / nsPerOp << extra << "}"
+              << std::endl;
+  }
+
+private:
+  Options mOptions;
+  std::vector<std::string> mArguments;
+};
+
+} // namespace bench
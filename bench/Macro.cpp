@@ -0,0 +1,284 @@
+#include "Benchmark.h"
+
+#include <Emulator/Emulator.h>
+#include <Emulator/Fleet.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Rom {
+  std::string name;
+  std::filesystem::path path;
+};
+
+// Small endless loops that keep one part of the machine busy.
+const std::vector<std::pair<std::string, std::vector<std::uint16_t>>>
+    synthetic_roms = {
+        // Arithmetic and logic on registers only.
+        {"alu",
+         {0x6001, 0x7101, 0x8214, 0x8325, 0x8413, 0x8526, 0x1202}},
+        // Draws the built in digits across the screen.
+        {"draw", {0xF029, 0xD125, 0x7103, 0x7201, 0x7001, 0x1200}},
+        // Converts a counter to decimal and reads the digits back.
+        {"bcd", {0xA300, 0xF333, 0xF265, 0x7301, 0x1202}},
+        // Calls a subroutine and returns from it.
+        {"call", {0x2206, 0x7101, 0x1200, 0x7001, 0x00EE}},
+        // Waits two frames on the delay timer between draws, like most games.
+        {"timer",
+         {0x6002, 0xF015, 0xF107, 0x3100, 0x1204, 0xD235, 0x7201, 0x1200}},
+};
+
+bool WriteRom(const std::filesystem::path &path,
+              const std::vector<std::uint16_t> &words) {
+  std::ofstream os(path, std::ios::binary);
+  for (auto word : words) {
+    os.put(static_cast<char>(word >> 8));
+    os.put(static_cast<char>(word & 0xFF));
+  }
+  return static_cast<bool>(os);
+}
+
+std::string EngineName(emulator::Engine engine) {
+  switch (engine) {
+  case emulator::Engine::Instructions:
+    return "instructions";
+  case emulator::Engine::Interpreter:
+    return "interpreter";
+  case emulator::Engine::Threaded:
+    return "threaded";
+  }
+  return "unknown";
+}
+
+enum class Variant {
+  Plain,
+  // Every instruction recorded to a binary trace.
+  Traced,
+  // Hot blocks compiled to native code, the Threaded engine only.
+  Jit,
+};
+
+void RunRom(bench::Runner &runner, const Rom &rom, emulator::Engine engine,
+            std::uint64_t instructions, Variant variant = Variant::Plain) {
+  const bool traced = variant == Variant::Traced;
+  const auto name = "rom/" + EngineName(engine) +
+                    (traced                       ? "+trace/"
+                     : variant == Variant::Jit ? "+jit/"
+                                                  : "/") +
+                    rom.name;
+  if (!runner.Enabled(name)) {
+    return;
+  }
+
+  std::vector<double> nsPerInstruction;
+  std::uint64_t executed = 0;
+  for (int sample = 0; sample < runner.GetOptions().samples; ++sample) {
+    auto emulator = std::make_unique<emulator::Emulator>();
+    emulator->SetEngine(engine);
+    emulator->SetJitEnabled(variant == Variant::Jit);
+    if (!emulator->LoadGame(rom.path)) {
+      std::cerr << "Skipping " << rom.path << std::endl;
+      return;
+    }
+    const auto trace = std::filesystem::temp_directory_path() /
+                       "chip8-bench-trace.bin";
+    if (traced && !emulator->StartTrace(trace)) {
+      return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    executed = emulator->RunFor(instructions);
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (traced) {
+      emulator->StopTrace();
+      std::filesystem::remove(trace);
+    }
+    if (executed == 0) {
+      std::cerr << "Skipping " << rom.path << ", no instructions executed"
+                << std::endl;
+      return;
+    }
+    nsPerInstruction.push_back(elapsed.count() / executed);
+  }
+
+  std::sort(nsPerInstruction.begin(), nsPerInstruction.end());
+  const auto ns = nsPerInstruction[nsPerInstruction.size() / 2];
+  std::ostringstream extra;
+  extra << std::fixed << ", \"frames_per_sec\": "
+        << 1e9 / (ns * emulator::instructions_per_frame)
+        << ", \"completed\": "
+        << (executed == instructions ? "true" : "false");
+  runner.Report(name, executed, ns, extra.str());
+}
+
+// Machines per fleet, a few batches worth.
+constexpr std::size_t fleet_machines = 1024;
+
+/// Times run after an untimed setup for each of the runner's samples,
+/// reports the median time per instruction run executed.
+void ReportSamples(bench::Runner &runner, const std::string &name,
+                   const std::function<bool()> &setup,
+                   const std::function<std::uint64_t()> &run) {
+  if (!runner.Enabled(name)) {
+    return;
+  }
+  std::vector<double> nsPerInstruction;
+  std::uint64_t executed = 0;
+  for (int sample = 0; sample < runner.GetOptions().samples; ++sample) {
+    if (!setup()) {
+      return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    executed = run();
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (executed == 0) {
+      return;
+    }
+    nsPerInstruction.push_back(elapsed.count() / executed);
+  }
+  std::sort(nsPerInstruction.begin(), nsPerInstruction.end());
+  runner.Report(name, executed, nsPerInstruction[nsPerInstruction.size() / 2]);
+}
+
+/// The same instructions run on separate Emulators and on a Fleet, once with
+/// every machine in lockstep and once with the machines started from
+/// different registers so they take different paths.
+void FleetBenchmarks(bench::Runner &runner, const Rom &rom,
+                     std::uint64_t instructions) {
+  const auto steps = std::max<std::uint64_t>(instructions / fleet_machines, 1);
+  std::vector<std::unique_ptr<emulator::Emulator>> emulators;
+  ReportSamples(
+      runner, "fleet/separate/" + rom.name,
+      [&] {
+        emulators.clear();
+        for (std::size_t machine = 0; machine < fleet_machines; ++machine) {
+          emulators.push_back(std::make_unique<emulator::Emulator>());
+          if (!emulators.back()->LoadGame(rom.path)) {
+            return false;
+          }
+        }
+        return true;
+      },
+      [&] {
+        std::uint64_t executed = 0;
+        for (auto &emulator : emulators) {
+          executed += emulator->RunFor(steps);
+        }
+        return executed;
+      });
+  emulators.clear();
+
+  emulator::Fleet fleet(fleet_machines);
+  auto prototype = std::make_unique<emulator::Emulator>();
+  if (!prototype->LoadGame(rom.path)) {
+    return;
+  }
+  const auto start = prototype->TakeSnapshot();
+  for (const bool diverged : {false, true}) {
+    ReportSamples(
+        runner,
+        (diverged ? "fleet/diverged/" : "fleet/lockstep/") + rom.name,
+        [&] {
+          fleet.Reset(start);
+          for (std::size_t machine = 0; diverged && machine < fleet_machines;
+               ++machine) {
+            auto snapshot = start;
+            for (auto &reg : snapshot.registers.V) {
+              reg = static_cast<std::uint8_t>(machine * 37 + reg);
+            }
+            fleet.Restore(machine, snapshot);
+          }
+          return true;
+        },
+        [&] { return fleet.RunFor(steps); });
+  }
+}
+
+/// Snapshots taken and restored while a ROM keeps writing to memory.
+void SnapshotBenchmarks(bench::Runner &runner, const Rom &rom) {
+  auto emulator = std::make_unique<emulator::Emulator>();
+  if (!emulator->LoadGame(rom.path)) {
+    return;
+  }
+  auto snapshot = emulator->TakeSnapshot();
+  runner.Run("snapshot/take/" + rom.name, 1, [&] {
+    emulator->RunFor(1);
+    snapshot = emulator->TakeSnapshot();
+  });
+  runner.Run("snapshot/restore/" + rom.name, 1, [&] {
+    emulator->RunFor(1);
+    emulator->RestoreSnapshot(snapshot);
+  });
+}
+
+} // namespace
+
+/// Runs every ROM headless for a fixed number of instructions.
+/// Usage: bench_macro [--instructions N] [runner options] [rom]...
+int main(int argc, char *argv[]) {
+  bench::Runner runner(argc, argv);
+
+  std::uint64_t instructions = 1'000'000;
+  std::vector<Rom> roms;
+  const auto &arguments = runner.GetArguments();
+  for (std::size_t i = 0; i < arguments.size(); ++i) {
+    if (arguments[i] == "--instructions" && i + 1 < arguments.size()) {
+      instructions = std::stoull(arguments[++i]);
+    } else {
+      const std::filesystem::path path = arguments[i];
+      roms.push_back({path.filename().string(), path});
+    }
+  }
+
+  const auto directory = std::filesystem::temp_directory_path();
+  std::vector<std::filesystem::path> written;
+  for (const auto &[name, words] : synthetic_roms) {
+    const auto path = directory / ("chip8-bench-" + name + ".ch8");
+    if (!WriteRom(path, words)) {
+      std::cerr << "Failed to write " << path << std::endl;
+      return 1;
+    }
+    written.push_back(path);
+    roms.insert(roms.begin() + (written.size() - 1),
+                {"synthetic-" + name, path});
+  }
+
+  for (const auto &rom : roms) {
+    for (auto engine :
+         {emulator::Engine::Instructions, emulator::Engine::Interpreter,
+          emulator::Engine::Threaded}) {
+      RunRom(runner, rom, engine, instructions);
+    }
+    if (emulator::jit::IsSupported()) {
+      RunRom(runner, rom, emulator::Engine::Threaded, instructions,
+             Variant::Jit);
+    }
+    RunRom(runner, rom, emulator::Engine::Interpreter, instructions,
+           Variant::Traced);
+    FleetBenchmarks(runner, rom, instructions);
+  }
+
+  // The BCD loop writes to memory every iteration.
+  SnapshotBenchmarks(runner, *std::find_if(roms.begin(), roms.end(),
+                                           [](const Rom &rom) {
+                                             return rom.name == "synthetic-bcd";
+                                           }));
+
+  for (const auto &path : written) {
+    std::filesystem::remove(path);
+  }
+  return 0;
+}
@@ -0,0 +1,188 @@
+#include "Benchmark.h"
+
+#include <CPU/CpuState.h>
+#include <Instructions/Decoder.h>
+#include <Instructions/Disassembler.h>
+#include <Instructions/InstructionUtil.h>
+#include <Instructions/Interpreter.h>
+#include <Output/Display.h>
+
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Instructions;
+
+namespace {
+
+constexpr std::uint64_t all_words = 0x10000;
+
+struct OpcodeCase {
+  std::string name;
+  std::vector<std::uint16_t> words;
+};
+
+// One case per implemented opcode. Instructions that would run the machine
+// out of its stack are paired with the instruction undoing them.
+const std::vector<OpcodeCase> opcode_cases = {
+    {"CLS", {0x00E0}},         {"JP", {0x1300}},
+    {"JPV0", {0xB300}},        {"CALL+RET", {0x2300, 0x00EE}},
+    {"SExkk", {0x3118}},       {"SNExkk", {0x4118}},
+    {"SExy", {0x5120}},        {"SNExy", {0x9120}},
+    {"LDxkk", {0x61AB}},       {"LDxy", {0x8120}},
+    {"LDnnn", {0xA400}},       {"LDxdt", {0xF207}},
+    {"LDdtx", {0xF315}},       {"LDstx", {0xF418}},
+    {"LDfx", {0xF529}},        {"LDbx", {0xF633}},
+    {"LDix", {0xFF55}},        {"LDxi", {0xFF65}},
+    {"ADDxkk", {0x7901}},      {"ADDxy", {0x8124}},
+    {"ADDix", {0xF41E}},       {"OR", {0x8341}},
+    {"AND", {0x8452}},         {"XOR", {0x8563}},
+    {"SUB", {0x8125}},         {"SUBN", {0x8217}},
+    {"SHR", {0x8676}},         {"SHL", {0x878E}},
+    {"RND", {0xC10F}},         {"DRW", {0xD12F}},
+    {"SKP", {0xE19E}},         {"SKNP", {0xE1A1}},
+};
+
+void PrepareState(CpuState &state) {
+  state.registers.PC = cpu::memory_start;
+  state.registers.I = 0x400;
+  state.registers.V[0x1] = 0x18;
+  state.registers.V[0x2] = 0x09;
+  state.keys = 0x0100;
+}
+
+void DecodeBenchmarks(bench::Runner &runner) {
+  runner.Run("decode/GetInstructionDef", all_words, [] {
+    for (std::uint32_t word = 0; word < all_words; ++word) {
+      bench::DoNotOptimize(
+          Disassembler::GetInstructionDef(static_cast<std::uint16_t>(word))
+              .GetOpcode());
+    }
+  });
+  runner.Run("decode/Decode", all_words, [] {
+    for (std::uint32_t word = 0; word < all_words; ++word) {
+      bench::DoNotOptimize(Decode(static_cast<std::uint16_t>(word)).opcode);
+    }
+  });
+  runner.Run("decode/Disassemble", 1, [] {
+    delete Disassembler::Disassemble(0x8124, cpu::instruction_start);
+  });
+  runner.Run("decode/DumpAll", all_words, [] {
+    std::ostringstream os;
+    for (std::uint32_t word = 0; word < all_words; ++word) {
+      std::unique_ptr<Instruction> instruction(Disassembler::Disassemble(
+          static_cast<std::uint16_t>(word), cpu::instruction_start));
+      instruction->Dump(os);
+      os << "\n";
+    }
+    bench::DoNotOptimize(static_cast<std::streamoff>(os.tellp()));
+  });
+  runner.Run("decode/FormatAll", all_words, [] {
+    static std::vector<char> text(all_words *
+                                  (Disassembler::max_line_size + 1));
+    auto *out = text.data();
+    for (std::uint32_t word = 0; word < all_words; ++word) {
+      out = Disassembler::Format(static_cast<std::uint16_t>(word),
+                                 cpu::instruction_start, out);
+      *out++ = '\n';
+    }
+    bench::DoNotOptimize(out - text.data());
+  });
+}
+
+void ExecuteBenchmarks(bench::Runner &runner) {
+  for (const auto &opcodeCase : opcode_cases) {
+    const auto ops = opcodeCase.words.size();
+
+    std::vector<std::unique_ptr<Instruction>> instructions;
+    std::vector<DecodedInstruction> decoded;
+    for (auto word : opcodeCase.words) {
+      instructions.emplace_back(CreateInstruction(
+          cpu::instruction_start, GetDefinition(word).GetOpcode(), word));
+      decoded.push_back(Decode(word));
+    }
+
+    auto state = std::make_unique<CpuState>();
+    PrepareState(*state);
+    runner.Run("execute/instructions/" + opcodeCase.name, ops, [&] {
+      for (auto &instruction : instructions) {
+        instruction->Execute(*state);
+      }
+    });
+
+    state = std::make_unique<CpuState>();
+    PrepareState(*state);
+    runner.Run("execute/interpreter/" + opcodeCase.name, ops, [&] {
+      for (const auto &instruction : decoded) {
+        Interpreter::Execute(instruction, *state);
+      }
+    });
+  }
+}
+
+void DisplayBenchmarks(bench::Runner &runner) {
+  Output::Display display;
+  const std::vector<std::uint8_t> sprite = {0xFF, 0x81, 0xBD, 0xA5, 0xA5,
+                                            0xBD, 0x81, 0xFF, 0x3C, 0x42,
+                                            0x99, 0xA5, 0x42, 0x3C, 0x18};
+  std::size_t position = 0;
+  runner.Run("display/Draw", 1, [&] {
+    bench::DoNotOptimize(display.Draw(position, position / 2, sprite));
+    position = (position + 7) % Output::display_width;
+  });
+  runner.Run("display/Clear", 1, [&] { display.Clear(); });
+  // A sprite moving across the screen, acknowledged after every draw.
+  runner.Run("display/AcknowledgeDamage", 1, [&] {
+    display.Draw(position, 8, sprite);
+    position = (position + 1) % Output::display_width;
+    bench::DoNotOptimize(display.AcknowledgeDamage());
+  });
+}
+
+void MemoryBenchmarks(bench::Runner &runner) {
+  cpu::Memory memory;
+  constexpr std::uint64_t span = cpu::memory_size - cpu::memory_start - 1;
+  runner.Run("memory/Read", span, [&] {
+    std::uint32_t sum = 0;
+    for (std::uint16_t address = cpu::memory_start;
+         address < cpu::memory_size - 1; ++address) {
+      sum += memory.Read(address);
+    }
+    bench::DoNotOptimize(sum);
+  });
+  runner.Run("memory/ReadUint16", span, [&] {
+    std::uint32_t sum = 0;
+    for (std::uint16_t address = cpu::memory_start;
+         address < cpu::memory_size - 1; ++address) {
+      sum += memory.ReadUint16(address);
+    }
+    bench::DoNotOptimize(sum);
+  });
+  runner.Run("memory/Load", cpu::memory_size, [&] {
+    std::uint32_t sum = 0;
+    for (std::uint16_t address = 0; address < cpu::memory_size; ++address) {
+      sum += memory.Load(address);
+    }
+    bench::DoNotOptimize(sum);
+  });
+  runner.Run("memory/Fetch", cpu::memory_size, [&] {
+    std::uint32_t sum = 0;
+    for (std::uint16_t address = 0; address < cpu::memory_size; ++address) {
+      sum += memory.Fetch(address);
+    }
+    bench::DoNotOptimize(sum);
+  });
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bench::Runner runner(argc, argv);
+  DecodeBenchmarks(runner);
+  ExecuteBenchmarks(runner);
+  DisplayBenchmarks(runner);
+  MemoryBenchmarks(runner);
+  return 0;
+}
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "Memory.h"
+#include "Random.h"
+#include <Input/Keys.h>
 #include <Output/Display.h>
+#include <Util/CacheLine.h>
 
 // stdlib
-
+#include <array>
+#include <cstddef>
 #include <cstdint>
 namespace cpu {
 
@@ -43,33 +47,44 @@ enum class Register {
   SP = 0xFFF1,
 };
 
+constexpr std::size_t register_count = 16;
+
+/// The whole register file, small enough to share a single cache line.
+struct alignas(util::cache_line_size) Registers {
+  // General purpose registers V0 to VF, indexed by the register nibble of an
+  // instruction. VF is used for flags by some instructions.
+  std::array<std::uint8_t, register_count> V{};
+  // 16bit register to store 12bit address.
+  std::uint16_t I = 0;
+  // 16bit register to keep track of the program counter.
+  std::uint16_t PC = 0;
+  // Special purpose registers for delay and sound timers.
+  std::uint8_t VDelay = 0;
+  std::uint8_t VSound = 0;
+  // 8bit points to the topmost level of the stack.
+  std::uint8_t SP = 0;
+
+  constexpr std::uint8_t &operator[](std::uint8_t index) {
+    return V[index & 0xF];
+  }
+  constexpr std::uint8_t operator[](std::uint8_t index) const {
+    return V[index & 0xF];
+  }
+};
+static_assert(sizeof(Registers) == util::cache_line_size);
+
 struct CpuState {
-  struct registers {
-    std::uint8_t V0 = 0;
-    std::uint8_t V1 = 0;
-    std::uint8_t V2 = 0;
-    std::uint8_t V3 = 0;
-    std::uint8_t V4 = 0;
-    std::uint8_t V5 = 0;
-    std::uint8_t V6 = 0;
-    std::uint8_t V7 = 0;
-    std::uint8_t V8 = 0;
-    std::uint8_t V9 = 0;
-    std::uint8_t VA = 0;
-    std::uint8_t VB = 0;
-    std::uint8_t VC = 0;
-    std::uint8_t VD = 0;
-    std::uint8_t VE = 0;
-    std::uint8_t VF = 0;
-    std::uint16_t I = 0;
-    std::uint8_t VDelay = 0;
-    std::uint8_t VSound = 0;
-    std::uint16_t PC = 0;
-    std::uint8_t SP = 0;
-  } registers;
+  Registers registers;
 
   Memory memory;
   Output::Display display;
+  // Drawn from by RND.
+  Random random;
+  // Keys held down, latched at the start of every frame and tested by SKP
+  // and SKNP.
+  input::KeyMask keys = 0;
+  // Keys pressed since the latch before, taken by LD Vx, K.
+  input::KeyMask pressedKeys = 0;
 };
 
 } // namespace cpu
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <Output/Sprites.h>
+#include <Util/CacheLine.h>
 
 // stdlib
+#include <array>
 #include <cstdint>
+#include <memory>
 #include <ostream>
-#include <vector>
+#include <span>
+#include <utility>
 
 namespace cpu {
 
@@ -14,6 +18,42 @@ constexpr auto memory_size = 0x1000U;
 // was located, and should not be used by programs
 constexpr auto memory_start = 0x200U;
 constexpr auto instruction_start = 0x200U;
+constexpr auto stack_size = 16U;
+// Addresses are 12 bit, the unchecked accessors wrap around at the end.
+constexpr auto address_mask = memory_size - 1;
+// The start of memory is repeated after its end so that any view of up to
+// this many bytes is contiguous, even when it wraps around. Covers sprites
+// and loading or storing all registers.
+constexpr auto mirror_size = 0x10U;
+
+// Memory is snapshotted in pages, only pages written since the previous
+// snapshot are copied.
+constexpr auto page_size = 0x100U;
+constexpr auto page_count = memory_size / page_size;
+using Page = std::array<std::uint8_t, page_size>;
+static_assert(page_count <= 16, "Dirty pages are kept in 16 bits");
+
+// Writes are also logged per 16 byte line, finer than pages, so compiled code
+// only has to be thrown away when a write comes close to it.
+constexpr auto line_size = 0x10U;
+constexpr auto line_count = memory_size / line_size;
+using LineMask = std::array<std::uint64_t, line_count / 64>;
+
+/// Told about writes to the lines it watches, e.g. lines holding compiled
+/// code. Called from inside the write, so it should only take note and act
+/// once the writing instruction is done.
+class WriteObserver {
+public:
+  virtual ~WriteObserver() = default;
+  virtual void OnWatchedLineWritten(std::size_t line) = 0;
+};
+
+/// An immutable copy of the memory. Pages that did not change between
+/// snapshots are shared by them.
+struct MemorySnapshot {
+  std::array<std::shared_ptr<const Page>, page_count> pages;
+  std::array<std::uint16_t, stack_size> stack;
+};
 
 class Memory {
 public:
@@ -22,24 +62,121 @@ public:
   Memory(Memory &&) = delete;
   Memory &operator=(const Memory &) = delete;
 
+  // Checked accessors, only valid for program memory.
   std::uint8_t Read(std::uint16_t address) const;
   std::uint16_t ReadUint16(std::uint16_t address) const;
   void Write(std::uint16_t address, std::uint8_t value);
   void WriteUint16(std::uint16_t address, std::uint16_t value);
   bool IsValidAddress(std::uint16_t address) const;
-  bool LoadIntoMemory(std::vector<std::uint8_t> buffer, std::uint16_t address);
+  bool LoadIntoMemory(std::span<const std::uint8_t> buffer,
+                      std::uint16_t address);
+  /// Lets reader fill size bytes at address in place, e.g. straight from a
+  /// file. Fails when they do not fit in program memory or reader fails.
+  template <typename Reader>
+  bool LoadInPlace(std::uint16_t address, std::size_t size, Reader &&reader) {
+    if (!Fits(address, size)) {
+      return false;
+    }
+    if (!reader(std::span<std::uint8_t>(&mMemoryBuffer[address], size))) {
+      return false;
+    }
+    MarkDirty(address, size);
+    UpdateMirror();
+    return true;
+  }
   void Dump(std::ostream &os);
 
+  // Unchecked accessors for executing instructions. Addresses wrap at 4 KiB.
+  std::uint8_t Load(std::uint16_t address) const {
+    return mMemoryBuffer[address & address_mask];
+  }
+  /// Big endian instruction word at address.
+  std::uint16_t Fetch(std::uint16_t address) const {
+    const auto *bytes = &mMemoryBuffer[address & address_mask];
+    return static_cast<std::uint16_t>(bytes[0] << 8 | bytes[1]);
+  }
+  void Store(std::uint16_t address, std::uint8_t value) {
+    address &= address_mask;
+    mMemoryBuffer[address] = value;
+    // Keep the mirrored copy of the first bytes in step without branching,
+    // for most addresses this rewrites an unchanged byte.
+    const auto mirrored = address % mirror_size;
+    mMemoryBuffer[memory_size + mirrored] = mMemoryBuffer[mirrored];
+    MarkWritten(address);
+  }
+  /// Contiguous view of size bytes, size may be at most mirror_size.
+  std::span<const std::uint8_t> View(std::uint16_t address,
+                                     std::uint8_t size) const {
+    return {&mMemoryBuffer[address & address_mask], size};
+  }
+
   void PushStack(std::uint16_t value, std::uint8_t stackPointer);
   std::uint16_t PopStack(std::uint8_t stackPointer);
 
   bool LoadSprite(std::uint16_t address, Output::Sprites::Sprite sprite);
-  std::vector<std::uint8_t> ReadSprite(std::uint16_t address,
-                                       std::uint8_t size);
+  std::span<const std::uint8_t> ReadSprite(std::uint16_t address,
+                                           std::uint8_t size) const {
+    return View(address, size);
+  }
+
+  MemorySnapshot TakeSnapshot();
+  void RestoreSnapshot(const MemorySnapshot &snapshot);
+
+  /// Pages written since the last TakeDirtyPages, by any means, bit n for
+  /// page n. Kept apart from what snapshots track, so taking them does not
+  /// change what the next snapshot copies.
+  std::uint16_t GetDirtyPages() const { return mWrittenPages; }
+  /// The dirty pages, and clears them.
+  std::uint16_t TakeDirtyPages() { return std::exchange(mWrittenPages, 0); }
+  bool HasWrittenLines() const { return mWrittenLines != LineMask{}; }
+  /// The lines written since the last call, by any means.
+  LineMask TakeWrittenLines() {
+    const auto written = mWrittenLines;
+    mWrittenLines = {};
+    return written;
+  }
+  /// Reports writes to the watched lines to observer, nullptr for none. Only
+  /// one observer is registered at a time.
+  void SetWriteObserver(WriteObserver *observer) { mObserver = observer; }
+  void SetWatchedLines(const LineMask &lines) { mWatchedLines = lines; }
 
 private:
-  std::vector<std::uint8_t> mMemoryBuffer;
-  std::vector<std::uint16_t> mStack;
+  void MarkWritten(std::uint16_t address) {
+    const auto page = static_cast<std::uint16_t>(1U << (address / page_size));
+    mDirtyPages |= page;
+    mWrittenPages |= page;
+    const auto line = address / line_size;
+    const auto bit = 1ULL << (line % 64);
+    mWrittenLines[line / 64] |= bit;
+    if ((mWatchedLines[line / 64] & bit) && mObserver != nullptr) {
+      mObserver->OnWatchedLineWritten(line);
+    }
+  }
+  void MarkDirty(std::uint16_t address, std::size_t size = 1) {
+    for (auto line = address / line_size;
+         line <= (address + size - 1) / line_size && line < line_count;
+         ++line) {
+      MarkWritten(static_cast<std::uint16_t>(line * line_size));
+    }
+  }
+  void UpdateMirror();
+  bool Fits(std::uint16_t address, std::size_t size) const {
+    return IsValidAddress(address) && address + size <= memory_size;
+  }
+
+  alignas(util::cache_line_size)
+      std::array<std::uint8_t, memory_size + mirror_size> mMemoryBuffer;
+  std::array<std::uint16_t, stack_size> mStack;
+  // The pages as of the last snapshot or restore, and which pages have been
+  // written since.
+  std::array<std::shared_ptr<const Page>, page_count> mPages;
+  std::uint16_t mDirtyPages;
+  // Pages written since the last TakeDirtyPages.
+  std::uint16_t mWrittenPages;
+  LineMask mWrittenLines;
+  // Lines whose writes are reported to mObserver.
+  LineMask mWatchedLines;
+  WriteObserver *mObserver;
 };
 
 } // namespace cpu
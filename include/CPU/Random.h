@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace cpu {
+
+/// Seed of every machine that is not seeded explicitly, so runs are
+/// reproducible by default.
+constexpr std::uint64_t default_seed = 0xC8C8C8C8;
+
+/// xoshiro128** by Blackman and Vigna. Part of the machine state, so every
+/// machine draws its own sequence and snapshots restore it.
+class Random {
+public:
+  explicit Random(std::uint64_t seed = default_seed) { Seed(seed); }
+
+  /// Expands seed into the state with splitmix64, as the authors recommend,
+  /// so similar seeds still give unrelated sequences.
+  void Seed(std::uint64_t seed) {
+    for (std::size_t i = 0; i < mState.size(); i += 2) {
+      seed += 0x9E3779B97F4A7C15ULL;
+      auto z = seed;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      z ^= z >> 31;
+      mState[i] = static_cast<std::uint32_t>(z);
+      mState[i + 1] = static_cast<std::uint32_t>(z >> 32);
+    }
+  }
+
+  std::uint32_t Next() {
+    return Next(mState[0], mState[1], mState[2], mState[3]);
+  }
+  /// One step on a state kept elsewhere, e.g. spread over arrays.
+  static std::uint32_t Next(std::uint32_t &s0, std::uint32_t &s1,
+                            std::uint32_t &s2, std::uint32_t &s3) {
+    const auto result = std::rotl(s1 * 5, 7) * 9;
+    const auto t = s1 << 9;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = std::rotl(s3, 11);
+    return result;
+  }
+  static std::uint8_t ToByte(std::uint32_t value) {
+    return static_cast<std::uint8_t>(value >> 24);
+  }
+  /// The high bits, which are the best of the output.
+  std::uint8_t NextByte() { return ToByte(Next()); }
+
+  const std::array<std::uint32_t, 4> &GetState() const { return mState; }
+  void SetState(const std::array<std::uint32_t, 4> &state) { mState = state; }
+
+  bool operator==(const Random &other) const = default;
+
+private:
+  std::array<std::uint32_t, 4> mState;
+};
+
+} // namespace cpu
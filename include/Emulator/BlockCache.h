@@ -0,0 +1,125 @@
+#pragma once
+
+#include "IdleLoop.h"
+#include "Jit.h"
+#include <CPU/CpuState.h>
+#include <CPU/Memory.h>
+#include <Instructions/Semantics.h>
+#include <Instructions/ThreadedCode.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace emulator {
+
+/// Longest block compiled, longer straight line code is split.
+constexpr std::size_t max_block_instructions = 64;
+
+/// A straight line run of instructions compiled to threaded code. It ends
+/// with the first jump, call, return, skip, key wait or store to memory, or
+/// right before the first instruction that cannot be compiled.
+struct Block {
+  std::uint16_t start;
+  // One past the last byte of the block.
+  std::uint16_t end;
+  std::vector<Instructions::CompiledInstruction> code;
+  // Set when the block ends with a skip and the next instruction is a jump,
+  // the native code runs the pair as one conditional branch.
+  bool skipJump = false;
+  std::uint16_t skipJumpTarget = 0;
+  // Set when the block, with the folded jump, is an idle loop.
+  IdleLoop idle;
+  // The block that followed the last time this one ran, so loops go from
+  // block to block without a lookup.
+  std::uint16_t successorPc = 0;
+  Block *successor = nullptr;
+  // Threaded runs so far, counted up to jit::hot_threshold.
+  std::uint32_t runs = 0;
+  std::unique_ptr<jit::NativeBlock> native;
+
+  /// One past the last byte the block depends on, including a folded jump.
+  std::uint16_t GetCodeEnd() const {
+    return skipJump ? end + Instructions::instruction_size : end;
+  }
+
+  /// Whether the call or return ending the block can run. Only those touch
+  /// the stack and they end blocks, so the stack at the start decides.
+  bool FitsStack(const cpu::CpuState &state) const {
+    return Instructions::Semantics::FitsStack(state,
+                                              code.back().operands.opcode);
+  }
+
+  /// Runs at most budget instructions from the start of the block and
+  /// returns how many ran.
+  std::uint64_t Run(cpu::CpuState &state, std::uint64_t budget) const {
+    const auto count = budget < code.size() ? budget : code.size();
+    for (std::size_t i = 0; i < count; ++i) {
+      code[i].handler(state, code[i].operands);
+      state.registers.PC += 2;
+    }
+    return count;
+  }
+};
+
+/// Compiles blocks on first use and keeps them until memory they were
+/// compiled from is written. Registered as the memory's WriteObserver it
+/// learns about such writes as they happen, see InvalidateStale.
+class BlockCache : public cpu::WriteObserver {
+public:
+  BlockCache();
+  ~BlockCache() override;
+  BlockCache(const BlockCache &) = delete;
+  BlockCache &operator=(const BlockCache &) = delete;
+
+  /// The block starting at pc, compiled now if needed. Returns nullptr when
+  /// the instruction at pc cannot be compiled. Has memory watch the lines
+  /// holding compiled code.
+  Block *Get(std::uint16_t pc, cpu::Memory &memory);
+  /// Like Get, but follows the chain from the block that ran before.
+  Block *Next(Block *previous, std::uint16_t pc, cpu::Memory &memory) {
+    if (previous != nullptr && previous->successorPc == pc &&
+        previous->successor != nullptr) {
+      return previous->successor;
+    }
+    auto *block = Get(pc, memory);
+    if (previous != nullptr) {
+      previous->successorPc = pc;
+      previous->successor = block;
+    }
+    return block;
+  }
+  /// Drops every block overlapping a written line, returns whether any was.
+  bool Invalidate(const cpu::LineMask &written);
+  /// Whether code was written since the last InvalidateStale.
+  bool HasStaleBlocks() const { return mStale; }
+  /// Drops the blocks overlapping watched lines written since the last call.
+  bool InvalidateStale() {
+    mStale = false;
+    return Invalidate(std::exchange(mStaleLines, {}));
+  }
+  void OnWatchedLineWritten(std::size_t line) override {
+    mStaleLines[line / 64] |= 1ULL << (line % 64);
+    mStale = true;
+  }
+  void Clear();
+  std::size_t GetBlockCount() const { return mBlockCount; }
+
+private:
+  Block *Compile(std::uint16_t pc, const cpu::Memory &memory) const;
+  void Remove(Block *block);
+  void Unchain();
+
+  // Blocks by start address.
+  std::vector<Block *> mBlocks;
+  // Start addresses of the blocks overlapping each line.
+  std::vector<std::vector<std::uint16_t>> mLineBlocks;
+  cpu::LineMask mCodeLines;
+  // Watched lines written since the last InvalidateStale.
+  cpu::LineMask mStaleLines;
+  bool mStale;
+  std::size_t mBlockCount;
+};
+
+} // namespace emulator
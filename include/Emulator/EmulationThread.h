@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Emulator.h"
+#include "Scheduler.h"
+#include <Input/KeyManager.h>
+#include <Output/Display.h>
+#include <Util/Event.h>
+#include <Util/SpscRing.h>
+#include <Util/TripleBuffer.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stop_token>
+#include <thread>
+
+namespace emulator {
+
+/// What the emulation thread publishes after every emulated frame.
+struct Frame {
+  std::array<Output::Row, Output::display_height> screen{};
+  std::size_t width = Output::lowres_display_width;
+  std::size_t height = Output::lowres_display_height;
+  // Rows changed since the frame published before, every row after a load or
+  // reset. A frontend that skipped frames has to redraw every row.
+  Output::RowMask damage = 0;
+  // Counts published frames from 1, a gap means frames were skipped.
+  std::uint64_t number = 0;
+  // Instructions executed since the game was loaded.
+  std::uint64_t instructions = 0;
+  bool sound = false;
+  bool paused = false;
+  // Multiple of real time the machine runs at, 0 when uncapped.
+  double speed = 1;
+  // Stopped at LD Vx, K, when paced the thread sleeps until a key is pressed.
+  bool waitingForKey = false;
+};
+
+enum class CommandType : std::uint8_t {
+  Pause,
+  Resume,
+  TogglePause,
+  // Executes one instruction and pauses.
+  Step,
+  // Loads the current game again. Load and Reset keep the machine paused
+  // when it was.
+  Reset,
+  Load,
+  // Runs at speed times real time, or as fast as possible for 0. Faster
+  // than real time only frames the frontend takes are published.
+  SetSpeed,
+};
+
+struct Command {
+  CommandType type = CommandType::Pause;
+  // The game to load, only used by Load.
+  std::filesystem::path path;
+  // Only used by SetSpeed.
+  double speed = 1;
+};
+
+/// Runs an Emulator on its own thread for an interactive frontend. Commands
+/// reach the thread through a lock free queue and finished frames come back
+/// through a triple buffer, so the frontend never blocks emulation, e.g. on
+/// vsync, and emulation never blocks the frontend. The thread paces itself and
+/// publishes every frame before waiting for the next deadline, so a frame is
+/// never held back a frame period. In turbo, faster than real time, it only
+/// publishes once the frontend took the frame before, so a frontend showing
+/// frames at vsync never converts skipped ones. Paused, or paced and waiting
+/// for a key, the thread sleeps until a command or key press wakes it.
+class EmulationThread {
+public:
+  explicit EmulationThread(Pacing pacing = Pacing::RealTime);
+  /// Stops and joins the thread.
+  ~EmulationThread();
+  EmulationThread(const EmulationThread &) = delete;
+  EmulationThread &operator=(const EmulationThread &) = delete;
+
+  /// Frontend thread only. Returns false when the queue is full.
+  bool Send(const Command &command) {
+    if (!mCommands.TryPush(command)) {
+      return false;
+    }
+    mWake.Notify();
+    return true;
+  }
+  /// Frontend thread only. Takes the newest frame when one was published
+  /// since the last call, returns whether there was one.
+  bool UpdateFrame() { return mFrames.Update(); }
+  /// Frontend thread only. The frame taken by the last UpdateFrame.
+  const Frame &GetFrame() const { return mFrames.GetFront(); }
+  /// Any thread. Keys reach the machine at the start of the next frame,
+  /// they are not commands and never wait in the queue. A machine waiting
+  /// for a key gets the press straight away.
+  void PressKey(input::KEY key) {
+    mKeys.PressKey(key);
+    mWake.Notify();
+  }
+  void ReleaseKey(input::KEY key) { mKeys.ReleaseKey(key); }
+
+private:
+  void Run(std::stop_token stop);
+  void Execute(const Command &command);
+  void Load(const std::filesystem::path &path);
+  void SetPaused(bool paused);
+  void SetSpeed(double speed);
+  void Park();
+  void Publish();
+
+  // Room for far more commands than a user issues in a frame.
+  util::SpscRing<Command, 64> mCommands;
+  util::TripleBuffer<Frame> mFrames;
+  input::KeyManager mKeys;
+  // Notified by every command and key press, and when stopping.
+  util::Event mWake;
+
+  // Only used by the thread.
+  std::unique_ptr<Emulator> mEmulator;
+  std::filesystem::path mPath;
+  // Ends a frame on every Advance, the emulator itself runs unthrottled.
+  Scheduler mPacer;
+  Pacing mPacing;
+  std::uint64_t mFrameNumber;
+  bool mPaused;
+  bool mFullDamage;
+  // Faster than real time, frames the frontend cannot show are not
+  // published. mUnpublished says the last frame was skipped.
+  bool mTurbo;
+  bool mUnpublished;
+
+  // Last, so it starts after and stops before everything else.
+  std::jthread mThread;
+};
+
+} // namespace emulator
@@ -1,30 +1,137 @@
 #pragma once
 
+#include "BlockCache.h"
+#include "IdleLoop.h"
+#include "InstructionCache.h"
+#include "Jit.h"
+#include "Scheduler.h"
+#include "Trace.h"
 #include <CPU/CpuState.h>
+#include <Input/KeyManager.h>
 #include <Instructions/Instruction.h>
+#include <Util/CacheLine.h>
 
+#include <cstdint>
 #include <filesystem>
-#include <vector>
+#include <functional>
+#include <memory>
 
 namespace emulator {
 
-class Emulator {
+/// The execution engines the emulator can step with, both share the
+/// semantics in Instructions/Semantics.h.
+enum class Engine {
+  // Cached Instruction objects executed through their virtual Execute.
+  Instructions,
+  // Plain decoded instructions dispatched by the Interpreter switch.
+  Interpreter,
+  // Basic blocks compiled to threaded code, chained to their successors.
+  // Steps one instruction at a time through the Interpreter when tracing.
+  // Hot blocks are compiled to native code when the JIT is enabled.
+  Threaded,
+};
+
+/// The complete machine state at one point in time. Memory pages are shared
+/// between snapshots, so keeping many of them only costs the changed pages.
+struct Snapshot {
+  cpu::Registers registers;
+  cpu::MemorySnapshot memory;
+  Output::Display display;
+  VirtualClock clock;
+  cpu::Random random;
+  // The keypad as latched, and the presses LD Vx, K has yet to take.
+  input::KeyMask keys = 0;
+  input::KeyMask pressedKeys = 0;
+};
+
+// Aligned so instances running on different threads never share a line.
+class alignas(util::cache_line_size) Emulator {
 public:
   Emulator();
   ~Emulator();
 
   bool LoadGame(const std::filesystem::path path);
-  void Run(bool dumpState = false);
+  /// Runs frame after frame until an instruction cannot execute. beforeFrame,
+  /// when set, is called at the start of every frame, e.g. to change the
+  /// speed through the scheduler.
+  void Run(const std::function<void(Emulator &)> &beforeFrame = {});
+  std::uint64_t RunFor(std::uint64_t instructions);
+  bool Step();
   void DumpState(std::ostream &os);
+  const cpu::CpuState &GetState() const { return mState; }
+  /// Rows of the screen changed since the last call, see
+  /// Output::Display::AcknowledgeDamage.
+  Output::RowMask AcknowledgeDamage() {
+    return mState.display.AcknowledgeDamage();
+  }
+  Snapshot TakeSnapshot();
+  void RestoreSnapshot(const Snapshot &snapshot);
+  /// Restarts the sequence RND draws from, machines with the same seed draw
+  /// the same numbers.
+  void SetSeed(std::uint64_t seed) { mState.random.Seed(seed); }
+  /// Latches the keys from keys at the start of every frame, e.g. pressed by
+  /// a frontend on another thread. Instructions only ever see the latched
+  /// keys, so a frame runs the same however its keys were pressed.
+  void SetKeyManager(input::KeyManager *keys) { mKeys = keys; }
+  /// Latches the keys now instead of at the start of the next frame, e.g.
+  /// when a key woke up a frontend waiting for one.
+  void LatchKeys();
+  /// Holds down exactly the keys in mask until the next latch, or for good
+  /// without a key manager. Keys not held before count as pressed.
+  void SetKeys(input::KeyMask mask) {
+    mState.pressedKeys |= mask & ~mState.keys;
+    mState.keys = mask;
+  }
+  /// Whether the machine stopped at LD Vx, K without a press to take. Until
+  /// the next latch running only lets time pass, frame by frame at once.
+  bool IsWaitingForKey() const;
+  /// Lets whole frames pass while waiting for a key, exactly like running
+  /// them would but without latching keys in between, e.g. the frames a
+  /// frontend slept through. Only at a frame boundary.
+  void PassFrames(std::uint64_t frames);
+  void SetEngine(Engine engine) { mEngine = engine; }
+  Engine GetEngine() const { return mEngine; }
+  /// Lets the Threaded engine compile hot blocks to native code, on by
+  /// default where jit::IsSupported.
+  void SetJitEnabled(bool enabled) { mJitEnabled = enabled; }
+  bool IsJitEnabled() const { return mJitEnabled; }
+  /// Records every executed instruction to path until StopTrace.
+  bool StartTrace(const std::filesystem::path &path,
+                  TraceFormat format = TraceFormat::Binary);
+  void StopTrace();
+  void SetTraceLevel(TraceLevel level);
+  TraceLevel GetTraceLevel() const { return mTraceLevel; }
+  const Tracer *GetTracer() const { return mTracer.get(); }
+  /// Prints what was loaded, off by default.
+  void SetVerbose(bool verbose) { mVerbose = verbose; }
+  Scheduler &GetScheduler() { return mScheduler; }
+  const Scheduler &GetScheduler() const { return mScheduler; }
 
 private:
   Instructions::Instruction *GetNextInstruction();
+  bool Execute();
+  bool ExecuteTraced();
+  std::uint64_t RunBlocks(std::uint64_t instructions);
+  std::uint64_t RunBlock(Block &block, std::uint64_t budget);
+  std::uint64_t SkipWait(std::uint64_t budget);
+  std::uint64_t SkipIdleLoop(const IdleLoop &loop, std::uint64_t budget);
+  void PassInstructions(std::uint64_t instructions);
   void ExecuteInstruction(Instructions::Instruction *instruction);
+  bool InterpretInstruction();
   bool LoadSprites();
+  void EndFrame();
 
-  std::vector<Instructions::Instruction *> mInstructions;
+  InstructionCache mInstructions;
+  BlockCache mBlocks;
   cpu::CpuState mState;
+  Scheduler mScheduler;
+  Engine mEngine;
+  std::unique_ptr<Tracer> mTracer;
+  TraceLevel mTraceLevel;
+  input::KeyManager *mKeys;
+  bool mJitEnabled;
   bool mRunning;
+  bool mVerbose;
 };
 
 } // namespace emulator
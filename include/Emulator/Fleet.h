@@ -0,0 +1,188 @@
+#pragma once
+
+#include "Emulator.h"
+#include "Scheduler.h"
+#include <CPU/CpuState.h>
+#include <CPU/Memory.h>
+#include <CPU/Random.h>
+#include <Input/Keys.h>
+#include <Instructions/Decoder.h>
+#include <Output/Display.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace emulator {
+
+/// Machines a Fleet steps together before moving on to the next ones, few
+/// enough that their registers stay in the first level cache.
+constexpr std::size_t fleet_batch_size = 256;
+
+/// Many machines running the same program, e.g. for reinforcement learning
+/// rollouts. The state is kept as structure of arrays: the PCs of all
+/// machines together, every V register of all machines together and all
+/// memories in one slab, backed by huge pages where the host has them.
+/// Machines are stepped in lockstep a batch at a time. Every step groups the
+/// running machines by the instruction they are about to execute and applies
+/// it to the whole group at once, so while the machines of a batch agree
+/// their registers are updated as vectors.
+/// Executes with the semantics of the Interpreter engine and shares one
+/// virtual clock between all machines.
+class Fleet {
+public:
+  explicit Fleet(std::size_t size);
+  ~Fleet();
+  Fleet(const Fleet &) = delete;
+  Fleet &operator=(const Fleet &) = delete;
+
+  /// Loads the game into every machine, as Emulator::LoadGame does.
+  bool LoadGame(const std::filesystem::path &path);
+  /// Sets every machine and the clock to snapshot.
+  void Reset(const Snapshot &snapshot);
+  /// Sets one machine to snapshot, all but the clock, e.g. to start the
+  /// machines from different positions.
+  void Restore(std::size_t machine, const Snapshot &snapshot);
+  /// Restarts the sequence RND draws from on machine, restored machines
+  /// otherwise all draw the sequence of the snapshot.
+  void Seed(std::size_t machine, std::uint64_t seed);
+  /// Holds down exactly the keys in mask on machine, e.g. the action an
+  /// agent picked, until set again. Keys not held before count as pressed
+  /// until LD Vx, K takes them. Snapshots do not hold keys, restoring keeps
+  /// them.
+  void SetKeys(std::size_t machine, input::KeyMask mask) {
+    mPressedKeys[machine] |= mask & ~mKeys[machine];
+    mKeys[machine] = mask;
+  }
+  input::KeyMask GetKeys(std::size_t machine) const { return mKeys[machine]; }
+  /// Steps every running machine up to instructions times. A machine halts
+  /// on an instruction it cannot execute, like RunFor stopping early, and
+  /// stays halted until restored. Returns the instructions executed by all
+  /// machines together.
+  std::uint64_t RunFor(std::uint64_t instructions);
+
+  std::size_t GetSize() const { return mSize; }
+  std::size_t GetRunningCount() const;
+  bool IsHalted(std::size_t machine) const { return mHalted[machine] != 0; }
+  /// Instructions on the clock of machine, which stops when it halts.
+  std::uint64_t GetInstructions(std::size_t machine) const;
+  cpu::Registers GetRegisters(std::size_t machine) const;
+  cpu::Random GetRandom(std::size_t machine) const;
+  std::uint8_t Load(std::size_t machine, std::uint16_t address) const {
+    return GetMemory(machine)[address & cpu::address_mask];
+  }
+  const Output::Display &GetDisplay(std::size_t machine) const {
+    return mDisplays[machine];
+  }
+  Scheduler &GetScheduler() { return mScheduler; }
+  const Scheduler &GetScheduler() const { return mScheduler; }
+
+private:
+  struct Range {
+    std::uint32_t begin;
+    std::uint32_t end;
+  };
+  struct Group {
+    std::uint16_t word;
+    std::uint32_t begin;
+    std::uint32_t count;
+  };
+
+  template <typename Body> static void ForEach(Range machines, Body &&body);
+  template <typename Body>
+  static void ForEach(std::span<const std::uint32_t> machines, Body &&body);
+  std::uint64_t RunBatch(Range batch, std::uint64_t instructions,
+                         Scheduler &scheduler);
+  bool Step(Range batch, std::uint64_t clock);
+  template <typename Machines>
+  bool Execute(const Instructions::DecodedInstruction &instruction,
+               const Machines &machines);
+  template <typename Machines> void TickTimers(const Machines &machines);
+  void Halt(std::uint32_t machine, std::uint64_t clock);
+  /// Whether the machine can run a call or return with its stack as it is,
+  /// like Semantics::FitsStack. A machine that cannot halts on it.
+  bool FitsStack(std::uint32_t machine, Instructions::Opcode opcode) const {
+    const auto sp = mSP[machine];
+    switch (opcode) {
+    case Instructions::Opcode::CALL:
+      return sp + 1U < cpu::stack_size;
+    case Instructions::Opcode::RET:
+      return sp > 0 && sp < cpu::stack_size;
+    default:
+      return true;
+    }
+  }
+
+  std::uint8_t *GetMemory(std::size_t machine) {
+    return mMemory + machine * memory_stride;
+  }
+  const std::uint8_t *GetMemory(std::size_t machine) const {
+    return mMemory + machine * memory_stride;
+  }
+  std::uint8_t *V(std::uint8_t index) {
+    return &mV[(index & 0xF) * mSize];
+  }
+  /// Whether no machine wrote to the word at address since the reset, so it
+  /// can be fetched from the shared image.
+  bool IsShared(std::uint16_t address) const {
+    return !IsWritten(address / cpu::line_size) &&
+           !IsWritten((address + 1) / cpu::line_size);
+  }
+  bool IsWritten(std::size_t line) const {
+    return (mWrittenLines[line / 64] >> (line % 64)) & 1;
+  }
+  std::uint16_t Fetch(std::uint32_t machine, std::uint16_t address) const {
+    const auto *bytes = IsShared(address) ? mImage.data() : GetMemory(machine);
+    return static_cast<std::uint16_t>(bytes[address] << 8 | bytes[address + 1]);
+  }
+  void Store(std::uint32_t machine, std::uint16_t address,
+             std::uint8_t value) {
+    address &= cpu::address_mask;
+    GetMemory(machine)[address] = value;
+    const auto line = address / cpu::line_size;
+    mWrittenLines[line / 64] |= 1ULL << (line % 64);
+  }
+
+  // Memories are a cache line further apart than their size, so the same
+  // address in neighbouring machines does not map to the same cache set.
+  static constexpr std::size_t memory_stride =
+      cpu::memory_size + util::cache_line_size;
+
+  std::size_t mSize;
+  // Every register of all machines together, V is indexed by register
+  // times mSize plus machine and the stack by level times mSize plus machine.
+  std::vector<std::uint8_t> mV;
+  std::vector<std::uint16_t> mI;
+  std::vector<std::uint16_t> mPC;
+  std::vector<std::uint8_t> mDelay;
+  std::vector<std::uint8_t> mSound;
+  std::vector<std::uint8_t> mSP;
+  std::vector<std::uint16_t> mStack;
+  // The four words of the RND state, indexed by word times mSize plus
+  // machine.
+  std::vector<std::uint32_t> mRandom;
+  std::vector<input::KeyMask> mKeys;
+  std::vector<input::KeyMask> mPressedKeys;
+  std::vector<Output::Display> mDisplays;
+  std::vector<std::uint8_t> mHalted;
+  std::vector<std::uint64_t> mHaltedAt;
+  std::uint8_t *mMemory;
+  std::size_t mMemoryBytes;
+  // The memory every machine was reset to and the lines any machine wrote
+  // to since. Instructions in unwritten lines are fetched from the image.
+  std::array<std::uint8_t, cpu::memory_size> mImage;
+  cpu::LineMask mWrittenLines;
+  Scheduler mScheduler;
+
+  // Scratch space for grouping the machines of a batch by instruction.
+  std::vector<std::uint32_t> mRunning;
+  std::vector<std::uint16_t> mWords;
+  std::vector<std::uint32_t> mGrouped;
+  std::vector<Group> mGroups;
+  std::vector<std::uint16_t> mGroupOf;
+};
+
+} // namespace emulator
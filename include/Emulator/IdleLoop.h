@@ -0,0 +1,34 @@
+#pragma once
+
+#include <CPU/CpuState.h>
+#include <CPU/Memory.h>
+#include <Instructions/Decoder.h>
+
+#include <cstdint>
+
+namespace emulator {
+
+/// A loop that only burns time: a jump to itself, or a poll of the delay
+/// timer like
+///   loop: LD Vx, VDelay
+///         SE Vx, 0
+///         JP loop
+/// Within a frame every pass repeats the one before, so how long it runs
+/// follows from the delay timer alone and it can be skipped instead of run.
+struct IdleLoop {
+  // Instructions in one pass, 0 when the code is no idle loop.
+  std::uint8_t length = 0;
+  // Whether a pass starts by reading the delay timer into register x.
+  bool readsDelay = false;
+  std::uint8_t x = 0;
+  // The skip leaving the loop when it passes, only with readsDelay.
+  Instructions::DecodedInstruction test{};
+
+  /// Whether a pass reading delay from the timer leaves the loop.
+  bool Leaves(const cpu::Registers &registers, std::uint8_t delay) const;
+};
+
+/// Recognises an idle loop starting at pc, length is 0 when there is none.
+IdleLoop FindIdleLoop(std::uint16_t pc, const cpu::Memory &memory);
+
+} // namespace emulator
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Instructions/Instruction.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace emulator {
+
+/// Keeps one decoded instruction per address so the emulator only decodes an
+/// instruction the first time it is executed. An entry is decoded again when
+/// the word in memory no longer matches the word it was decoded from.
+class InstructionCache {
+public:
+  InstructionCache();
+  ~InstructionCache();
+  InstructionCache(const InstructionCache &) = delete;
+  InstructionCache &operator=(const InstructionCache &) = delete;
+
+  Instructions::Instruction *Get(std::uint16_t address, std::uint16_t data);
+  void Clear();
+
+private:
+  std::vector<Instructions::Instruction *> mInstructions;
+};
+
+} // namespace emulator
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <CPU/CpuState.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace emulator {
+
+struct Block;
+
+namespace jit {
+
+/// Blocks run this many times as threaded code before they are compiled.
+constexpr std::uint32_t hot_threshold = 16;
+/// Most guest registers a block may use, each one lives in a host register
+/// while the block runs.
+constexpr std::size_t max_block_registers = 10;
+
+/// Whether native code can be generated for this host, x86-64 Linux only.
+bool IsSupported();
+
+/// Machine code for one block in executable memory.
+class NativeBlock {
+public:
+  using Entry = std::uint32_t (*)(cpu::Registers *registers,
+                                  cpu::CpuState *state);
+
+  NativeBlock(void *code, std::size_t size, std::uint32_t maxInstructions);
+  ~NativeBlock();
+  NativeBlock(const NativeBlock &) = delete;
+  NativeBlock &operator=(const NativeBlock &) = delete;
+
+  /// Runs the whole block and returns how many instructions it executed.
+  std::uint32_t Run(cpu::CpuState &state) const {
+    return mEntry(&state.registers, &state);
+  }
+  /// Most instructions one run executes, the caller must allow at least as
+  /// many before the next frame.
+  std::uint32_t GetMaxInstructions() const { return mMaxInstructions; }
+  std::size_t GetSize() const { return mSize; }
+
+private:
+  void *mCode;
+  std::size_t mSize;
+  Entry mEntry;
+  std::uint32_t mMaxInstructions;
+};
+
+/// Compiles block to native code. Arithmetic, loads of constants, skips and
+/// jumps are translated, everything else calls the block's threaded
+/// handlers. Returns nullptr when the host is not supported or the block
+/// uses too many registers.
+std::unique_ptr<NativeBlock> Compile(const Block &block);
+
+} // namespace jit
+} // namespace emulator
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+
+namespace emulator {
+
+/// Instructions executed per 60Hz frame, used to express budgets in frames.
+constexpr std::uint64_t instructions_per_frame = 10;
+/// The delay and sound timers count down at this rate.
+constexpr std::uint64_t timer_frequency = 60;
+/// Real time between two frames when paced.
+constexpr std::chrono::nanoseconds frame_duration =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::seconds(1)) /
+    timer_frequency;
+
+enum class Pacing {
+  // Time only advances with executed instructions, runs as fast as the host
+  // allows and is reproducible.
+  Unthrottled,
+  // Sleeps at every frame boundary until the frame is due in real time, or
+  // a multiple of it, see Scheduler::SetSpeed.
+  RealTime,
+};
+
+/// Position of the virtual clock, kept in snapshots so a restored machine
+/// reaches its next frame boundary after the same instruction.
+struct VirtualClock {
+  std::uint64_t instructions = 0;
+  std::uint64_t frames = 0;
+  std::uint64_t frameInstructions = 0;
+};
+
+/// Derives time from the number of executed instructions. Every
+/// instructions-per-frame instructions a frame ends, at which point the 60Hz
+/// timers tick and, when paced, the scheduler waits for the frame's deadline.
+class Scheduler {
+public:
+  explicit Scheduler(
+      std::uint64_t instructionsPerFrame = instructions_per_frame,
+      Pacing pacing = Pacing::Unthrottled);
+
+  /// Counts one executed instruction, returns true when it ended a frame.
+  bool Advance() { return Advance(1); }
+  /// Counts instructions executed at once, which must not run past the end
+  /// of the frame. Returns true when they ended it.
+  bool Advance(std::uint64_t instructions) {
+    assert(instructions <= InstructionsUntilFrame() &&
+           "Cannot advance past the end of the frame");
+    mClock.instructions += instructions;
+    mClock.frameInstructions += instructions;
+    if (mClock.frameInstructions < mInstructionsPerFrame) {
+      return false;
+    }
+    mClock.frameInstructions = 0;
+    ++mClock.frames;
+    return true;
+  }
+  /// Counts whole frames that passed without executing anything, as if
+  /// their instructions had run. Only at a frame boundary.
+  void SkipFrames(std::uint64_t frames) {
+    assert(mClock.frameInstructions == 0 &&
+           "Can only skip frames at a frame boundary");
+    mClock.instructions += frames * mInstructionsPerFrame;
+    mClock.frames += frames;
+  }
+  /// Blocks until the current frame is due, returns immediately when
+  /// unthrottled or running late.
+  void WaitForFrame();
+
+  std::uint64_t InstructionsUntilFrame() const {
+    return mInstructionsPerFrame - mClock.frameInstructions;
+  }
+
+  void SetInstructionsPerFrame(std::uint64_t instructionsPerFrame);
+  std::uint64_t GetInstructionsPerFrame() const {
+    return mInstructionsPerFrame;
+  }
+  void SetPacing(Pacing pacing);
+  Pacing GetPacing() const { return mPacing; }
+  /// Runs paced frames at speed times real time, e.g. 4 for a 240Hz frame
+  /// rate. Must be positive, unthrottled pacing runs as fast as possible.
+  void SetSpeed(double speed);
+  double GetSpeed() const { return mSpeed; }
+  /// Real time between two paced frames at the current speed.
+  std::chrono::nanoseconds GetFrameDuration() const { return mFrameDuration; }
+
+  const VirtualClock &GetClock() const { return mClock; }
+  void SetClock(const VirtualClock &clock);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  // Restarts real time pacing from the current frame.
+  void Resynchronise();
+
+  std::uint64_t mInstructionsPerFrame;
+  Pacing mPacing;
+  double mSpeed;
+  std::chrono::nanoseconds mFrameDuration;
+  VirtualClock mClock;
+  // Real time at which frame mEpochFrame was due.
+  Clock::time_point mEpoch;
+  std::uint64_t mEpochFrame;
+};
+
+} // namespace emulator
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Util/Event.h>
+#include <Util/SpscRing.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <thread>
+
+namespace emulator {
+
+enum class TraceLevel {
+  // Nothing is recorded, the emulator does not even look at the tracer.
+  Off,
+  // One record per executed instruction.
+  Instructions,
+};
+
+enum class TraceFormat {
+  // Packed records, decode them with DecodeTrace.
+  Binary,
+  // One line of disassembly per record.
+  Text,
+};
+
+/// What one instruction did, in a fixed size so recording is a single copy.
+/// Binary traces store the fields without the padding, see ReadRecord.
+struct TraceRecord {
+  // Instructions executed before this one.
+  std::uint64_t cycle;
+  std::uint16_t pc;
+  std::uint16_t word;
+  // I after the instruction.
+  std::uint16_t i;
+  // Lowest general purpose register the instruction changed, other than VF,
+  // or no_register.
+  std::uint8_t changedRegister;
+  std::uint8_t changedValue;
+  // VF after the instruction.
+  std::uint8_t vf;
+};
+static_assert(sizeof(TraceRecord) == 24);
+
+constexpr std::uint8_t no_register = 0xFF;
+/// Start of every binary trace file, the records follow as their fields in
+/// declaration order, little endian and without padding.
+constexpr char trace_magic[8] = {'C', 'H', '8', 'T', 'R', 'A', 'C', 'E'};
+constexpr std::size_t trace_record_size = 17;
+
+void WriteText(const TraceRecord &record, std::ostream &os);
+void WriteBinary(const TraceRecord &record, std::ostream &os);
+/// Reads the next record of a binary trace, returns false at the end.
+bool ReadRecord(std::istream &is, TraceRecord &record);
+/// Turns a binary trace into text, returns false when it is not a trace.
+bool DecodeTrace(std::istream &is, std::ostream &os);
+
+/// Collects trace records from the emulator thread without locking or
+/// allocating, a background thread writes them out. The writer sleeps until
+/// woken for a batch of records, or to close. When it cannot keep up
+/// records are dropped and counted rather than stalling emulation.
+class Tracer {
+public:
+  static constexpr std::size_t ring_size = 1 << 14;
+  // Records recorded between waking the writer, a wake up per record would
+  // cost more than recording.
+  static constexpr std::size_t wake_batch = ring_size / 8;
+
+  Tracer() = default;
+  ~Tracer();
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+
+  bool Open(const std::filesystem::path &path, TraceFormat format);
+  /// Writes out everything recorded so far and stops the writer thread.
+  void Close();
+
+  void Record(const TraceRecord &record) {
+    if (!mRing->TryPush(record)) {
+      mDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (++mUnannounced == wake_batch) {
+      mUnannounced = 0;
+      mWake.Notify();
+    }
+  }
+  std::uint64_t GetDropped() const {
+    return mDropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  void Write(const TraceRecord &record);
+  void Drain(std::stop_token stop);
+
+  std::unique_ptr<util::SpscRing<TraceRecord, ring_size>> mRing;
+  std::ofstream mOutput;
+  TraceFormat mFormat = TraceFormat::Binary;
+  std::atomic<std::uint64_t> mDropped = 0;
+  // Only used by the recording thread.
+  std::size_t mUnannounced = 0;
+  util::Event mWake;
+  std::jthread mWriter;
+};
+
+} // namespace emulator
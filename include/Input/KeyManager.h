@@ -1,18 +1,52 @@
 #pragma once
 
-#include "KeyState.h"
-#include <unordered_map>
+#include "Keys.h"
+
+#include <atomic>
 
 namespace input {
+
+/// The keys as of one latch: held down at the time and the presses and
+/// releases since the latch before.
+struct KeyLatch {
+  KeyMask held = 0;
+  KeyMask pressed = 0;
+  KeyMask released = 0;
+
+  /// The keys a machine sees held for the frame. Includes keys pressed and
+  /// already released again, so taps shorter than a frame are not lost.
+  KeyMask GetDown() const { return held | pressed; }
+};
+
+/// The state of the keypad in one atomic mask, so a frontend's event thread
+/// can press keys while the emulation thread reads them without locks.
+/// Edges are collected separately until the emulation thread latches them
+/// once per frame.
 class KeyManager {
 public:
-  KeyManager();
+  /// Any thread.
+  void PressKey(KEY key) {
+    mHeld.fetch_or(ToMask(key), std::memory_order_relaxed);
+    mPressed.fetch_or(ToMask(key), std::memory_order_relaxed);
+  }
+  /// Any thread.
+  void ReleaseKey(KEY key) {
+    mHeld.fetch_and(static_cast<KeyMask>(~ToMask(key)),
+                    std::memory_order_relaxed);
+    mReleased.fetch_or(ToMask(key), std::memory_order_relaxed);
+  }
+  bool IsKeyPressed(KEY key) const { return (GetHeld() & ToMask(key)) != 0; }
+  KeyMask GetHeld() const { return mHeld.load(std::memory_order_relaxed); }
 
-  void PressKey(KEY key);
-  void ReleaseKey(KEY key);
-  bool IsKeyPressed(KEY key) const;
+  /// Takes the held keys and the edges since the last call, meant to be
+  /// called by one thread once per frame.
+  KeyLatch Latch();
 
 private:
-  std::unordered_map<KEY, KeyState> mKeysState;
+  std::atomic<KeyMask> mHeld{0};
+  // Edges since the last latch.
+  std::atomic<KeyMask> mPressed{0};
+  std::atomic<KeyMask> mReleased{0};
 };
+
 } // namespace input
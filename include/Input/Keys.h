@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 namespace input {
 
-enum class KEY {
-  KEY_1 = 0x1,
+enum class KEY : std::uint8_t {
+  KEY_0 = 0x0,
+  KEY_1,
   KEY_2,
   KEY_3,
   KEY_4,
@@ -20,4 +24,13 @@ enum class KEY {
   KEY_F
 };
 
+constexpr std::size_t key_count = 16;
+
+/// One bit per key, bit n for key n, the way SKP and SKNP test them.
+using KeyMask = std::uint16_t;
+
+constexpr KeyMask ToMask(KEY key) {
+  return static_cast<KeyMask>(1u << static_cast<std::uint8_t>(key));
+}
+
 } // namespace input
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <CPU/Memory.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Disassembler {
+
+/// How a basic block hands over control once its last instruction ran.
+enum class BlockExit : std::uint8_t {
+  // Continues at the successors, a call also continues after returning.
+  Successors,
+  // RET, continues wherever the function was called from.
+  Return,
+  // JP V0, the target depends on V0 and is not followed.
+  Indirect,
+  // An instruction the emulator cannot execute, or the end of the program.
+  Halt,
+};
+
+/// A straight line of instructions only ever entered at its start.
+struct BasicBlock {
+  std::uint16_t start;
+  // One past the last byte of the last instruction.
+  std::uint16_t end;
+  BlockExit exit = BlockExit::Successors;
+  // Where execution may continue, in no particular order. For a call this
+  // is the return address, the callee is in callTarget.
+  std::vector<std::uint16_t> successors;
+  // Set when the block ends with a CALL.
+  bool calls = false;
+  std::uint16_t callTarget = 0;
+};
+
+/// The entry point or the target of a CALL, with the blocks reachable from
+/// it without following calls.
+struct Function {
+  std::uint16_t entry;
+  // Starts of the blocks of the function, sorted.
+  std::vector<std::uint16_t> blocks;
+  // Entries of the functions it calls, sorted and unique.
+  std::vector<std::uint16_t> callees;
+};
+
+/// Code recovered by following every jump, call, return and skip from the
+/// entry point. Bytes never reached are data, e.g. sprites. Instructions
+/// may start at odd addresses when a jump leads there.
+class ControlFlowGraph {
+public:
+  /// Analyses program as loaded at address load, starting at entry.
+  static ControlFlowGraph Analyse(std::span<const std::uint8_t> program,
+                                  std::uint16_t load = cpu::instruction_start,
+                                  std::uint16_t entry = cpu::instruction_start);
+
+  /// All blocks sorted by start address.
+  const std::vector<BasicBlock> &GetBlocks() const { return mBlocks; }
+  /// The block starting at address, nullptr when there is none.
+  const BasicBlock *FindBlock(std::uint16_t address) const;
+  /// The entry point first, then the called functions sorted by entry.
+  const std::vector<Function> &GetFunctions() const { return mFunctions; }
+  /// Addresses of the JP V0 instructions whose targets are unknown.
+  const std::vector<std::uint16_t> &GetIndirectJumps() const {
+    return mIndirectJumps;
+  }
+  /// Addresses LD I loads that lie inside the program, most likely sprites.
+  const std::vector<std::uint16_t> &GetDataReferences() const {
+    return mDataReferences;
+  }
+
+  /// Whether an instruction starts at address.
+  bool IsInstruction(std::uint16_t address) const {
+    return address < cpu::memory_size && mInstructions[address];
+  }
+  /// Whether address is part of any reachable instruction.
+  bool IsCode(std::uint16_t address) const {
+    return address < cpu::memory_size && mCode[address];
+  }
+  std::size_t GetInstructionCount() const { return mInstructionCount; }
+
+private:
+  ControlFlowGraph();
+
+  std::vector<BasicBlock> mBlocks;
+  std::vector<Function> mFunctions;
+  std::vector<std::uint16_t> mIndirectJumps;
+  std::vector<std::uint16_t> mDataReferences;
+  std::vector<bool> mInstructions;
+  std::vector<bool> mCode;
+  std::size_t mInstructionCount;
+};
+
+} // namespace Disassembler
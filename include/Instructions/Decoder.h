@@ -0,0 +1,177 @@
+#pragma once
+
+#include "Instructions/InstructionDef.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace Instructions {
+
+/// Plain data form of an instruction word. Every operand field is extracted
+/// from the word, the opcode decides which of them are meaningful.
+struct DecodedInstruction {
+  Opcode opcode = Opcode::ILLEGAL;
+  std::uint8_t x = 0;
+  std::uint8_t y = 0;
+  std::uint8_t n = 0;
+  std::uint8_t kk = 0;
+  std::uint16_t nnn = 0;
+};
+
+// clang-format off
+constexpr InstructionDef IllegalInstructionDef{
+    U(0x0000), Opcode::ILLEGAL, 0, {U(0x0000), U(0x0000), U(0x0000), U(0x0000)}};
+// clang-format on
+
+namespace detail {
+
+constexpr std::uint16_t group_shift = 12;
+constexpr std::uint16_t group_count = 16;
+constexpr std::uint16_t operand_mask = 0x0FFF;
+constexpr std::uint8_t illegal_index = InstructionDefinitions.size();
+
+/// The definitions the decode table points into, with the illegal definition
+/// appended so a lookup never has to branch on a miss.
+inline constexpr auto decoder_definitions =
+    []<std::size_t... Index>(std::index_sequence<Index...>) {
+      return std::array<InstructionDef, sizeof...(Index) + 1>{
+          {InstructionDefinitions[Index]..., IllegalInstructionDef}};
+    }(std::make_index_sequence<InstructionDefinitions.size()>{});
+
+constexpr std::uint16_t GetGroup(std::uint16_t data) {
+  return data >> group_shift;
+}
+
+/// Two definitions are ambiguous when a word can match both of them and
+/// neither mask is strictly more specific than the other.
+constexpr bool Overlaps(const InstructionDef &lhs, const InstructionDef &rhs) {
+  const std::uint16_t common = lhs.GetOpcodeMask() & rhs.GetOpcodeMask();
+  if (((lhs.GetOpcodeNum() ^ rhs.GetOpcodeNum()) & common) != 0) {
+    return false;
+  }
+  const bool lhsMoreSpecific = common == rhs.GetOpcodeMask();
+  const bool rhsMoreSpecific = common == lhs.GetOpcodeMask();
+  return lhsMoreSpecific == rhsMoreSpecific;
+}
+
+constexpr bool HasOverlappingDefinitions() {
+  for (std::size_t i = 0; i < InstructionDefinitions.size(); ++i) {
+    for (std::size_t j = i + 1; j < InstructionDefinitions.size(); ++j) {
+      if (Overlaps(InstructionDefinitions[i], InstructionDefinitions[j])) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/// Bits below the group nibble that any definition in the group looks at.
+constexpr std::uint16_t GetGroupMask(std::uint16_t group) {
+  std::uint16_t mask = 0;
+  for (const auto &def : InstructionDefinitions) {
+    if (GetGroup(def.GetOpcodeNum()) == group) {
+      mask |= def.GetOpcodeMask() & operand_mask;
+    }
+  }
+  return mask;
+}
+
+/// The group masks are used as the index into the group, so they must be a
+/// contiguous run of low bits.
+constexpr bool HasContiguousGroupMasks() {
+  for (std::uint16_t group = 0; group < group_count; ++group) {
+    const std::uint16_t mask = GetGroupMask(group);
+    if ((mask & (mask + 1)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr std::size_t GetTableSize() {
+  std::size_t size = 0;
+  for (std::uint16_t group = 0; group < group_count; ++group) {
+    size += GetGroupMask(group) + 1U;
+  }
+  return size;
+}
+
+struct DecodeTable {
+  std::array<std::uint16_t, group_count> offsets{};
+  std::array<std::uint16_t, group_count> masks{};
+  // Index into decoder_definitions for every word of every group.
+  std::array<std::uint8_t, GetTableSize()> entries{};
+};
+
+/// Builds one table per leading nibble, indexed by the remaining bits the
+/// group's definitions look at. When several definitions match a word the one
+/// with the most specific mask wins, so the order of InstructionDefinitions
+/// does not matter.
+constexpr DecodeTable BuildDecodeTable() {
+  DecodeTable table;
+  for (auto &entry : table.entries) {
+    entry = illegal_index;
+  }
+
+  std::uint16_t offset = 0;
+  for (std::uint16_t group = 0; group < group_count; ++group) {
+    const std::uint16_t mask = GetGroupMask(group);
+    table.offsets[group] = offset;
+    table.masks[group] = mask;
+
+    for (std::uint8_t index = 0; index < illegal_index; ++index) {
+      const auto &def = InstructionDefinitions[index];
+      if (GetGroup(def.GetOpcodeNum()) != group) {
+        continue;
+      }
+      for (std::uint32_t key = 0; key <= mask; ++key) {
+        const auto data = static_cast<std::uint16_t>(
+            (group << group_shift) | static_cast<std::uint16_t>(key));
+        if (!def.ContainsOpcode(data)) {
+          continue;
+        }
+        auto &entry = table.entries[offset + key];
+        if (entry == illegal_index ||
+            std::popcount(def.GetOpcodeMask()) >
+                std::popcount(
+                    InstructionDefinitions[entry].GetOpcodeMask())) {
+          entry = index;
+        }
+      }
+    }
+    offset += mask + 1;
+  }
+  return table;
+}
+
+static_assert(!HasOverlappingDefinitions(),
+              "Two instruction definitions match the same opcode");
+static_assert(HasContiguousGroupMasks(),
+              "Instruction groups must be indexed by their low bits");
+
+inline constexpr DecodeTable decode_table = BuildDecodeTable();
+
+} // namespace detail
+
+/// Looks up the definition matching the word, the illegal definition when
+/// there is none.
+constexpr const InstructionDef &GetDefinition(std::uint16_t data) {
+  const auto group = detail::GetGroup(data);
+  const auto index = detail::decode_table.offsets[group] +
+                     (data & detail::decode_table.masks[group]);
+  return detail::decoder_definitions[detail::decode_table.entries[index]];
+}
+
+constexpr DecodedInstruction Decode(std::uint16_t data) {
+  return {GetDefinition(data).GetOpcode(),
+          static_cast<std::uint8_t>((data >> 8) & 0xF),
+          static_cast<std::uint8_t>((data >> 4) & 0xF),
+          static_cast<std::uint8_t>(data & 0xF),
+          static_cast<std::uint8_t>(data & 0xFF),
+          static_cast<std::uint16_t>(data & 0xFFF)};
+}
+
+} // namespace Instructions
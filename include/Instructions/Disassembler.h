@@ -3,12 +3,21 @@
 #include "Instructions/Instruction.h"
 #include "Instructions/InstructionDef.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace Disassembler {
 
+/// Longest line Format writes.
+constexpr std::size_t max_line_size = 32;
+
 const Instructions::InstructionDef &GetInstructionDef(std::uint16_t data);
+/// Writes the line Instruction::Dump prints for word at address to out,
+/// without allocating. out needs room for max_line_size characters, returns
+/// one past the last one written.
+char *Format(std::uint16_t word, std::uint16_t address, char *out);
 std::string DisassembleToString(const std::vector<std::uint16_t> &input);
 
 std::vector<Instructions::Instruction *>
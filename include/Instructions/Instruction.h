@@ -13,11 +13,12 @@ namespace Instructions {
 
 constexpr auto instruction_size = 2;
 
-enum class Opcode {
+enum class Opcode : std::uint8_t {
   CLS,
   RET,
   SYS,
   JP,
+  JPV0,
   RND,
   CALL,
   SExkk,
@@ -54,7 +55,9 @@ enum class Opcode {
   SCL,
   EXIT,
   LOW,
-  HIGH
+  HIGH,
+  // Any word that does not match an instruction definition.
+  ILLEGAL
 };
 
 class Instruction {
@@ -62,6 +65,7 @@ public:
   Instruction(Opcode opcode, std::uint16_t address, std::uint16_t data);
   Opcode GetOpcode() { return mOpcode; }
   std::uint16_t GetAddress() { return mAddress; }
+  std::uint16_t GetData() { return mData; }
 
   virtual void Dump(std::ostream &os);
   virtual void Execute(CpuState &state);
@@ -110,6 +114,18 @@ private:
   std::uint16_t mExecAddr;
 };
 
+/// Jumps to address nnn plus the content of register V0.
+class JpV0Instruction : public Instruction {
+public:
+  JpV0Instruction(std::uint16_t address, std::uint16_t data);
+  std::uint16_t GetExecAddr() { return mExecAddr; }
+  void Dump(std::ostream &os);
+  void Execute(CpuState &state);
+
+private:
+  std::uint16_t mExecAddr;
+};
+
 class RndInstruction : public Instruction {
 public:
   RndInstruction(std::uint16_t address, std::uint16_t data);
@@ -244,6 +260,18 @@ private:
   Register mRegisterX;
 };
 
+/// Wait for a key press and store the key in register x
+class Ldx0Instruction : public Instruction {
+public:
+  Ldx0Instruction(std::uint16_t address, std::uint16_t data);
+  Register GetRegisterX() { return mRegisterX; }
+  void Dump(std::ostream &os);
+  void Execute(CpuState &state);
+
+private:
+  Register mRegisterX;
+};
+
 /// Set value of delay timer register equal to register x
 class LddtxInstruction : public Instruction {
 public:
@@ -279,6 +307,18 @@ private:
   Register mRegisterX;
 };
 
+/// Stores the binary coded decimal of register x at I, I + 1 and I + 2.
+class LdbxInstruction : public Instruction {
+public:
+  LdbxInstruction(std::uint16_t address, std::uint16_t data);
+  Register GetRegisterX() { return mRegisterX; }
+  void Dump(std::ostream &os);
+  void Execute(CpuState &state);
+
+private:
+  Register mRegisterX;
+};
+
 class LdixInstruction : public Instruction {
 public:
   LdixInstruction(std::uint16_t address, std::uint16_t data);
@@ -429,6 +469,30 @@ private:
   Register mRegisterY;
 };
 
+/// Skips the next instruction when the key in register x is held down.
+class SkpInstruction : public Instruction {
+public:
+  SkpInstruction(std::uint16_t address, std::uint16_t data);
+  Register GetRegisterX() { return mRegisterX; }
+  void Dump(std::ostream &os);
+  void Execute(CpuState &state);
+
+private:
+  Register mRegisterX;
+};
+
+/// Skips the next instruction when the key in register x is not held down.
+class SknpInstruction : public Instruction {
+public:
+  SknpInstruction(std::uint16_t address, std::uint16_t data);
+  Register GetRegisterX() { return mRegisterX; }
+  void Dump(std::ostream &os);
+  void Execute(CpuState &state);
+
+private:
+  Register mRegisterX;
+};
+
 class DrwInstruction : public Instruction {
 public:
   DrwInstruction(std::uint16_t address, std::uint16_t data);
@@ -40,13 +40,19 @@ inline std::uint16_t GetMaskShifts(std::uint16_t mask) {
 
 class InstructionDef {
 public:
-  InstructionDef(std::uint16_t opcodeNum, Opcode opcode,
-                 std::uint16_t immidiates, std::array<std::uint16_t, 4> masks);
-  bool ContainsOpcode(std::uint16_t data) const;
-  Opcode GetOpcode() const { return mOpcode; }
+  constexpr InstructionDef(std::uint16_t opcodeNum, Opcode opcode,
+                           std::uint16_t immidiates,
+                           std::array<std::uint16_t, 4> masks)
+      : mOpcodeNum(opcodeNum), mOpcode(opcode), mImmidiates(immidiates),
+        mMasks(masks) {}
+  constexpr bool ContainsOpcode(std::uint16_t data) const {
+    return (data & mMasks[0]) == mOpcodeNum;
+  }
+  constexpr Opcode GetOpcode() const { return mOpcode; }
   std::string GetNemonic() const { return ToString(mOpcode); }
-  std::uint16_t GetOpcodeNum() const { return mOpcodeNum; }
-  std::uint16_t GetImmidiates() const { return mImmidiates; }
+  constexpr std::uint16_t GetOpcodeNum() const { return mOpcodeNum; }
+  constexpr std::uint16_t GetImmidiates() const { return mImmidiates; }
+  constexpr std::uint16_t GetOpcodeMask() const { return mMasks[0]; }
 
 private:
   std::uint16_t mOpcodeNum;
@@ -58,9 +64,9 @@ private:
 };
 
 // clang-format off
-const std::array<InstructionDef, 35> InstructionDefinitions{{
-    {U(0x00E0), Opcode::CLS, 0, {U(0x00FF), U(0x0000), U(0x0000), U(0x0000)}},
-    {U(0x00EE), Opcode::RET, 0, {U(0x00FF), U(0x0000), U(0x0000), U(0x0000)}},
+constexpr std::array<InstructionDef, 35> InstructionDefinitions{{
+    {U(0x00E0), Opcode::CLS, 0, {U(0xFFFF), U(0x0000), U(0x0000), U(0x0000)}},
+    {U(0x00EE), Opcode::RET, 0, {U(0xFFFF), U(0x0000), U(0x0000), U(0x0000)}},
     {U(0x0000), Opcode::SYS, 1, {U(0xF000), U(0x0FFF), U(0x0000), U(0x0000)}},
     {U(0x1000), Opcode::JP, 1, {U(0xF000), U(0x0FFF), U(0x0000), U(0x0000)}},
     {U(0x2000), Opcode::CALL, 1, {U(0xF000), U(0x0FFF), U(0x0000), U(0x0000)}},
@@ -80,7 +86,7 @@ const std::array<InstructionDef, 35> InstructionDefinitions{{
     {U(0x800E), Opcode::SHL, 2, {U(0xF00F), U(0x0F00), U(0x00F0), U(0x0000)}},
     {U(0x9000), Opcode::SNExy, 2, {U(0xF00F), U(0x0F00), U(0x00F0), U(0x0000)}},
     {U(0xA000), Opcode::LDnnn, 1, {U(0xF000), U(0x0FFF), U(0x0000), U(0x0000)}},
-    {U(0xB000), Opcode::JP, 1, {U(0xF000), U(0x0FFF), U(0x0000), U(0x0000)}},
+    {U(0xB000), Opcode::JPV0, 1, {U(0xF000), U(0x0FFF), U(0x0000), U(0x0000)}},
     {U(0xC000), Opcode::RND, 2, {U(0xF000), U(0x0F00), U(0x00FF), U(0x0000)}},
     {U(0xD000), Opcode::DRW, 3, {U(0xF000), U(0x0F00), U(0x00F0), U(0x000F)}},
     {U(0xE09E), Opcode::SKP, 1, {U(0xF0FF), U(0x0F00), U(0x0000), U(0x0000)}},
@@ -3,10 +3,13 @@
 #include "Instruction.h"
 
 #include <string>
+#include <string_view>
 
 namespace Instructions {
 
 std::string ToString(Opcode opcode);
+/// Same as ToString without allocating.
+std::string_view GetMnemonic(Opcode opcode);
 
 Instruction *CreateInstruction(std::uint16_t address, Opcode opcode,
                                std::uint16_t data);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Instructions/Decoder.h"
+#include <CPU/CpuState.h>
+
+namespace Interpreter {
+
+/// Executes a decoded instruction with the same semantics as
+/// Instructions::Instruction::Execute, dispatched through a single switch
+/// instead of a virtual call. Returns false without touching the state when
+/// the instruction is not implemented.
+bool Execute(const Instructions::DecodedInstruction &instruction,
+             cpu::CpuState &state);
+
+} // namespace Interpreter
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "Instructions/Instruction.h"
+#include <CPU/CpuState.h>
+#include <Output/Sprites.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+// The behaviour of every instruction, shared by the Instruction classes and
+// the Interpreter so both engines execute the exact same semantics.
+// Like Instruction::Execute they leave advancing the PC to the caller, jumps
+// therefore store the target address minus one instruction.
+namespace Instructions::Semantics {
+
+inline std::uint8_t &Reg(CpuState &state, std::uint8_t index) {
+  return state.registers[index];
+}
+
+inline void Cls(CpuState &state) { state.display.Clear(); }
+
+/// Whether the stack has room for another call. A machine about to
+/// overflow its stack halts on the call instead.
+inline bool CanCall(const CpuState &state) {
+  return state.registers.SP + 1U < cpu::stack_size;
+}
+
+/// Whether there is a call to return from, see CanCall.
+inline bool CanReturn(const CpuState &state) {
+  return state.registers.SP > 0 && state.registers.SP < cpu::stack_size;
+}
+
+/// Whether the instruction can run with the stack as it is, false only for
+/// calls and returns the stack has no room for.
+inline bool FitsStack(const CpuState &state, Opcode opcode) {
+  switch (opcode) {
+  case Opcode::CALL:
+    return CanCall(state);
+  case Opcode::RET:
+    return CanReturn(state);
+  default:
+    return true;
+  }
+}
+
+/// Returns to the call instruction, the caller then steps past it. Returns
+/// false and changes nothing without a call to return from.
+inline bool Ret(CpuState &state) {
+  if (!CanReturn(state)) {
+    return false;
+  }
+  state.registers.PC = state.memory.PopStack(state.registers.SP);
+  state.registers.SP -= 1;
+  return true;
+}
+
+inline void Jp(CpuState &state, std::uint16_t address) {
+  state.registers.PC = address;
+  state.registers.PC -= instruction_size;
+}
+
+inline void JpV0(CpuState &state, std::uint16_t address) {
+  Jp(state, address + state.registers.V[0x0]);
+}
+
+/// Returns false and changes nothing when the stack is full.
+inline bool Call(CpuState &state, std::uint16_t address) {
+  if (!CanCall(state)) {
+    return false;
+  }
+  // Increase the stack pointer
+  state.registers.SP += 1;
+  // Write to the stack
+  state.memory.PushStack(state.registers.PC, state.registers.SP);
+  // Set pc to the address to execute
+  Jp(state, address);
+  return true;
+}
+
+inline void Rnd(CpuState &state, std::uint8_t x, std::uint8_t constant) {
+  Reg(state, x) = state.random.NextByte() & constant;
+}
+
+inline void SkipIf(CpuState &state, bool condition) {
+  if (condition) {
+    state.registers.PC += instruction_size;
+  }
+}
+
+inline void Sexkk(CpuState &state, std::uint8_t x, std::uint8_t constant) {
+  SkipIf(state, Reg(state, x) == constant);
+}
+
+inline void Sexy(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  SkipIf(state, Reg(state, x) == Reg(state, y));
+}
+
+inline void Snexkk(CpuState &state, std::uint8_t x, std::uint8_t constant) {
+  SkipIf(state, Reg(state, x) != constant);
+}
+
+inline void Snexy(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  SkipIf(state, Reg(state, x) != Reg(state, y));
+}
+
+/// Whether the key in the low nibble of register x is held down.
+inline bool IsKeyDown(CpuState &state, std::uint8_t x) {
+  return (state.keys >> (Reg(state, x) & 0xF)) & 1;
+}
+
+inline void Skp(CpuState &state, std::uint8_t x) {
+  SkipIf(state, IsKeyDown(state, x));
+}
+
+inline void Sknp(CpuState &state, std::uint8_t x) {
+  SkipIf(state, !IsKeyDown(state, x));
+}
+
+inline void Ldxkk(CpuState &state, std::uint8_t x, std::uint8_t constant) {
+  Reg(state, x) = constant;
+}
+
+inline void Ldxy(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  Reg(state, x) = Reg(state, y);
+}
+
+inline void Ldnnn(CpuState &state, std::uint16_t value) {
+  state.registers.I = value;
+}
+
+inline void Ldxdt(CpuState &state, std::uint8_t x) {
+  Reg(state, x) = state.registers.VDelay;
+}
+
+/// Stores the lowest key pressed since the last latch and takes the presses.
+/// Without a press it stays on this instruction, the emulator lets the rest
+/// of the frame pass instead of repeating it.
+inline void Ldx0(CpuState &state, std::uint8_t x) {
+  if (state.pressedKeys == 0) {
+    state.registers.PC -= instruction_size;
+    return;
+  }
+  Reg(state, x) =
+      static_cast<std::uint8_t>(std::countr_zero(state.pressedKeys));
+  state.pressedKeys = 0;
+}
+
+inline void Lddtx(CpuState &state, std::uint8_t x) {
+  state.registers.VDelay = Reg(state, x);
+}
+
+inline void Ldstx(CpuState &state, std::uint8_t x) {
+  state.registers.VSound = Reg(state, x);
+}
+
+/// Points I at the built in sprite for the low nibble of register x.
+inline void Ldfx(CpuState &state, std::uint8_t x) {
+  state.registers.I = Output::Sprites::sprite_0_address +
+                      (Reg(state, x) & 0xF) * Output::Sprites::sprite_size;
+}
+
+/// Stores the binary coded decimal of register x at I, I + 1 and I + 2.
+inline void Ldbx(CpuState &state, std::uint8_t x) {
+  const auto value = Reg(state, x);
+  state.memory.Store(state.registers.I, value / 100);
+  state.memory.Store(state.registers.I + 1, (value / 10) % 10);
+  state.memory.Store(state.registers.I + 2, value % 10);
+}
+
+/// Stores registers V0 up to and including Vx at I.
+inline void Ldix(CpuState &state, std::uint8_t x) {
+  for (std::uint8_t i = 0; i <= x; ++i) {
+    state.memory.Store(state.registers.I + i, Reg(state, i));
+  }
+}
+
+/// Loads registers V0 up to and including Vx from I.
+inline void Ldxi(CpuState &state, std::uint8_t x) {
+  const auto source = state.memory.View(state.registers.I, x + 1);
+  std::copy(source.begin(), source.end(), state.registers.V.begin());
+}
+
+inline void Addxkk(CpuState &state, std::uint8_t x, std::uint8_t constant) {
+  auto &reg = Reg(state, x);
+  reg = reg + constant;
+}
+
+inline void Addxy(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  auto &regx = Reg(state, x);
+  const std::uint16_t sum = regx + Reg(state, y);
+  // if the result is bigger than fits in a uint8 we set the carry flag
+  state.registers.V[0xF] = sum > 0xFF ? 1 : 0;
+  regx = static_cast<std::uint8_t>(sum & 0xFF);
+}
+
+inline void Addix(CpuState &state, std::uint8_t x) {
+  state.registers.I = state.registers.I + Reg(state, x);
+}
+
+/// Vx = Vx - Vy, VF is set when there is no borrow.
+inline void Sub(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  auto &regx = Reg(state, x);
+  const auto regy = Reg(state, y);
+  state.registers.V[0xF] = regx >= regy ? 1 : 0;
+  regx = regx - regy;
+}
+
+/// Vx = Vy - Vx, VF is set when there is no borrow.
+inline void Subn(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  auto &regx = Reg(state, x);
+  const auto regy = Reg(state, y);
+  state.registers.V[0xF] = regy >= regx ? 1 : 0;
+  regx = regy - regx;
+}
+
+inline void Or(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  Reg(state, x) |= Reg(state, y);
+}
+
+inline void And(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  Reg(state, x) &= Reg(state, y);
+}
+
+inline void Xor(CpuState &state, std::uint8_t x, std::uint8_t y) {
+  Reg(state, x) ^= Reg(state, y);
+}
+
+inline void Shr(CpuState &state, std::uint8_t x) {
+  auto &regx = Reg(state, x);
+  state.registers.V[0xF] = regx & 1;
+  regx = regx >> 1;
+}
+
+inline void Shl(CpuState &state, std::uint8_t x) {
+  auto &regx = Reg(state, x);
+  state.registers.V[0xF] = (regx & 0b1000'0000) ? 1 : 0;
+  regx = regx << 1;
+}
+
+inline void Drw(CpuState &state, std::uint8_t x, std::uint8_t y,
+                std::uint8_t size) {
+  // Position to draw at
+  const auto regx = Reg(state, x);
+  const auto regy = Reg(state, y);
+
+  const auto sprite = state.memory.ReadSprite(state.registers.I, size);
+  // VF reports whether the sprite erased any pixel.
+  state.registers.V[0xF] = state.display.Draw(regx, regy, sprite) ? 1 : 0;
+}
+
+} // namespace Instructions::Semantics
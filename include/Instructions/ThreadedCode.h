@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Instructions/Decoder.h"
+#include <CPU/CpuState.h>
+
+namespace Instructions {
+
+struct CompiledInstruction;
+
+/// Executes one instruction with its operands already extracted. Like
+/// Instruction::Execute it leaves advancing the PC to the caller.
+using Handler = void (*)(cpu::CpuState &state,
+                         const DecodedInstruction &instruction);
+
+/// An instruction bound to the function implementing it, so running a
+/// sequence of them is one indirect call each without decoding or dispatch.
+struct CompiledInstruction {
+  Handler handler;
+  DecodedInstruction operands;
+};
+
+/// The handler for opcode, nullptr when it is not implemented.
+Handler GetHandler(Opcode opcode);
+
+} // namespace Instructions
@@ -1,21 +1,67 @@
 #pragma once
+#include <array>
 #include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <span>
 namespace Output {
 
 constexpr std::size_t display_width = 128;
 constexpr std::size_t display_height = 64;
+constexpr std::size_t lowres_display_width = 64;
+constexpr std::size_t lowres_display_height = 32;
+
+constexpr std::size_t row_word_bits = 64;
+constexpr std::size_t row_words = display_width / row_word_bits;
+
+/// One row of the screen with one bit per pixel, pixel 0 is the most
+/// significant bit of the first word.
+using Row = std::array<std::uint64_t, row_words>;
+
+/// One bit per row of the screen, bit n for row n.
+using RowMask = std::uint64_t;
+static_assert(display_height <= 64, "Damaged rows are kept in 64 bits");
 
 class Display {
 public:
   Display();
 
-  void Draw(std::size_t x, std::size_t y, std::vector<std::uint8_t> data);
+  /// XORs the sprite onto the screen, one byte per row. The start position
+  /// wraps around the screen, the part of the sprite past the right and
+  /// bottom edges is clipped. Returns true when any lit pixel was erased.
+  bool Draw(std::size_t x, std::size_t y, std::span<const std::uint8_t> data);
   void Clear();
-  const std::vector<std::uint8_t> &GetScreen() { return mScreen; }
+  void SetHighResolution(bool enabled);
+  /// Shows the screen and resolution of saved, e.g. a snapshot. Unlike
+  /// copying it keeps what was presented, so the rows that differ from it
+  /// are damaged.
+  void Restore(const Display &saved);
+
+  bool IsHighResolution() const { return mWidth == display_width; }
+  std::size_t GetWidth() const { return mWidth; }
+  std::size_t GetHeight() const { return mHeight; }
+  bool GetPixel(std::size_t x, std::size_t y) const;
+  const Row &GetRow(std::size_t y) const { return mScreen[y]; }
+  const std::array<Row, display_height> &GetScreen() const { return mScreen; }
+
+  /// Rows that differ from the screen as of the last AcknowledgeDamage,
+  /// i.e. the rows a frontend has to upload. Rows changed and changed back
+  /// since, e.g. cleared and drawn again, are not damaged. Every row is
+  /// damaged after the resolution changed.
+  RowMask GetDamage() const;
+  bool HasDamage() const { return GetDamage() != 0; }
+  /// Returns the damage and takes the current screen as presented.
+  RowMask AcknowledgeDamage();
 
 private:
-  std::vector<std::uint8_t> mScreen;
+  std::array<Row, display_height> mScreen;
+  // The screen as of the last acknowledge and the rows written since, only
+  // those can differ.
+  std::array<Row, display_height> mPresented;
+  RowMask mTouched;
+  bool mPresentedHighResolution;
+  // Bits of each row word that are inside the current resolution.
+  Row mVisible;
+  std::size_t mWidth;
+  std::size_t mHeight;
 };
 } // namespace Output
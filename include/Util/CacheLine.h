@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace util {
+
+/// Size of a cache line, used to keep data written by different threads
+/// apart.
+constexpr std::size_t cache_line_size = 64;
+
+} // namespace util
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace util {
+
+/// Wakes up a thread sleeping in Wait from any other thread. Backed by an
+/// eventfd, so the sleeper takes no CPU until woken, within microseconds, and
+/// notifying never blocks or takes a lock. Notifications while nobody waits
+/// are kept, the next Wait returns at once.
+class Event {
+public:
+  Event() : mFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (mFd < 0) {
+      throw std::system_error(errno, std::generic_category(), "eventfd");
+    }
+  }
+  ~Event() { close(mFd); }
+  Event(const Event &) = delete;
+  Event &operator=(const Event &) = delete;
+
+  /// Any thread.
+  void Notify() {
+    const std::uint64_t one = 1;
+    // Retried when a signal interrupts it. EAGAIN means the counter is
+    // about to overflow, so it is set anyway.
+    while (write(mFd, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+  }
+
+  /// Sleeps until notified, takes every notification so far.
+  void Wait() { Poll(nullptr); }
+  /// Sleeps until notified or timeout passed, returns whether notified.
+  bool Wait(std::chrono::nanoseconds timeout) {
+    timeout = std::max(timeout, std::chrono::nanoseconds(0));
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec time{static_cast<std::time_t>(seconds.count()),
+                        static_cast<long>((timeout - seconds).count())};
+    return Poll(&time);
+  }
+
+private:
+  bool Poll(const timespec *timeout) {
+    pollfd descriptor{mFd, POLLIN, 0};
+    const int ready = ppoll(&descriptor, 1, timeout, nullptr);
+    if (ready <= 0) {
+      // Timed out, or a signal arrived and it counts as a spurious wake up.
+      return false;
+    }
+    std::uint64_t count;
+    // Retried when a signal interrupts it. EAGAIN means the counter is
+    // already taken, the notification was seen all the same.
+    while (read(mFd, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+    return true;
+  }
+
+  int mFd;
+};
+
+} // namespace util
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+
+namespace util {
+
+/// Bounded lock free queue for exactly one producer and one consumer thread.
+/// Each side caches the other side's index and only reloads it when the
+/// queue looks full or empty, so the indices bounce between cores rarely.
+template <typename T, std::size_t Capacity> class SpscRing {
+  static_assert(std::has_single_bit(Capacity),
+                "Capacity must be a power of two");
+
+public:
+  static constexpr std::size_t capacity = Capacity;
+
+  /// Producer only. Returns false, leaving the queue unchanged, when full.
+  bool TryPush(const T &value) {
+    const auto tail = mProducer.tail.load(std::memory_order_relaxed);
+    if (tail - mProducer.cachedHead == Capacity) {
+      mProducer.cachedHead = mConsumer.head.load(std::memory_order_acquire);
+      if (tail - mProducer.cachedHead == Capacity) {
+        return false;
+      }
+    }
+    mItems[tail & (Capacity - 1)] = value;
+    mProducer.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer only.
+  std::optional<T> TryPop() {
+    const auto head = mConsumer.head.load(std::memory_order_relaxed);
+    if (head == mConsumer.cachedTail) {
+      mConsumer.cachedTail = mProducer.tail.load(std::memory_order_acquire);
+      if (head == mConsumer.cachedTail) {
+        return std::nullopt;
+      }
+    }
+    T value = mItems[head & (Capacity - 1)];
+    mConsumer.head.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  /// Consumer only. Calls consume for every item available right now and
+  /// returns how many there were.
+  template <typename Consume> std::size_t Drain(Consume &&consume) {
+    const auto head = mConsumer.head.load(std::memory_order_relaxed);
+    mConsumer.cachedTail = mProducer.tail.load(std::memory_order_acquire);
+    for (auto index = head; index != mConsumer.cachedTail; ++index) {
+      consume(mItems[index & (Capacity - 1)]);
+    }
+    mConsumer.head.store(mConsumer.cachedTail, std::memory_order_release);
+    return mConsumer.cachedTail - head;
+  }
+
+  /// Approximate when called while the other side is running.
+  bool Empty() const {
+    return mConsumer.head.load(std::memory_order_acquire) ==
+           mProducer.tail.load(std::memory_order_acquire);
+  }
+
+private:
+  // Written by the producer, read by the consumer.
+  struct alignas(cache_line_size) Producer {
+    std::atomic<std::size_t> tail{0};
+    std::size_t cachedHead = 0;
+  };
+  // Written by the consumer, read by the producer.
+  struct alignas(cache_line_size) Consumer {
+    std::atomic<std::size_t> head{0};
+    std::size_t cachedTail = 0;
+  };
+
+  Producer mProducer;
+  Consumer mConsumer;
+  std::array<T, Capacity> mItems;
+};
+
+} // namespace util
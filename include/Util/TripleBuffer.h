@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace util {
+
+/// Hands the newest value from exactly one producer thread to exactly one
+/// consumer thread, neither side ever waits for the other. Of the three slots
+/// the producer fills one, the consumer reads one and the third holds the
+/// latest published value, which either side swaps its own slot with. Values
+/// published faster than the consumer takes them are overwritten, so the
+/// consumer always gets the newest one.
+template <typename T> class TripleBuffer {
+public:
+  /// Producer only. The slot to fill before Publish. Holds an older value,
+  /// not necessarily the last one published, so it has to be written fully.
+  T &GetBack() { return mSlots[mBack].value; }
+
+  /// Producer only. Makes the back slot the latest value.
+  void Publish() {
+    mBack = mMiddle.exchange(static_cast<std::uint8_t>(mBack | fresh),
+                             std::memory_order_acq_rel) &
+            index_mask;
+  }
+
+  /// Producer only. Whether the consumer took the last published value, a
+  /// producer outpacing the consumer can skip values it would not take.
+  bool IsTaken() const {
+    return (mMiddle.load(std::memory_order_relaxed) & fresh) == 0;
+  }
+
+  /// Consumer only. Takes the latest value when one was published since the
+  /// last call, returns whether there was one.
+  bool Update() {
+    if ((mMiddle.load(std::memory_order_relaxed) & fresh) == 0) {
+      return false;
+    }
+    mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & index_mask;
+    return true;
+  }
+
+  /// Consumer only. The value taken by the last successful Update.
+  const T &GetFront() const { return mSlots[mFront].value; }
+
+private:
+  static constexpr std::uint8_t index_mask = 0x3;
+  // Set in mMiddle while it holds a value the consumer has not taken yet.
+  static constexpr std::uint8_t fresh = 0x4;
+
+  struct alignas(cache_line_size) Slot {
+    T value{};
+  };
+
+  std::array<Slot, 3> mSlots{};
+  // Index of the slot holding the latest value, and the fresh bit.
+  alignas(cache_line_size) std::atomic<std::uint8_t> mMiddle{2};
+  alignas(cache_line_size) std::uint8_t mBack = 0;
+  alignas(cache_line_size) std::uint8_t mFront = 1;
+};
+
+} // namespace util
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/// Runs a job for every index in [0, count) on a number of threads.
+/// Every worker starts with an equal share of the indices in its own queue. It
+/// takes work from the back of its own queue and, once that runs dry, steals
+/// from the front of the other queues so long running jobs do not leave
+/// threads idle.
+class WorkStealingPool {
+public:
+  explicit WorkStealingPool(std::size_t threads)
+      : mThreads(std::max<std::size_t>(threads, 1)) {}
+
+  std::size_t GetThreadCount() const { return mThreads; }
+
+  template <typename Job> void Run(std::size_t count, Job &&job) {
+    std::vector<Queue> queues(
+        std::min(mThreads, std::max<std::size_t>(count, 1)));
+    for (std::size_t index = 0; index < count; ++index) {
+      queues[index % queues.size()].indices.push_back(index);
+    }
+
+    auto worker = [&queues, &job](std::size_t self) {
+      while (auto index = Next(queues, self)) {
+        job(*index);
+      }
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(queues.size() - 1);
+    for (std::size_t self = 1; self < queues.size(); ++self) {
+      threads.emplace_back(worker, self);
+    }
+    worker(0);
+  }
+
+private:
+  struct alignas(cache_line_size) Queue {
+    std::mutex mutex;
+    std::deque<std::size_t> indices;
+  };
+
+  static std::optional<std::size_t> Next(std::vector<Queue> &queues,
+                                         std::size_t self) {
+    {
+      auto &own = queues[self];
+      std::lock_guard lock(own.mutex);
+      if (!own.indices.empty()) {
+        auto index = own.indices.back();
+        own.indices.pop_back();
+        return index;
+      }
+    }
+    // Jobs are never added while running, so once every queue has been seen
+    // empty there is nothing left to do.
+    for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+      auto &victim = queues[(self + offset) % queues.size()];
+      std::lock_guard lock(victim.mutex);
+      if (!victim.indices.empty()) {
+        auto index = victim.indices.front();
+        victim.indices.pop_front();
+        return index;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::size_t mThreads;
+};
+
+} // namespace util
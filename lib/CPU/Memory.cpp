@@ -5,12 +5,16 @@
 #include <cassert>
 #include <cstdint>
 #include <iostream>
-#include <vector>
+#include <span>
 
 namespace cpu {
-Memory::Memory() {
-  mMemoryBuffer.resize(memory_size, 0U);
-  mStack.resize(16, 0U);
+Memory::Memory()
+    : mMemoryBuffer{}, mStack{}, mDirtyPages(0), mWrittenPages(0),
+      mWrittenLines{},
+      mWatchedLines{}, mObserver(nullptr) {
+  // Untouched memory is all zeroes, so every page starts out sharing the same
+  // zero page.
+  mPages.fill(std::make_shared<const Page>());
 }
 
 std::uint8_t Memory::Read(std::uint16_t address) const {
@@ -19,15 +23,14 @@ std::uint8_t Memory::Read(std::uint16_t address) const {
 }
 
 std::uint16_t Memory::ReadUint16(std::uint16_t address) const {
-  std::uint8_t high = Read(address);
-  std::uint8_t low = Read(address + 1);
-  uint16_t result = (static_cast<uint16_t>(high) << 8) | low;
-  return result;
+  assert(IsValidAddress(address) && "Don't read outside the buffer");
+  assert(IsValidAddress(address + 1) && "Don't read outside the buffer");
+  return Fetch(address);
 }
 
 void Memory::Write(std::uint16_t address, std::uint8_t value) {
   assert(IsValidAddress(address) && "Don't read outside the buffer");
-  mMemoryBuffer[address] = value;
+  Store(address, value);
 }
 
 void Memory::WriteUint16(std::uint16_t address, std::uint16_t value) {
@@ -40,24 +43,23 @@ void Memory::WriteUint16(std::uint16_t address, std::uint16_t value) {
 }
 
 bool Memory::IsValidAddress(std::uint16_t address) const {
-  return address < mMemoryBuffer.size() && address >= memory_start;
+  return address < memory_size && address >= memory_start;
 }
 
-bool Memory::LoadIntoMemory(std::vector<std::uint8_t> buffer,
+bool Memory::LoadIntoMemory(std::span<const std::uint8_t> buffer,
                             std::uint16_t address) {
-  if (!IsValidAddress(address)) {
-    return false;
-  }
-  if (!IsValidAddress(address + buffer.size())) {
+  if (!Fits(address, buffer.size())) {
     return false;
   }
   std::copy(buffer.begin(), buffer.end(), mMemoryBuffer.begin() + address);
+  MarkDirty(address, buffer.size());
+  UpdateMirror();
   return true;
 }
 
 void Memory::Dump(std::ostream &os) {
-  os << "Dumpiong Memory Buffer size: " << mMemoryBuffer.size() << std::endl;
-  for (const auto &byte : mMemoryBuffer) {
+  os << "Dumpiong Memory Buffer size: " << memory_size << std::endl;
+  for (const auto &byte : std::span(mMemoryBuffer).first<memory_size>()) {
     os << std::hex << (std::uint32_t)byte << " ";
   }
   os << std::endl;
@@ -79,17 +81,41 @@ bool Memory::LoadSprite(std::uint16_t address, Output::Sprites::Sprite sprite) {
     return false;
   }
   std::copy(sprite.begin(), sprite.end(), mMemoryBuffer.begin() + address);
+  MarkDirty(address, sprite.size());
+  UpdateMirror();
   return true;
 }
 
-std::vector<std::uint8_t> Memory::ReadSprite(std::uint16_t address,
-                                             std::uint8_t size) {
-  assert(address + size < mMemoryBuffer.size());
-  std::vector<std::uint8_t> result;
-  result.resize(size);
-  for (std::uint16_t i = 0; i < size; ++i) {
-    result[i] = mMemoryBuffer[address + i];
+MemorySnapshot Memory::TakeSnapshot() {
+  for (std::size_t page = 0; page < page_count; ++page) {
+    if (mDirtyPages & (1U << page)) {
+      auto copy = std::make_shared<Page>();
+      std::copy_n(mMemoryBuffer.begin() + page * page_size, page_size,
+                  copy->begin());
+      mPages[page] = std::move(copy);
+    }
   }
-  return result;
+  mDirtyPages = 0;
+  return {mPages, mStack};
+}
+
+void Memory::RestoreSnapshot(const MemorySnapshot &snapshot) {
+  for (std::size_t page = 0; page < page_count; ++page) {
+    // A clean page still shared with the snapshot already holds its bytes.
+    if ((mDirtyPages & (1U << page)) || mPages[page] != snapshot.pages[page]) {
+      std::copy(snapshot.pages[page]->begin(), snapshot.pages[page]->end(),
+                mMemoryBuffer.begin() + page * page_size);
+      mPages[page] = snapshot.pages[page];
+      MarkDirty(page * page_size, page_size);
+    }
+  }
+  mDirtyPages = 0;
+  mStack = snapshot.stack;
+  UpdateMirror();
+}
+
+void Memory::UpdateMirror() {
+  std::copy_n(mMemoryBuffer.begin(), mirror_size,
+              mMemoryBuffer.begin() + memory_size);
 }
 } // namespace cpu
@@ -0,0 +1,164 @@
+#include "Emulator/BlockCache.h"
+#include <Instructions/Decoder.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace emulator {
+
+using Instructions::Opcode;
+
+namespace {
+/// Instructions after which execution may not continue with the next
+/// address, or which may have written to code.
+bool EndsBlock(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::JP:
+  case Opcode::JPV0:
+  case Opcode::CALL:
+  case Opcode::RET:
+  case Opcode::SExkk:
+  case Opcode::SExy:
+  case Opcode::SNExkk:
+  case Opcode::SNExy:
+  case Opcode::SKP:
+  case Opcode::SKNP:
+  case Opcode::LDx0:
+  case Opcode::LDbx:
+  case Opcode::LDix:
+    return true;
+  default:
+    return false;
+  }
+}
+} // namespace
+
+BlockCache::BlockCache()
+    : mBlocks(cpu::memory_size, nullptr), mLineBlocks(cpu::line_count),
+      mCodeLines{}, mStaleLines{}, mStale(false), mBlockCount(0) {}
+
+BlockCache::~BlockCache() { Clear(); }
+
+Block *BlockCache::Get(std::uint16_t pc, cpu::Memory &memory) {
+  assert(pc < mBlocks.size() && "Address outside of memory");
+  auto *&block = mBlocks[pc];
+  if (block != nullptr) {
+    return block;
+  }
+  block = Compile(pc, memory);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  ++mBlockCount;
+  for (auto line = block->start / cpu::line_size;
+       line <= (block->GetCodeEnd() - 1u) / cpu::line_size; ++line) {
+    mLineBlocks[line].push_back(pc);
+    mCodeLines[line / 64] |= 1ULL << (line % 64);
+  }
+  // Lines no longer holding code may stay watched until the next compile,
+  // writes to them just find nothing to invalidate.
+  memory.SetWatchedLines(mCodeLines);
+  return block;
+}
+
+Block *BlockCache::Compile(std::uint16_t pc, const cpu::Memory &memory) const {
+  auto *block = new Block{};
+  block->start = pc;
+  auto address = pc;
+  while (block->code.size() < max_block_instructions &&
+         memory.IsValidAddress(address) && memory.IsValidAddress(address + 1)) {
+    const auto decoded = Instructions::Decode(memory.Fetch(address));
+    const auto handler = Instructions::GetHandler(decoded.opcode);
+    if (handler == nullptr) {
+      break;
+    }
+    block->code.push_back({handler, decoded});
+    address += Instructions::instruction_size;
+    if (EndsBlock(decoded.opcode)) {
+      break;
+    }
+  }
+  if (block->code.empty()) {
+    delete block;
+    return nullptr;
+  }
+  block->end = address;
+  const auto last = block->code.back().operands.opcode;
+  if ((last == Opcode::SExkk || last == Opcode::SExy ||
+       last == Opcode::SNExkk || last == Opcode::SNExy) &&
+      memory.IsValidAddress(address) && memory.IsValidAddress(address + 1)) {
+    const auto next = Instructions::Decode(memory.Fetch(address));
+    if (next.opcode == Opcode::JP) {
+      block->skipJump = true;
+      block->skipJumpTarget = next.nnn;
+    }
+  }
+  // Only code the block depends on, GetCodeEnd covers the folded jump.
+  block->idle = FindIdleLoop(pc, memory);
+  return block;
+}
+
+bool BlockCache::Invalidate(const cpu::LineMask &written) {
+  bool removed = false;
+  for (std::size_t word = 0; word < written.size(); ++word) {
+    auto hits = written[word] & mCodeLines[word];
+    while (hits != 0) {
+      const auto line = word * 64 + std::countr_zero(hits);
+      hits &= hits - 1;
+      // Copied, removing a block edits the lists of all its lines.
+      const auto starts = mLineBlocks[line];
+      for (auto start : starts) {
+        Remove(mBlocks[start]);
+        removed = true;
+      }
+    }
+  }
+  // Other blocks may still be chained to the removed ones.
+  if (removed) {
+    Unchain();
+  }
+  return removed;
+}
+
+void BlockCache::Remove(Block *block) {
+  if (block == nullptr) {
+    return;
+  }
+  for (auto line = block->start / cpu::line_size;
+       line <= (block->GetCodeEnd() - 1u) / cpu::line_size; ++line) {
+    auto &starts = mLineBlocks[line];
+    starts.erase(std::remove(starts.begin(), starts.end(), block->start),
+                 starts.end());
+    if (starts.empty()) {
+      mCodeLines[line / 64] &= ~(1ULL << (line % 64));
+    }
+  }
+  mBlocks[block->start] = nullptr;
+  --mBlockCount;
+  delete block;
+}
+
+void BlockCache::Unchain() {
+  for (auto *block : mBlocks) {
+    if (block != nullptr) {
+      block->successor = nullptr;
+    }
+  }
+}
+
+void BlockCache::Clear() {
+  for (auto *&block : mBlocks) {
+    delete block;
+    block = nullptr;
+  }
+  for (auto &starts : mLineBlocks) {
+    starts.clear();
+  }
+  mCodeLines = {};
+  mStaleLines = {};
+  mStale = false;
+  mBlockCount = 0;
+}
+
+} // namespace emulator
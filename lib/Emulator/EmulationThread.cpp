@@ -0,0 +1,176 @@
+#include "Emulator/EmulationThread.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace emulator {
+
+EmulationThread::EmulationThread(Pacing pacing)
+    : mPacer(1, pacing), mPacing(pacing), mFrameNumber(0), mPaused(false),
+      mFullDamage(false), mTurbo(pacing == Pacing::Unthrottled),
+      mUnpublished(false),
+      mThread([this](std::stop_token stop) { Run(stop); }) {}
+
+EmulationThread::~EmulationThread() = default;
+
+void EmulationThread::Run(std::stop_token stop) {
+  // Stopping has to wake the thread wherever it sleeps.
+  std::stop_callback wake(stop, [this] { mWake.Notify(); });
+  while (!stop.stop_requested()) {
+    mCommands.Drain([this](const Command &command) { Execute(command); });
+    if (!mEmulator || mPaused) {
+      if (mEmulator && mUnpublished) {
+        Publish();
+      }
+      mWake.Wait();
+      continue;
+    }
+    // Frames are only skipped whole, after stepping into the wait it first
+    // runs to the end of the frame.
+    if (mPacing == Pacing::RealTime && mEmulator->IsWaitingForKey() &&
+        mEmulator->GetScheduler().GetClock().frameInstructions == 0) {
+      Park();
+      continue;
+    }
+    const auto budget = mEmulator->GetScheduler().InstructionsUntilFrame();
+    if (mEmulator->RunFor(budget) < budget) {
+      std::cerr << "Cannot execute instruction at 0x" << std::hex
+                << mEmulator->GetState().registers.PC << std::dec
+                << std::endl;
+      mPaused = true;
+    }
+    // Damage keeps adding up in the emulator until the next published frame.
+    if (!mTurbo || mFrames.IsTaken()) {
+      Publish();
+    } else {
+      mUnpublished = true;
+    }
+    mPacer.Advance();
+    mPacer.WaitForFrame();
+  }
+}
+
+void EmulationThread::Execute(const Command &command) {
+  switch (command.type) {
+  case CommandType::Pause:
+    SetPaused(true);
+    break;
+  case CommandType::Resume:
+    SetPaused(false);
+    break;
+  case CommandType::TogglePause:
+    SetPaused(!mPaused);
+    break;
+  case CommandType::Step:
+    if (mEmulator) {
+      mPaused = true;
+      if (!mEmulator->Step()) {
+        std::cerr << "Cannot execute instruction at 0x" << std::hex
+                  << mEmulator->GetState().registers.PC << std::dec
+                  << std::endl;
+      }
+      Publish();
+    }
+    break;
+  case CommandType::Reset:
+    if (mEmulator) {
+      Load(mPath);
+    }
+    break;
+  case CommandType::Load:
+    Load(command.path);
+    break;
+  case CommandType::SetSpeed:
+    SetSpeed(command.speed);
+    break;
+  }
+}
+
+void EmulationThread::Load(const std::filesystem::path &path) {
+  auto emulator = std::make_unique<Emulator>();
+  // Keeps running the current game when the new one fails to load.
+  if (!emulator->LoadGame(path)) {
+    return;
+  }
+  emulator->SetKeyManager(&mKeys);
+  mEmulator = std::move(emulator);
+  mPath = path;
+  mFullDamage = true;
+  Publish();
+}
+
+void EmulationThread::SetPaused(bool paused) {
+  if (paused == mPaused) {
+    return;
+  }
+  mPaused = paused;
+  if (!paused) {
+    // Real time continues from now, not from where the pause started.
+    mPacer.SetPacing(mPacing);
+  }
+  if (mEmulator) {
+    Publish();
+  }
+}
+
+void EmulationThread::SetSpeed(double speed) {
+  // Only the pacing changes, the machine carries on where it is.
+  mPacing = speed > 0 ? Pacing::RealTime : Pacing::Unthrottled;
+  if (speed > 0) {
+    mPacer.SetSpeed(speed);
+  }
+  mPacer.SetPacing(mPacing);
+  mTurbo = mPacing == Pacing::Unthrottled || speed > 1;
+  if (mEmulator) {
+    Publish();
+  }
+}
+
+void EmulationThread::Park() {
+  // The frontend shows the machine waiting, even after skipped frames.
+  if (mUnpublished) {
+    Publish();
+  }
+  // The sound timer is the only thing a frontend sees change while the
+  // machine waits, so sleep no longer than it keeps sounding.
+  const auto sound = mEmulator->GetState().registers.VSound;
+  const auto duration = mPacer.GetFrameDuration();
+  const auto parked = std::chrono::steady_clock::now();
+  if (sound > 0) {
+    mWake.Wait(duration * sound);
+  } else {
+    mWake.Wait();
+  }
+  // The frames slept through pass at once, so the timers read as if the
+  // machine had been running all along.
+  mEmulator->PassFrames((std::chrono::steady_clock::now() - parked) /
+                        duration);
+  // A key that woke the thread is taken now rather than a frame later.
+  mEmulator->LatchKeys();
+  // Real time continues from now, not from where the wait started.
+  mPacer.SetPacing(mPacing);
+  Publish();
+}
+
+void EmulationThread::Publish() {
+  const auto &state = mEmulator->GetState();
+  auto &frame = mFrames.GetBack();
+  frame.screen = state.display.GetScreen();
+  frame.width = state.display.GetWidth();
+  frame.height = state.display.GetHeight();
+  frame.damage = mEmulator->AcknowledgeDamage();
+  if (mFullDamage) {
+    frame.damage = ~Output::RowMask{0};
+    mFullDamage = false;
+  }
+  frame.number = ++mFrameNumber;
+  frame.instructions = mEmulator->GetScheduler().GetClock().instructions;
+  frame.sound = state.registers.VSound > 0;
+  frame.paused = mPaused;
+  frame.speed = mPacing == Pacing::RealTime ? mPacer.GetSpeed() : 0;
+  frame.waitingForKey = mEmulator->IsWaitingForKey();
+  mFrames.Publish();
+  mUnpublished = false;
+}
+
+} // namespace emulator
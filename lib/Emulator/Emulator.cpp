@@ -1,99 +1,427 @@
 #include "Emulator/Emulator.h"
-#include <Instructions/Disassembler.h>
+#include <Instructions/Interpreter.h>
+#include <Instructions/Semantics.h>
+#include <Instructions/ThreadedCode.h>
 #include <Output/Sprites.h>
 
 #include <algorithm>
 #include <assert.h>
+#include <cerrno>
 #include <cstdint>
+#include <cstring>
+#include <fcntl.h>
 #include <filesystem>
-#include <fstream>
-#include <ios>
 #include <iostream>
-#include <system_error>
+#include <span>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace emulator {
 
 namespace {
-std::vector<std::uint8_t> ReadFileToVector(const std::filesystem::path &file) {
-  std::ifstream ifs(file.string(), std::ios::binary | std::ios::ate);
-  if (!ifs) {
-    std::cerr << "Failed to open file: " << file << std::endl;
-    return {};
+/// Closes the file descriptor when leaving scope.
+class FileDescriptor {
+public:
+  explicit FileDescriptor(int fd) : mFd(fd) {}
+  FileDescriptor(const FileDescriptor &) = delete;
+  FileDescriptor &operator=(const FileDescriptor &) = delete;
+  ~FileDescriptor() {
+    if (mFd >= 0) {
+      close(mFd);
+    }
   }
-  const std::streamsize size = ifs.tellg();
-  ifs.seekg(0, std::ios::beg);
+  int Get() const { return mFd; }
 
-  std::vector<std::uint8_t> inputBuff(size);
+private:
+  int mFd;
+};
 
-  if (!ifs.read(reinterpret_cast<char *>(inputBuff.data()), size)) {
-    std::cerr << "Failed to read file: " << file << std::endl;
-    return {};
+/// Reads the whole buffer starting at the beginning of the file.
+bool ReadFully(int fd, std::span<std::uint8_t> buffer) {
+  std::size_t done = 0;
+  while (done < buffer.size()) {
+    const auto count =
+        pread(fd, buffer.data() + done, buffer.size() - done, done);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return false;
+    }
+    done += count;
   }
-
-  return inputBuff;
+  return true;
 }
 } // namespace
 
-Emulator::Emulator() : mRunning(false) {}
-
-Emulator::~Emulator() {
-  std::for_each(mInstructions.begin(), mInstructions.end(),
-                [](auto *instruction) { free(instruction); });
+Emulator::Emulator()
+    : mEngine(Engine::Interpreter), mTraceLevel(TraceLevel::Off),
+      mKeys(nullptr), mJitEnabled(jit::IsSupported()), mRunning(false),
+      mVerbose(false) {
+  // The cache outlives the memory, it is declared first.
+  mState.memory.SetWriteObserver(&mBlocks);
 }
 
+Emulator::~Emulator() = default;
+
 bool Emulator::LoadGame(const std::filesystem::path path) {
-  std::error_code error;
-  auto result = std::filesystem::exists(path, error);
-  if (error) {
-    std::cerr << "Failed to load: " << path << error.message();
+  FileDescriptor file(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (file.Get() < 0) {
+    std::cerr << "Failed to load: " << path << ", " << std::strerror(errno)
+              << std::endl;
     return false;
   }
-  if (!result) {
-    std::cerr << "Failed to load: '" << path << "', file does not exist\n";
+  struct stat status;
+  if (fstat(file.Get(), &status) != 0 || !S_ISREG(status.st_mode)) {
+    std::cerr << "Failed to load: " << path << ", not a regular file"
+              << std::endl;
+    return false;
+  }
+  const auto size = static_cast<std::size_t>(status.st_size);
+  if (size > memory_size - instruction_start) {
+    std::cerr << "Failed to load: " << path << ", " << size
+              << " bytes does not fit in memory" << std::endl;
     return false;
   }
-  // Load game into memory
-  mState.registers.PC = instruction_start;
-  auto inputBuffer = ReadFileToVector(path);
 
-  std::cout << "inputBuffer size: " << inputBuffer.size() << std::endl;
-  for (const auto &byte : inputBuffer) {
-    std::cout << std::hex << (std::uint32_t)byte << " ";
+  // Read the game straight into memory
+  mState.registers.PC = instruction_start;
+  if (!mState.memory.LoadInPlace(
+          instruction_start, size, [&file](std::span<std::uint8_t> target) {
+            return ReadFully(file.Get(), target);
+          })) {
+    std::cerr << "Failed to read: " << path << std::endl;
+    return false;
   }
-  std::cout << std::endl;
-  mState.memory.LoadIntoMemory(std::move(inputBuffer), instruction_start);
   if (!LoadSprites()) {
     std::cerr << "Failed to load sprites" << std::endl;
     return false;
   }
 
-  mState.memory.Dump(std::cout);
+  if (mVerbose) {
+    std::cout << "Loaded " << size << " bytes from " << path << std::endl;
+    mState.memory.Dump(std::cout);
+  }
   return true;
 }
 
-void Emulator::Run(bool dumpState) {
+void Emulator::Run(const std::function<void(Emulator &)> &beforeFrame) {
   mRunning = true;
-  if (dumpState) {
-    DumpState(std::cout);
-  }
   while (mRunning) {
-    auto *instruction = GetNextInstruction();
-    instruction->Dump(std::cout);
-    std::cout << "\n";
+    if (beforeFrame) {
+      beforeFrame(*this);
+    }
+    const auto budget = mScheduler.InstructionsUntilFrame();
+    if (RunFor(budget) < budget) {
+      std::cerr << "Cannot execute instruction at 0x" << std::hex
+                << mState.registers.PC << std::endl;
+      mRunning = false;
+    }
+  }
+}
+
+std::uint64_t Emulator::RunFor(std::uint64_t instructions) {
+  if (mEngine == Engine::Threaded && mTraceLevel == TraceLevel::Off) {
+    return RunBlocks(instructions);
+  }
+  std::uint64_t executed = 0;
+  while (executed < instructions) {
+    const auto pc = mState.registers.PC;
+    if (!Step()) {
+      break;
+    }
+    ++executed;
+    // Back at the same or an earlier instruction, maybe one that only lets
+    // time pass. A trace records every instruction run instead.
+    if (mState.registers.PC <= pc && mTraceLevel == TraceLevel::Off) {
+      executed +=
+          IsWaitingForKey()
+              ? SkipWait(instructions - executed)
+              : SkipIdleLoop(FindIdleLoop(mState.registers.PC, mState.memory),
+                             instructions - executed);
+    }
+  }
+  return executed;
+}
+
+std::uint64_t Emulator::RunBlocks(std::uint64_t instructions) {
+  auto &memory = mState.memory;
+  // Drop blocks made stale by writes since the last run, e.g. loading.
+  mBlocks.InvalidateStale();
+
+  std::uint64_t executed = 0;
+  Block *previous = nullptr;
+  while (executed < instructions) {
+    const auto pc = mState.registers.PC;
+    if (!memory.IsValidAddress(pc) || !memory.IsValidAddress(pc + 1)) {
+      break;
+    }
+    auto *block = mBlocks.Next(previous, pc, memory);
+    if (block == nullptr || !block->FitsStack(mState)) {
+      // Not compilable, most likely not implemented either. Or ending in a
+      // call or return the stack has no room for, stepping halts on it.
+      if (!Step()) {
+        break;
+      }
+      ++executed;
+      previous = nullptr;
+      continue;
+    }
+    if (block->idle.length != 0) {
+      const auto skipped = SkipIdleLoop(block->idle, instructions - executed);
+      if (skipped != 0) {
+        executed += skipped;
+        previous = nullptr;
+        continue;
+      }
+    }
+    // Blocks never run past a frame boundary so the timers tick on time.
+    const auto count = RunBlock(
+        *block, std::min(instructions - executed,
+                         mScheduler.InstructionsUntilFrame()));
+    executed += count;
+    if (mScheduler.Advance(count)) {
+      EndFrame();
+    }
+    if (mState.registers.PC == pc && IsWaitingForKey()) {
+      executed += SkipWait(instructions - executed);
+    }
+    // Blocks end at every store, so a block never runs code it overwrote.
+    previous = block;
+    if (mBlocks.HasStaleBlocks() && mBlocks.InvalidateStale()) {
+      previous = nullptr;
+    }
+  }
+  return executed;
+}
+
+std::uint64_t Emulator::RunBlock(Block &block, std::uint64_t budget) {
+  if (mJitEnabled) {
+    if (block.runs < jit::hot_threshold &&
+        ++block.runs == jit::hot_threshold) {
+      block.native = jit::Compile(block);
+    }
+    // Native code always runs the whole block.
+    if (block.native != nullptr &&
+        budget >= block.native->GetMaxInstructions()) {
+      return block.native->Run(mState);
+    }
+  }
+  return block.Run(mState, budget);
+}
+
+std::uint64_t Emulator::SkipWait(std::uint64_t budget) {
+  // Nothing but the wait would run until the keys are latched again, so the
+  // rest of the frame passes at once. The clock and timers end up exactly
+  // where running the wait over and over would leave them.
+  const auto count = std::min(budget, mScheduler.InstructionsUntilFrame());
+  PassInstructions(count);
+  return count;
+}
 
+std::uint64_t Emulator::SkipIdleLoop(const IdleLoop &loop,
+                                     std::uint64_t budget) {
+  if (loop.length == 0) {
+    return 0;
+  }
+  auto &registers = mState.registers;
+  const auto perFrame = mScheduler.GetInstructionsPerFrame();
+  const auto untilFrame = mScheduler.InstructionsUntilFrame();
+  // Timer ticks before the pass starting offset instructions from now.
+  const auto ticks = [&](std::uint64_t offset) -> std::uint64_t {
+    return offset < untilFrame ? 0 : 1 + (offset - untilFrame) / perFrame;
+  };
+  // Whole passes only, the rest of the budget runs as usual.
+  auto passes = budget / loop.length;
+  if (loop.readsDelay) {
+    // The first pass that reads a delay passing the test leaves the loop,
+    // the passes up to the tick giving that delay are skipped. A loop no
+    // delay down to 0 leaves runs for good, like a jump to itself.
+    for (std::uint64_t frames = 0; frames <= registers.VDelay; ++frames) {
+      if (!loop.Leaves(registers,
+                       static_cast<std::uint8_t>(registers.VDelay - frames))) {
+        continue;
+      }
+      if (frames == 0) {
+        return 0;
+      }
+      const auto leaving = untilFrame + (frames - 1) * perFrame;
+      passes = std::min(passes, (leaving + loop.length - 1) / loop.length);
+      break;
+    }
+  }
+  if (passes == 0) {
+    return 0;
+  }
+  if (loop.readsDelay) {
+    // What the last skipped pass read, the timer has not ticked yet.
+    const auto ticked = std::min<std::uint64_t>(
+        registers.VDelay, ticks((passes - 1) * loop.length));
+    registers.V[loop.x] = static_cast<std::uint8_t>(registers.VDelay - ticked);
+  }
+  const auto skipped = passes * loop.length;
+  PassInstructions(skipped);
+  return skipped;
+}
+
+void Emulator::PassInstructions(std::uint64_t instructions) {
+  // Frame by frame, so timers tick, paced runs wait and keys are latched
+  // exactly as if the instructions had run.
+  while (instructions > 0) {
+    const auto count =
+        std::min(instructions, mScheduler.InstructionsUntilFrame());
+    instructions -= count;
+    if (mScheduler.Advance(count)) {
+      EndFrame();
+    }
+  }
+}
+
+bool Emulator::IsWaitingForKey() const {
+  const auto pc = mState.registers.PC;
+  return mState.pressedKeys == 0 && mState.memory.IsValidAddress(pc) &&
+         mState.memory.IsValidAddress(pc + 1) &&
+         Instructions::Decode(mState.memory.Fetch(pc)).opcode ==
+             Instructions::Opcode::LDx0;
+}
+
+void Emulator::PassFrames(std::uint64_t frames) {
+  assert(IsWaitingForKey() && "Frames only pass without running while waiting");
+  auto &registers = mState.registers;
+  registers.VDelay -= static_cast<std::uint8_t>(
+      std::min<std::uint64_t>(registers.VDelay, frames));
+  registers.VSound -= static_cast<std::uint8_t>(
+      std::min<std::uint64_t>(registers.VSound, frames));
+  mScheduler.SkipFrames(frames);
+}
+
+bool Emulator::Step() {
+  const auto pc = mState.registers.PC;
+  if (!mState.memory.IsValidAddress(pc) ||
+      !mState.memory.IsValidAddress(pc + 1)) {
+    return false;
+  }
+  const bool executed =
+      mTraceLevel == TraceLevel::Off ? Execute() : ExecuteTraced();
+  if (executed && mScheduler.Advance()) {
+    EndFrame();
+  }
+  return executed;
+}
+
+bool Emulator::Execute() {
+  switch (mEngine) {
+  case Engine::Instructions: {
+    auto *instruction = GetNextInstruction();
+    const auto opcode = instruction->GetOpcode();
+    // Halts on an opcode without an implementation or on a call or return
+    // the stack has no room for, like the interpreter.
+    if (Instructions::GetHandler(opcode) == nullptr ||
+        !Instructions::Semantics::FitsStack(mState, opcode)) {
+      return false;
+    }
     ExecuteInstruction(instruction);
+    return true;
+  }
+  case Engine::Interpreter:
+  case Engine::Threaded:
+    return InterpretInstruction();
+  }
+  return false;
+}
 
-    if (dumpState) {
-      DumpState(std::cout);
+bool Emulator::ExecuteTraced() {
+  auto &registers = mState.registers;
+  const auto pc = registers.PC;
+  const auto word = mState.memory.Fetch(pc);
+  const auto before = registers.V;
+  if (!Execute()) {
+    return false;
+  }
+  TraceRecord record{mScheduler.GetClock().instructions,
+                     pc,
+                     word,
+                     registers.I,
+                     no_register,
+                     0,
+                     registers.V[0xF]};
+  for (std::uint8_t index = 0; index < 0xF; ++index) {
+    if (registers.V[index] != before[index]) {
+      record.changedRegister = index;
+      record.changedValue = registers.V[index];
+      break;
     }
+  }
+  mTracer->Record(record);
+  return true;
+}
 
-    delete instruction;
+bool Emulator::StartTrace(const std::filesystem::path &path,
+                          TraceFormat format) {
+  StopTrace();
+  auto tracer = std::make_unique<Tracer>();
+  if (!tracer->Open(path, format)) {
+    return false;
+  }
+  mTracer = std::move(tracer);
+  mTraceLevel = TraceLevel::Instructions;
+  return true;
+}
+
+void Emulator::StopTrace() {
+  mTraceLevel = TraceLevel::Off;
+  mTracer.reset();
+}
+
+void Emulator::SetTraceLevel(TraceLevel level) {
+  // Without a trace to write to there is nothing to record.
+  mTraceLevel = mTracer ? level : TraceLevel::Off;
+}
+
+void Emulator::EndFrame() {
+  // The timers count down at 60Hz until they reach zero.
+  auto &registers = mState.registers;
+  if (registers.VDelay > 0) {
+    registers.VDelay -= 1;
   }
+  if (registers.VSound > 0) {
+    registers.VSound -= 1;
+  }
+  mScheduler.WaitForFrame();
+  // Latched after waiting, so keys pressed meanwhile make this frame.
+  LatchKeys();
+}
+
+void Emulator::LatchKeys() {
+  if (mKeys == nullptr) {
+    return;
+  }
+  const auto latch = mKeys->Latch();
+  mState.keys = latch.GetDown();
+  mState.pressedKeys = latch.pressed;
+}
+
+Snapshot Emulator::TakeSnapshot() {
+  return {mState.registers, mState.memory.TakeSnapshot(), mState.display,
+          mScheduler.GetClock(), mState.random, mState.keys,
+          mState.pressedKeys};
+}
+
+void Emulator::RestoreSnapshot(const Snapshot &snapshot) {
+  mState.registers = snapshot.registers;
+  // Restoring marks the replaced memory as written, which invalidates the
+  // blocks compiled from it on the next run.
+  mState.memory.RestoreSnapshot(snapshot.memory);
+  mState.display.Restore(snapshot.display);
+  mState.random = snapshot.random;
+  mState.keys = snapshot.keys;
+  mState.pressedKeys = snapshot.pressedKeys;
+  mScheduler.SetClock(snapshot.clock);
 }
 
 Instructions::Instruction *Emulator::GetNextInstruction() {
-  auto instructionBytes = mState.memory.ReadUint16(mState.registers.PC);
-  return Disassembler::Disassemble(instructionBytes, mState.registers.PC);
+  auto instructionBytes = mState.memory.Fetch(mState.registers.PC);
+  return mInstructions.Get(mState.registers.PC, instructionBytes);
 }
 
 void Emulator::ExecuteInstruction(Instructions::Instruction *instruction) {
@@ -101,28 +429,39 @@ void Emulator::ExecuteInstruction(Instructions::Instruction *instruction) {
   mState.registers.PC += Instructions::instruction_size;
 }
 
+bool Emulator::InterpretInstruction() {
+  const auto instruction =
+      Instructions::Decode(mState.memory.Fetch(mState.registers.PC));
+  if (!Interpreter::Execute(instruction, mState)) {
+    return false;
+  }
+  mState.registers.PC += Instructions::instruction_size;
+  return true;
+}
+
 void Emulator::DumpState(std::ostream &os) {
   os << "Dump registers: \n"
-     << "\tV0: 0x" << std::hex << (std::uint16_t)mState.registers.V0
-     << "\tV1: 0x" << std::hex << (std::uint16_t)mState.registers.V1
-     << "\tV2: 0x" << std::hex << (std::uint16_t)mState.registers.V2
-     << "\tV3: 0x" << std::hex << (std::uint16_t)mState.registers.V3 << "\n"
-     << "\tV4: 0x" << std::hex << (std::uint16_t)mState.registers.V4
-     << "\tV5: 0x" << std::hex << (std::uint16_t)mState.registers.V5
-     << "\tV6: 0x" << std::hex << (std::uint16_t)mState.registers.V6
-     << "\tV7: 0x" << std::hex << (std::uint16_t)mState.registers.V7 << "\n"
-     << "\tV8: 0x" << std::hex << (std::uint16_t)mState.registers.V8
-     << "\tV9: 0x" << std::hex << (std::uint16_t)mState.registers.V9
-     << "\tVA: 0x" << std::hex << (std::uint16_t)mState.registers.VA << "\n"
-     << "\tVB: 0x" << std::hex << (std::uint16_t)mState.registers.VB
-     << "\tVC: 0x" << std::hex << (std::uint16_t)mState.registers.VC
-     << "\tVD: 0x" << std::hex << (std::uint16_t)mState.registers.VD << "\n"
-     << "\tVE: 0x" << std::hex << (std::uint16_t)mState.registers.VE
-     << "\tVF: 0x" << std::hex << (std::uint16_t)mState.registers.VF << "\n";
+     << "\tV0: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x0]
+     << "\tV1: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x1]
+     << "\tV2: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x2]
+     << "\tV3: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x3] << "\n"
+     << "\tV4: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x4]
+     << "\tV5: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x5]
+     << "\tV6: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x6]
+     << "\tV7: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x7] << "\n"
+     << "\tV8: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x8]
+     << "\tV9: 0x" << std::hex << (std::uint16_t)mState.registers.V[0x9]
+     << "\tVA: 0x" << std::hex << (std::uint16_t)mState.registers.V[0xA] << "\n"
+     << "\tVB: 0x" << std::hex << (std::uint16_t)mState.registers.V[0xB]
+     << "\tVC: 0x" << std::hex << (std::uint16_t)mState.registers.V[0xC]
+     << "\tVD: 0x" << std::hex << (std::uint16_t)mState.registers.V[0xD]
+     << "\n"
+     << "\tVE: 0x" << std::hex << (std::uint16_t)mState.registers.V[0xE]
+     << "\tVF: 0x" << std::hex << (std::uint16_t)mState.registers.V[0xF]
+     << "\n";
 }
 
 bool Emulator::LoadSprites() {
-  std::cout << "Loading Sprites" << std::endl;
   if (!mState.memory.LoadSprite(Output::Sprites::sprite_0_address,
                                 Output::Sprites::sprite_0)) {
     return false;
@@ -0,0 +1,639 @@
+#include "Emulator/Fleet.h"
+#include <Instructions/Instruction.h>
+#include <Output/Sprites.h>
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+
+namespace emulator {
+
+namespace {
+using Instructions::Opcode;
+using Instructions::instruction_size;
+
+constexpr std::uint16_t no_group = 0xFFFF;
+constexpr std::size_t random_words = 4;
+constexpr std::size_t huge_page_size = 2 << 20;
+
+/// Maps size bytes of zeroed memory, on huge pages when the host has them.
+std::uint8_t *AllocateSlab(std::size_t size) {
+  void *slab = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  // Only succeeds when huge pages were reserved for the system.
+  slab = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+  if (slab == MAP_FAILED) {
+    slab = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slab == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(slab, size, MADV_HUGEPAGE);
+#endif
+  }
+  return static_cast<std::uint8_t *>(slab);
+}
+
+bool IsValidPc(std::uint16_t pc) {
+  return pc >= cpu::memory_start && pc + 1U < cpu::memory_size;
+}
+
+bool IsStackOpcode(Instructions::Opcode opcode) {
+  return opcode == Instructions::Opcode::CALL ||
+         opcode == Instructions::Opcode::RET;
+}
+
+} // namespace
+
+Fleet::Fleet(std::size_t size)
+    : mSize(size), mV(cpu::register_count * size), mI(size), mPC(size),
+      mDelay(size), mSound(size), mSP(size), mStack(cpu::stack_size * size),
+      mRandom(random_words * size), mKeys(size), mPressedKeys(size),
+      mDisplays(size),
+      mHalted(size), mHaltedAt(size),
+      mMemoryBytes((std::max<std::size_t>(size, 1) * memory_stride +
+                    huge_page_size - 1) /
+                   huge_page_size * huge_page_size),
+      mImage{}, mWrittenLines{}, mGroupOf(0x10000, no_group) {
+  mMemory = AllocateSlab(mMemoryBytes);
+  mRunning.reserve(fleet_batch_size);
+  mWords.reserve(fleet_batch_size);
+  mGrouped.resize(fleet_batch_size);
+  mGroups.reserve(fleet_batch_size);
+}
+
+Fleet::~Fleet() { munmap(mMemory, mMemoryBytes); }
+
+// A contiguous range lets the compiler vectorise the loop over the machines.
+template <typename Body> void Fleet::ForEach(Range machines, Body &&body) {
+  for (auto machine = machines.begin; machine < machines.end; ++machine) {
+    body(machine);
+  }
+}
+
+template <typename Body>
+void Fleet::ForEach(std::span<const std::uint32_t> machines, Body &&body) {
+  for (auto machine : machines) {
+    body(machine);
+  }
+}
+
+bool Fleet::LoadGame(const std::filesystem::path &path) {
+  auto emulator = std::make_unique<Emulator>();
+  if (!emulator->LoadGame(path)) {
+    return false;
+  }
+  Reset(emulator->TakeSnapshot());
+  return true;
+}
+
+void Fleet::Reset(const Snapshot &snapshot) {
+  for (std::size_t page = 0; page < cpu::page_count; ++page) {
+    std::copy(snapshot.memory.pages[page]->begin(),
+              snapshot.memory.pages[page]->end(),
+              mImage.begin() + page * cpu::page_size);
+  }
+  mWrittenLines = {};
+  mScheduler.SetClock(snapshot.clock);
+  for (std::size_t machine = 0; machine < mSize; ++machine) {
+    Restore(machine, snapshot);
+  }
+}
+
+void Fleet::Restore(std::size_t machine, const Snapshot &snapshot) {
+  const auto &registers = snapshot.registers;
+  for (std::uint8_t index = 0; index < cpu::register_count; ++index) {
+    V(index)[machine] = registers.V[index];
+  }
+  mI[machine] = registers.I;
+  mPC[machine] = registers.PC;
+  mDelay[machine] = registers.VDelay;
+  mSound[machine] = registers.VSound;
+  mSP[machine] = registers.SP;
+  for (std::size_t level = 0; level < cpu::stack_size; ++level) {
+    mStack[level * mSize + machine] = snapshot.memory.stack[level];
+  }
+  for (std::size_t word = 0; word < random_words; ++word) {
+    mRandom[word * mSize + machine] = snapshot.random.GetState()[word];
+  }
+  mDisplays[machine].Restore(snapshot.display);
+  mKeys[machine] = snapshot.keys;
+  mPressedKeys[machine] = snapshot.pressedKeys;
+  mHalted[machine] = 0;
+
+  auto *memory = GetMemory(machine);
+  for (std::size_t page = 0; page < cpu::page_count; ++page) {
+    std::copy(snapshot.memory.pages[page]->begin(),
+              snapshot.memory.pages[page]->end(),
+              memory + page * cpu::page_size);
+  }
+  // Lines that differ from the image are fetched from the machines.
+  for (std::size_t line = 0; line < cpu::line_count; ++line) {
+    const auto offset = line * cpu::line_size;
+    if (!std::equal(memory + offset, memory + offset + cpu::line_size,
+                    mImage.begin() + offset)) {
+      mWrittenLines[line / 64] |= 1ULL << (line % 64);
+    }
+  }
+}
+
+void Fleet::Seed(std::size_t machine, std::uint64_t seed) {
+  const cpu::Random random(seed);
+  for (std::size_t word = 0; word < random_words; ++word) {
+    mRandom[word * mSize + machine] = random.GetState()[word];
+  }
+}
+
+cpu::Random Fleet::GetRandom(std::size_t machine) const {
+  std::array<std::uint32_t, random_words> state;
+  for (std::size_t word = 0; word < random_words; ++word) {
+    state[word] = mRandom[word * mSize + machine];
+  }
+  cpu::Random random;
+  random.SetState(state);
+  return random;
+}
+
+std::size_t Fleet::GetRunningCount() const {
+  return mSize - std::count(mHalted.begin(), mHalted.end(), 1);
+}
+
+std::uint64_t Fleet::GetInstructions(std::size_t machine) const {
+  return mHalted[machine] ? mHaltedAt[machine]
+                          : mScheduler.GetClock().instructions;
+}
+
+cpu::Registers Fleet::GetRegisters(std::size_t machine) const {
+  cpu::Registers registers;
+  for (std::size_t index = 0; index < cpu::register_count; ++index) {
+    registers.V[index] = mV[index * mSize + machine];
+  }
+  registers.I = mI[machine];
+  registers.PC = mPC[machine];
+  registers.VDelay = mDelay[machine];
+  registers.VSound = mSound[machine];
+  registers.SP = mSP[machine];
+  return registers;
+}
+
+std::uint64_t Fleet::RunFor(std::uint64_t instructions) {
+  if (GetRunningCount() == 0) {
+    return 0;
+  }
+  // Every batch runs the whole budget from the same clock before the next
+  // one starts, so its registers stay cached throughout.
+  std::uint64_t executed = 0;
+  for (std::size_t begin = 0; begin < mSize; begin += fleet_batch_size) {
+    const auto end = std::min(begin + fleet_batch_size, mSize);
+    auto scheduler = mScheduler;
+    executed += RunBatch({static_cast<std::uint32_t>(begin),
+                          static_cast<std::uint32_t>(end)},
+                         instructions, scheduler);
+  }
+  for (auto remaining = instructions; remaining > 0;) {
+    const auto count = std::min(remaining, mScheduler.InstructionsUntilFrame());
+    mScheduler.Advance(count);
+    remaining -= count;
+  }
+  return executed;
+}
+
+std::uint64_t Fleet::RunBatch(Range batch, std::uint64_t instructions,
+                              Scheduler &scheduler) {
+  mRunning.clear();
+  for (auto machine = batch.begin; machine < batch.end; ++machine) {
+    if (!mHalted[machine]) {
+      mRunning.push_back(machine);
+    }
+  }
+
+  std::uint64_t executed = 0;
+  for (std::uint64_t step = 0; step < instructions && !mRunning.empty();
+       ++step) {
+    if (Step(batch, scheduler.GetClock().instructions)) {
+      std::erase_if(mRunning, [this](std::uint32_t machine) {
+        return mHalted[machine] != 0;
+      });
+    }
+    executed += mRunning.size();
+    if (scheduler.Advance()) {
+      if (mRunning.size() == batch.end - batch.begin) {
+        TickTimers(batch);
+      } else {
+        TickTimers(std::span<const std::uint32_t>(mRunning));
+      }
+    }
+  }
+  return executed;
+}
+
+bool Fleet::Step(Range batch, std::uint64_t clock) {
+  // Machines running the same program mostly stay at the same PC, which
+  // needs neither fetching from every memory nor grouping.
+  if (mRunning.size() == batch.end - batch.begin) {
+    const auto pc = mPC[batch.begin];
+    bool together = true;
+    for (auto machine = batch.begin; machine < batch.end; ++machine) {
+      together &= mPC[machine] == pc;
+    }
+    if (together && IsValidPc(pc) && IsShared(pc)) {
+      const auto instruction = Instructions::Decode(Fetch(batch.begin, pc));
+      bool fits = true;
+      if (IsStackOpcode(instruction.opcode)) {
+        for (auto machine = batch.begin; machine < batch.end; ++machine) {
+          fits &= FitsStack(machine, instruction.opcode);
+        }
+      }
+      // Machines about to fault on their stack halt one by one below.
+      if (fits) {
+        if (Execute(instruction, batch)) {
+          return false;
+        }
+        for (auto machine : mRunning) {
+          Halt(machine, clock);
+        }
+        return true;
+      }
+    }
+  }
+
+  // Count the machines per instruction word, then lay out their indices
+  // group after group, in machine order within each group.
+  bool halted = false;
+  mGroups.clear();
+  mWords.resize(mRunning.size());
+  for (std::size_t index = 0; index < mRunning.size(); ++index) {
+    const auto machine = mRunning[index];
+    const auto pc = mPC[machine];
+    if (!IsValidPc(pc)) {
+      Halt(machine, clock);
+      halted = true;
+      continue;
+    }
+    const auto word = Fetch(machine, pc);
+    mWords[index] = word;
+    auto &group = mGroupOf[word];
+    if (group == no_group) {
+      group = static_cast<std::uint16_t>(mGroups.size());
+      mGroups.push_back({word, 0, 0});
+    }
+    ++mGroups[group].count;
+  }
+  std::uint32_t offset = 0;
+  for (auto &group : mGroups) {
+    group.begin = offset;
+    offset += group.count;
+    group.count = 0;
+  }
+  for (std::size_t index = 0; index < mRunning.size(); ++index) {
+    const auto machine = mRunning[index];
+    if (mHalted[machine]) {
+      continue;
+    }
+    auto &group = mGroups[mGroupOf[mWords[index]]];
+    mGrouped[group.begin + group.count++] = machine;
+  }
+
+  for (const auto &group : mGroups) {
+    mGroupOf[group.word] = no_group;
+    const auto instruction = Instructions::Decode(group.word);
+    auto *grouped = &mGrouped[group.begin];
+    auto count = group.count;
+    if (IsStackOpcode(instruction.opcode)) {
+      // Machines whose stack has no room halt on the call or return.
+      const auto *fitting =
+          std::partition(grouped, grouped + count,
+                         [this, &instruction](std::uint32_t machine) {
+                           return FitsStack(machine, instruction.opcode);
+                         });
+      for (const auto *machine = fitting; machine != grouped + count;
+           ++machine) {
+        Halt(*machine, clock);
+        halted = true;
+      }
+      count = static_cast<std::uint32_t>(fitting - grouped);
+      if (count == 0) {
+        continue;
+      }
+    }
+    const std::span<const std::uint32_t> machines(grouped, count);
+    const bool executed = count == batch.end - batch.begin
+                              ? Execute(instruction, batch)
+                              : Execute(instruction, machines);
+    if (!executed) {
+      for (auto machine : machines) {
+        Halt(machine, clock);
+      }
+      halted = true;
+    }
+  }
+  return halted;
+}
+
+void Fleet::Halt(std::uint32_t machine, std::uint64_t clock) {
+  mHalted[machine] = 1;
+  mHaltedAt[machine] = clock;
+}
+
+template <typename Machines>
+void Fleet::TickTimers(const Machines &machines) {
+  // The timers count down at 60Hz until they reach zero.
+  auto *delay = mDelay.data();
+  auto *sound = mSound.data();
+  ForEach(machines, [delay](std::uint32_t machine) {
+    delay[machine] -= delay[machine] != 0;
+  });
+  ForEach(machines, [sound](std::uint32_t machine) {
+    sound[machine] -= sound[machine] != 0;
+  });
+}
+
+template <typename Machines>
+bool Fleet::Execute(const Instructions::DecodedInstruction &instruction,
+                    const Machines &machines) {
+  // The same semantics as Instructions/Semantics.h, applied to every machine
+  // of the group. Registers are read and written in the same order, so
+  // instructions with x or y equal to F behave the same.
+  const auto x = instruction.x;
+  const auto kk = instruction.kk;
+  const auto nnn = instruction.nnn;
+  auto *vx = V(x);
+  auto *vy = V(instruction.y);
+  auto *vf = V(0xF);
+  auto *pc = mPC.data();
+  auto *sp = mSP.data();
+  auto *regI = mI.data();
+  auto next = [&machines, pc] {
+    ForEach(machines,
+            [pc](std::uint32_t machine) { pc[machine] += instruction_size; });
+  };
+  auto skipIf = [&machines, pc](auto condition) {
+    ForEach(machines, [pc, &condition](std::uint32_t machine) {
+      pc[machine] += condition(machine) ? 2 * instruction_size
+                                        : instruction_size;
+    });
+  };
+
+  switch (instruction.opcode) {
+  case Opcode::CLS:
+    ForEach(machines,
+            [this](std::uint32_t machine) { mDisplays[machine].Clear(); });
+    next();
+    return true;
+  case Opcode::RET:
+    ForEach(machines, [this, pc, sp](std::uint32_t machine) {
+      // Step halted the machines without a call to return from.
+      pc[machine] = mStack[sp[machine] * mSize + machine] + instruction_size;
+      sp[machine] -= 1;
+    });
+    return true;
+  case Opcode::JP:
+    ForEach(machines, [pc, nnn](std::uint32_t machine) { pc[machine] = nnn; });
+    return true;
+  case Opcode::JPV0: {
+    const auto *v0 = V(0x0);
+    ForEach(machines, [pc, v0, nnn](std::uint32_t machine) {
+      pc[machine] = nnn + v0[machine];
+    });
+    return true;
+  }
+  case Opcode::RND: {
+    auto *s0 = &mRandom[0];
+    auto *s1 = &mRandom[mSize];
+    auto *s2 = &mRandom[2 * mSize];
+    auto *s3 = &mRandom[3 * mSize];
+    ForEach(machines, [vx, kk, s0, s1, s2, s3](std::uint32_t machine) {
+      vx[machine] = cpu::Random::ToByte(cpu::Random::Next(
+                        s0[machine], s1[machine], s2[machine], s3[machine])) &
+                    kk;
+    });
+    next();
+    return true;
+  }
+  case Opcode::CALL:
+    ForEach(machines, [this, pc, sp, nnn](std::uint32_t machine) {
+      // Step halted the machines with a full stack.
+      sp[machine] += 1;
+      mStack[sp[machine] * mSize + machine] = pc[machine];
+      pc[machine] = nnn;
+    });
+    return true;
+  case Opcode::SExkk:
+    skipIf([vx, kk](std::uint32_t machine) { return vx[machine] == kk; });
+    return true;
+  case Opcode::SExy:
+    skipIf([vx, vy](std::uint32_t machine) {
+      return vx[machine] == vy[machine];
+    });
+    return true;
+  case Opcode::SNExkk:
+    skipIf([vx, kk](std::uint32_t machine) { return vx[machine] != kk; });
+    return true;
+  case Opcode::SNExy:
+    skipIf([vx, vy](std::uint32_t machine) {
+      return vx[machine] != vy[machine];
+    });
+    return true;
+  case Opcode::SKP: {
+    const auto *keys = mKeys.data();
+    skipIf([vx, keys](std::uint32_t machine) {
+      return ((keys[machine] >> (vx[machine] & 0xF)) & 1) != 0;
+    });
+    return true;
+  }
+  case Opcode::SKNP: {
+    const auto *keys = mKeys.data();
+    skipIf([vx, keys](std::uint32_t machine) {
+      return ((keys[machine] >> (vx[machine] & 0xF)) & 1) == 0;
+    });
+    return true;
+  }
+  case Opcode::LDxkk:
+    ForEach(machines, [vx, kk](std::uint32_t machine) { vx[machine] = kk; });
+    next();
+    return true;
+  case Opcode::LDxy:
+    ForEach(machines,
+            [vx, vy](std::uint32_t machine) { vx[machine] = vy[machine]; });
+    next();
+    return true;
+  case Opcode::LDnnn:
+    ForEach(machines,
+            [regI, nnn](std::uint32_t machine) { regI[machine] = nnn; });
+    next();
+    return true;
+  case Opcode::LDxdt: {
+    const auto *delay = mDelay.data();
+    ForEach(machines, [vx, delay](std::uint32_t machine) {
+      vx[machine] = delay[machine];
+    });
+    next();
+    return true;
+  }
+  case Opcode::LDx0: {
+    // Machines without a press stay on the instruction, like the emulator.
+    auto *pressed = mPressedKeys.data();
+    ForEach(machines, [vx, pc, pressed](std::uint32_t machine) {
+      if (pressed[machine] == 0) {
+        return;
+      }
+      vx[machine] =
+          static_cast<std::uint8_t>(std::countr_zero(pressed[machine]));
+      pressed[machine] = 0;
+      pc[machine] += instruction_size;
+    });
+    return true;
+  }
+  case Opcode::LDdtx: {
+    auto *delay = mDelay.data();
+    ForEach(machines, [vx, delay](std::uint32_t machine) {
+      delay[machine] = vx[machine];
+    });
+    next();
+    return true;
+  }
+  case Opcode::LDstx: {
+    auto *sound = mSound.data();
+    ForEach(machines, [vx, sound](std::uint32_t machine) {
+      sound[machine] = vx[machine];
+    });
+    next();
+    return true;
+  }
+  case Opcode::LDfx:
+    ForEach(machines, [vx, regI](std::uint32_t machine) {
+      regI[machine] = Output::Sprites::sprite_0_address +
+                      (vx[machine] & 0xF) * Output::Sprites::sprite_size;
+    });
+    next();
+    return true;
+  case Opcode::LDbx:
+    ForEach(machines, [this, vx, regI](std::uint32_t machine) {
+      const auto value = vx[machine];
+      const auto address = regI[machine];
+      Store(machine, address, value / 100);
+      Store(machine, address + 1, (value / 10) % 10);
+      Store(machine, address + 2, value % 10);
+    });
+    next();
+    return true;
+  case Opcode::LDix:
+    ForEach(machines, [this, x, regI](std::uint32_t machine) {
+      for (std::uint8_t index = 0; index <= x; ++index) {
+        Store(machine, regI[machine] + index, V(index)[machine]);
+      }
+    });
+    next();
+    return true;
+  case Opcode::LDxi:
+    ForEach(machines, [this, x, regI](std::uint32_t machine) {
+      const auto *memory = GetMemory(machine);
+      for (std::uint8_t index = 0; index <= x; ++index) {
+        V(index)[machine] =
+            memory[(regI[machine] + index) & cpu::address_mask];
+      }
+    });
+    next();
+    return true;
+  case Opcode::ADDxkk:
+    ForEach(machines, [vx, kk](std::uint32_t machine) {
+      vx[machine] = vx[machine] + kk;
+    });
+    next();
+    return true;
+  case Opcode::ADDxy:
+    ForEach(machines, [vx, vy, vf](std::uint32_t machine) {
+      const std::uint16_t sum = vx[machine] + vy[machine];
+      vf[machine] = sum > 0xFF ? 1 : 0;
+      vx[machine] = static_cast<std::uint8_t>(sum & 0xFF);
+    });
+    next();
+    return true;
+  case Opcode::ADDix:
+    ForEach(machines, [vx, regI](std::uint32_t machine) {
+      regI[machine] = regI[machine] + vx[machine];
+    });
+    next();
+    return true;
+  case Opcode::OR:
+    ForEach(machines,
+            [vx, vy](std::uint32_t machine) { vx[machine] |= vy[machine]; });
+    next();
+    return true;
+  case Opcode::AND:
+    ForEach(machines,
+            [vx, vy](std::uint32_t machine) { vx[machine] &= vy[machine]; });
+    next();
+    return true;
+  case Opcode::XOR:
+    ForEach(machines,
+            [vx, vy](std::uint32_t machine) { vx[machine] ^= vy[machine]; });
+    next();
+    return true;
+  case Opcode::SUB:
+    ForEach(machines, [vx, vy, vf](std::uint32_t machine) {
+      const auto regy = vy[machine];
+      vf[machine] = vx[machine] >= regy ? 1 : 0;
+      vx[machine] = vx[machine] - regy;
+    });
+    next();
+    return true;
+  case Opcode::SUBN:
+    ForEach(machines, [vx, vy, vf](std::uint32_t machine) {
+      const auto regy = vy[machine];
+      vf[machine] = regy >= vx[machine] ? 1 : 0;
+      vx[machine] = regy - vx[machine];
+    });
+    next();
+    return true;
+  case Opcode::SHR:
+    ForEach(machines, [vx, vf](std::uint32_t machine) {
+      vf[machine] = vx[machine] & 1;
+      vx[machine] = vx[machine] >> 1;
+    });
+    next();
+    return true;
+  case Opcode::SHL:
+    ForEach(machines, [vx, vf](std::uint32_t machine) {
+      vf[machine] = (vx[machine] & 0b1000'0000) ? 1 : 0;
+      vx[machine] = vx[machine] << 1;
+    });
+    next();
+    return true;
+  case Opcode::DRW:
+    ForEach(machines, [this, vx, vy, vf, regI, &instruction](
+                          std::uint32_t machine) {
+      const auto regx = vx[machine];
+      const auto regy = vy[machine];
+      const auto *memory = GetMemory(machine);
+      std::array<std::uint8_t, cpu::mirror_size> sprite;
+      for (std::uint8_t row = 0; row < instruction.n; ++row) {
+        sprite[row] = memory[(regI[machine] + row) & cpu::address_mask];
+      }
+      vf[machine] = mDisplays[machine].Draw(
+                        regx, regy, std::span(sprite.data(), instruction.n))
+                        ? 1
+                        : 0;
+    });
+    next();
+    return true;
+  // Not implemented by the Interpreter either.
+  case Opcode::SYS:
+  case Opcode::SCD:
+  case Opcode::SCR:
+  case Opcode::SCL:
+  case Opcode::EXIT:
+  case Opcode::LOW:
+  case Opcode::HIGH:
+  case Opcode::ILLEGAL:
+    return false;
+  }
+  return false;
+}
+
+} // namespace emulator
@@ -0,0 +1,67 @@
+#include "Emulator/IdleLoop.h"
+
+namespace emulator {
+
+namespace {
+using Instructions::DecodedInstruction;
+using Instructions::Opcode;
+
+bool Fetch(std::uint16_t address, const cpu::Memory &memory,
+           DecodedInstruction &instruction) {
+  if (!memory.IsValidAddress(address) || !memory.IsValidAddress(address + 1)) {
+    return false;
+  }
+  instruction = Instructions::Decode(memory.Fetch(address));
+  return true;
+}
+} // namespace
+
+bool IdleLoop::Leaves(const cpu::Registers &registers,
+                      std::uint8_t delay) const {
+  if (!readsDelay) {
+    return false;
+  }
+  auto V = registers.V;
+  V[x] = delay;
+  switch (test.opcode) {
+  case Opcode::SExkk:
+    return V[test.x] == test.kk;
+  case Opcode::SNExkk:
+    return V[test.x] != test.kk;
+  case Opcode::SExy:
+    return V[test.x] == V[test.y];
+  case Opcode::SNExy:
+    return V[test.x] != V[test.y];
+  default:
+    return true;
+  }
+}
+
+IdleLoop FindIdleLoop(std::uint16_t pc, const cpu::Memory &memory) {
+  constexpr auto size = Instructions::instruction_size;
+  DecodedInstruction first;
+  if (!Fetch(pc, memory, first)) {
+    return {};
+  }
+  if (first.opcode == Opcode::JP) {
+    return first.nnn == pc ? IdleLoop{1} : IdleLoop{};
+  }
+  DecodedInstruction test;
+  DecodedInstruction jump;
+  if (first.opcode != Opcode::LDxdt || !Fetch(pc + size, memory, test) ||
+      !Fetch(pc + 2 * size, memory, jump) || jump.opcode != Opcode::JP ||
+      jump.nnn != pc) {
+    return {};
+  }
+  switch (test.opcode) {
+  case Opcode::SExkk:
+  case Opcode::SNExkk:
+  case Opcode::SExy:
+  case Opcode::SNExy:
+    return {3, true, first.x, test};
+  default:
+    return {};
+  }
+}
+
+} // namespace emulator
@@ -0,0 +1,33 @@
+#include "Emulator/InstructionCache.h"
+#include <CPU/Memory.h>
+#include <Instructions/Disassembler.h>
+
+#include <cassert>
+
+namespace emulator {
+
+InstructionCache::InstructionCache() {
+  mInstructions.resize(cpu::memory_size, nullptr);
+}
+
+InstructionCache::~InstructionCache() { Clear(); }
+
+Instructions::Instruction *InstructionCache::Get(std::uint16_t address,
+                                                 std::uint16_t data) {
+  assert(address < mInstructions.size() && "Address outside of memory");
+  auto *&instruction = mInstructions[address];
+  if (instruction == nullptr || instruction->GetData() != data) {
+    delete instruction;
+    instruction = Disassembler::Disassemble(data, address);
+  }
+  return instruction;
+}
+
+void InstructionCache::Clear() {
+  for (auto *&instruction : mInstructions) {
+    delete instruction;
+    instruction = nullptr;
+  }
+}
+
+} // namespace emulator
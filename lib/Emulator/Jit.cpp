@@ -0,0 +1,628 @@
+#include "Emulator/Jit.h"
+#include "Emulator/BlockCache.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define EMULATOR_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace emulator::jit {
+
+#ifdef EMULATOR_JIT_X86_64
+
+namespace {
+
+using Instructions::DecodedInstruction;
+using Instructions::Opcode;
+
+// Host registers as numbered in instruction encodings.
+enum HostRegister : std::uint8_t {
+  rax = 0,
+  rcx,
+  rdx,
+  rbx,
+  rsp,
+  rbp,
+  rsi,
+  rdi,
+  r8,
+  r9,
+  r10,
+  r11,
+  r12,
+  r13,
+  r14,
+  r15,
+};
+
+// Condition codes of jcc and setcc.
+enum Condition : std::uint8_t {
+  below = 0x2,
+  above_equal = 0x3,
+  equal = 0x4,
+  not_equal = 0x5,
+};
+
+// Arithmetic operations by their "op r/m8, r8" opcode.
+enum AluOp : std::uint8_t {
+  alu_add = 0x00,
+  alu_or = 0x08,
+  alu_and = 0x20,
+  alu_sub = 0x28,
+  alu_xor = 0x30,
+  alu_cmp = 0x38,
+};
+
+// Both are callee saved so they survive calls to the handlers.
+constexpr HostRegister registers_base = rbx;
+constexpr HostRegister state_base = rbp;
+// Where the guest registers a block uses are kept, in order of assignment.
+constexpr std::array<HostRegister, max_block_registers> guest_homes = {
+    r12, r13, r14, r15, rsi, rdi, r8, r9, r10, r11};
+
+constexpr auto vf = 0xF;
+constexpr std::uint8_t pc_offset = offsetof(cpu::Registers, PC);
+constexpr std::uint8_t i_offset = offsetof(cpu::Registers, I);
+constexpr std::uint8_t v_offset = offsetof(cpu::Registers, V);
+
+/// Emits the handful of x86-64 instructions the blocks need. Byte sized
+/// operations always carry a REX prefix so sil and dil can be used.
+class Assembler {
+public:
+  const std::vector<std::uint8_t> &GetCode() const { return mCode; }
+  std::size_t GetPosition() const { return mCode.size(); }
+
+  void MovImm8(HostRegister reg, std::uint8_t value) {
+    Rex(rax, reg);
+    Emit(0xB0 + (reg & 7));
+    Emit(value);
+  }
+  void MovReg8(HostRegister dst, HostRegister src) { Alu(0x88, dst, src); }
+  void Alu(std::uint8_t op, HostRegister dst, HostRegister src) {
+    Rex(src, dst);
+    Emit(op);
+    Emit(0xC0 | (src & 7) << 3 | (dst & 7));
+  }
+  /// The "op r/m8, imm8" group, extension selects the operation.
+  void AluImm8(std::uint8_t extension, HostRegister dst, std::uint8_t value) {
+    Rex(rax, dst);
+    Emit(0x80);
+    Emit(0xC0 | extension << 3 | (dst & 7));
+    Emit(value);
+  }
+  void Shl1(HostRegister reg) { Shift(4, reg); }
+  void Shr1(HostRegister reg) { Shift(5, reg); }
+  void SetCc(Condition condition, HostRegister reg) {
+    Rex(rax, reg);
+    Emit(0x0F);
+    Emit(0x90 | condition);
+    Emit(0xC0 | (reg & 7));
+  }
+  /// mov reg8, [registers_base + offset]
+  void LoadByte(HostRegister reg, std::uint8_t offset) {
+    Rex(reg, registers_base);
+    Emit(0x8A);
+    Base(reg, offset);
+  }
+  /// mov [registers_base + offset], reg8
+  void StoreByte(HostRegister reg, std::uint8_t offset) {
+    Rex(reg, registers_base);
+    Emit(0x88);
+    Base(reg, offset);
+  }
+  /// movzx eax, reg8
+  void MovzxEax(HostRegister reg) {
+    Rex(rax, reg);
+    Emit(0x0F);
+    Emit(0xB6);
+    Emit(0xC0 | (reg & 7));
+  }
+  /// add word [registers_base + offset], ax
+  void AddWordAx(std::uint8_t offset) {
+    Emit(0x66);
+    Emit(0x01);
+    Base(rax, offset);
+  }
+  /// mov word [registers_base + offset], value
+  void MovWord(std::uint8_t offset, std::uint16_t value) {
+    Emit(0x66);
+    Emit(0xC7);
+    Base(rax, offset);
+    Emit(value & 0xFF);
+    Emit(value >> 8);
+  }
+  /// add word [registers_base + offset], value
+  void AddWord(std::uint8_t offset, std::int8_t value) {
+    Emit(0x66);
+    Emit(0x83);
+    Base(rax, offset);
+    Emit(static_cast<std::uint8_t>(value));
+  }
+  void MovEax(std::uint32_t value) {
+    Emit(0xB8);
+    Emit32(value);
+  }
+  void MovImm64(HostRegister reg, std::uint64_t value) {
+    Emit(0x48 | (reg >> 3));
+    Emit(0xB8 + (reg & 7));
+    for (int shift = 0; shift < 64; shift += 8) {
+      Emit(static_cast<std::uint8_t>(value >> shift));
+    }
+  }
+  void MovReg64(HostRegister dst, HostRegister src) {
+    Emit(0x48 | (src >> 3) << 2 | (dst >> 3));
+    Emit(0x89);
+    Emit(0xC0 | (src & 7) << 3 | (dst & 7));
+  }
+  void Push(HostRegister reg) {
+    if (reg >= r8) {
+      Emit(0x41);
+    }
+    Emit(0x50 + (reg & 7));
+  }
+  void Pop(HostRegister reg) {
+    if (reg >= r8) {
+      Emit(0x41);
+    }
+    Emit(0x58 + (reg & 7));
+  }
+  /// add rsp, value, negative values reserve stack.
+  void AddRsp(std::int8_t value) {
+    Emit(0x48);
+    Emit(0x83);
+    Emit(0xC4);
+    Emit(static_cast<std::uint8_t>(value));
+  }
+  void CallRax() {
+    Emit(0xFF);
+    Emit(0xD0);
+  }
+  void Ret() { Emit(0xC3); }
+  /// Jumps to a label bound later, returns the position to patch.
+  std::size_t Jcc(Condition condition) {
+    Emit(0x0F);
+    Emit(0x80 | condition);
+    Emit32(0);
+    return GetPosition() - 4;
+  }
+  std::size_t Jmp() {
+    Emit(0xE9);
+    Emit32(0);
+    return GetPosition() - 4;
+  }
+  /// Points the jump at patch to the current position.
+  void Bind(std::size_t patch) {
+    const auto relative =
+        static_cast<std::uint32_t>(GetPosition() - (patch + 4));
+    std::memcpy(mCode.data() + patch, &relative, sizeof(relative));
+  }
+
+private:
+  void Emit(std::uint8_t byte) { mCode.push_back(byte); }
+  void Emit32(std::uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      Emit(static_cast<std::uint8_t>(value >> shift));
+    }
+  }
+  void Rex(HostRegister reg, HostRegister rm) {
+    Emit(0x40 | (reg >> 3) << 2 | (rm >> 3));
+  }
+  void Shift(std::uint8_t extension, HostRegister reg) {
+    Rex(rax, reg);
+    Emit(0xD0);
+    Emit(0xC0 | extension << 3 | (reg & 7));
+  }
+  // [registers_base + offset] with an 8 bit displacement.
+  void Base(HostRegister reg, std::uint8_t offset) {
+    Emit(0x40 | (reg & 7) << 3 | registers_base);
+    Emit(offset);
+  }
+
+  std::vector<std::uint8_t> mCode;
+};
+
+/// Instructions translated to native code, the rest call their handler.
+/// Those writing VF from operands that include VF keep the handler, the
+/// order of their writes only matters then.
+bool IsNative(const DecodedInstruction &instruction) {
+  switch (instruction.opcode) {
+  case Opcode::JP:
+  case Opcode::SExkk:
+  case Opcode::SNExkk:
+  case Opcode::SExy:
+  case Opcode::SNExy:
+  case Opcode::LDxkk:
+  case Opcode::ADDxkk:
+  case Opcode::LDxy:
+  case Opcode::OR:
+  case Opcode::AND:
+  case Opcode::XOR:
+  case Opcode::LDnnn:
+  case Opcode::ADDix:
+    return true;
+  case Opcode::ADDxy:
+  case Opcode::SUB:
+  case Opcode::SUBN:
+    return instruction.x != vf && instruction.y != vf;
+  case Opcode::SHR:
+  case Opcode::SHL:
+    return instruction.x != vf;
+  default:
+    return false;
+  }
+}
+
+bool SetsFlag(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::ADDxy:
+  case Opcode::SUB:
+  case Opcode::SUBN:
+  case Opcode::SHR:
+  case Opcode::SHL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Guest registers a native instruction reads.
+std::uint16_t Reads(const DecodedInstruction &instruction) {
+  const std::uint16_t x = 1u << instruction.x;
+  const std::uint16_t y = 1u << instruction.y;
+  switch (instruction.opcode) {
+  case Opcode::SExkk:
+  case Opcode::SNExkk:
+  case Opcode::ADDxkk:
+  case Opcode::ADDix:
+  case Opcode::SHR:
+  case Opcode::SHL:
+    return x;
+  case Opcode::LDxy:
+    return y;
+  case Opcode::SExy:
+  case Opcode::SNExy:
+  case Opcode::OR:
+  case Opcode::AND:
+  case Opcode::XOR:
+  case Opcode::ADDxy:
+  case Opcode::SUB:
+  case Opcode::SUBN:
+    return x | y;
+  default:
+    return 0;
+  }
+}
+
+/// Guest registers a native instruction writes.
+std::uint16_t Writes(const DecodedInstruction &instruction) {
+  const std::uint16_t x = 1u << instruction.x;
+  switch (instruction.opcode) {
+  case Opcode::LDxkk:
+  case Opcode::ADDxkk:
+  case Opcode::LDxy:
+  case Opcode::OR:
+  case Opcode::AND:
+  case Opcode::XOR:
+    return x;
+  default:
+    return SetsFlag(instruction.opcode) ? x | 1u << vf : 0;
+  }
+}
+
+/// For each instruction setting VF, whether anything observes the flag
+/// before it is overwritten. Handlers and leaving the block observe every
+/// register.
+std::vector<bool> FlagsObserved(const Block &block) {
+  std::vector<bool> observed(block.code.size(), true);
+  bool live = true;
+  for (auto i = block.code.size(); i-- > 0;) {
+    const auto &instruction = block.code[i].operands;
+    if (!IsNative(instruction)) {
+      live = true;
+      continue;
+    }
+    if (SetsFlag(instruction.opcode)) {
+      observed[i] = live;
+    }
+    if (Writes(instruction) & 1u << vf) {
+      live = false;
+    }
+    if (Reads(instruction) & 1u << vf) {
+      live = true;
+    }
+  }
+  return observed;
+}
+
+class BlockCompiler {
+public:
+  explicit BlockCompiler(const Block &block) : mBlock(block) {}
+
+  bool Compile() {
+    std::uint16_t used = 0;
+    for (const auto &compiled : mBlock.code) {
+      if (IsNative(compiled.operands)) {
+        used |= Reads(compiled.operands) | Writes(compiled.operands);
+      }
+    }
+    if (static_cast<std::size_t>(std::popcount(used)) > max_block_registers) {
+      return false;
+    }
+    for (std::size_t guest = 0, next = 0; guest < cpu::register_count;
+         ++guest) {
+      if (used & 1u << guest) {
+        mHomes[mHomeCount++] = {static_cast<std::uint8_t>(guest),
+                                guest_homes[next++]};
+        mHome[guest] = guest_homes[next - 1];
+      }
+    }
+
+    for (auto reg : {rbx, rbp, r12, r13, r14, r15}) {
+      mAsm.Push(reg);
+    }
+    // Six pushes and the return address leave the stack 8 bytes short of
+    // the alignment calls expect.
+    mAsm.AddRsp(-8);
+    mAsm.MovReg64(registers_base, rdi);
+    mAsm.MovReg64(state_base, rsi);
+    Reload();
+
+    const auto observed = FlagsObserved(mBlock);
+    bool exited = false;
+    for (std::size_t i = 0; i < mBlock.code.size(); ++i) {
+      const auto address =
+          static_cast<std::uint16_t>(mBlock.start + i * 2);
+      const auto &compiled = mBlock.code[i];
+      if (IsNative(compiled.operands)) {
+        exited = Native(compiled.operands, address, i, observed[i]);
+      } else {
+        exited = CallHandler(compiled, address, i);
+      }
+    }
+    if (!exited) {
+      Exit(mBlock.end, mBlock.code.size());
+    }
+
+    for (auto patch : mExits) {
+      mAsm.Bind(patch);
+    }
+    mAsm.AddRsp(8);
+    for (auto reg : {r15, r14, r13, r12, rbp, rbx}) {
+      mAsm.Pop(reg);
+    }
+    mAsm.Ret();
+    return true;
+  }
+
+  const std::vector<std::uint8_t> &GetCode() const { return mAsm.GetCode(); }
+  std::uint32_t GetMaxInstructions() const {
+    return static_cast<std::uint32_t>(mBlock.code.size() +
+                                      (mBlock.skipJump ? 1 : 0));
+  }
+
+private:
+  struct Home {
+    std::uint8_t guest;
+    HostRegister host;
+  };
+
+  /// Emits one translated instruction, returns whether it left the block.
+  bool Native(const DecodedInstruction &instruction, std::uint16_t address,
+              std::size_t index, bool flagObserved) {
+    const auto x = mHome[instruction.x];
+    const auto y = mHome[instruction.y];
+    const auto flag = mHome[vf];
+    mDirty |= Writes(instruction);
+    switch (instruction.opcode) {
+    case Opcode::LDxkk:
+      mAsm.MovImm8(x, instruction.kk);
+      break;
+    case Opcode::ADDxkk:
+      mAsm.AluImm8(0, x, instruction.kk);
+      break;
+    case Opcode::LDxy:
+      mAsm.MovReg8(x, y);
+      break;
+    case Opcode::OR:
+      mAsm.Alu(alu_or, x, y);
+      break;
+    case Opcode::AND:
+      mAsm.Alu(alu_and, x, y);
+      break;
+    case Opcode::XOR:
+      mAsm.Alu(alu_xor, x, y);
+      break;
+    case Opcode::ADDxy:
+      mAsm.Alu(alu_add, x, y);
+      if (flagObserved) {
+        mAsm.SetCc(below, flag);
+      }
+      break;
+    case Opcode::SUB:
+      if (flagObserved) {
+        mAsm.Alu(alu_cmp, x, y);
+        mAsm.SetCc(above_equal, flag);
+      }
+      mAsm.Alu(alu_sub, x, y);
+      break;
+    case Opcode::SUBN:
+      // Reversed, so the difference is formed in al.
+      if (flagObserved) {
+        mAsm.Alu(alu_cmp, y, x);
+        mAsm.SetCc(above_equal, flag);
+      }
+      mAsm.MovReg8(rax, y);
+      mAsm.Alu(alu_sub, rax, x);
+      mAsm.MovReg8(x, rax);
+      break;
+    case Opcode::SHR:
+      mAsm.Shr1(x);
+      if (flagObserved) {
+        mAsm.SetCc(below, flag);
+      }
+      break;
+    case Opcode::SHL:
+      mAsm.Shl1(x);
+      if (flagObserved) {
+        mAsm.SetCc(below, flag);
+      }
+      break;
+    case Opcode::LDnnn:
+      mAsm.MovWord(i_offset, instruction.nnn);
+      break;
+    case Opcode::ADDix:
+      mAsm.MovzxEax(x);
+      mAsm.AddWordAx(i_offset);
+      break;
+    case Opcode::JP:
+      Exit(instruction.nnn, index + 1);
+      return true;
+    case Opcode::SExkk:
+    case Opcode::SNExkk:
+    case Opcode::SExy:
+    case Opcode::SNExy: {
+      const bool immediate = instruction.opcode == Opcode::SExkk ||
+                             instruction.opcode == Opcode::SNExkk;
+      if (immediate) {
+        mAsm.AluImm8(7, x, instruction.kk);
+      } else {
+        mAsm.Alu(alu_cmp, x, y);
+      }
+      const bool equals = instruction.opcode == Opcode::SExkk ||
+                          instruction.opcode == Opcode::SExy;
+      const auto skip = mAsm.Jcc(equals ? equal : not_equal);
+      if (mBlock.skipJump) {
+        Exit(mBlock.skipJumpTarget, index + 2);
+      } else {
+        Exit(address + 2, index + 1);
+      }
+      mAsm.Bind(skip);
+      Exit(address + 4, index + 1);
+      return true;
+    }
+    default:
+      break;
+    }
+    return false;
+  }
+
+  /// Runs an instruction through its handler with the guest registers in
+  /// memory, returns whether it left the block.
+  bool CallHandler(const Instructions::CompiledInstruction &compiled,
+                   std::uint16_t address, std::size_t index) {
+    mAsm.MovWord(pc_offset, address);
+    Spill();
+    mAsm.MovReg64(rdi, state_base);
+    mAsm.MovImm64(rsi, reinterpret_cast<std::uintptr_t>(&compiled.operands));
+    mAsm.MovImm64(rax, reinterpret_cast<std::uintptr_t>(compiled.handler));
+    mAsm.CallRax();
+    Reload();
+    // Handlers of these set the PC, the key skips and the key wait from the
+    // address above.
+    switch (compiled.operands.opcode) {
+    case Opcode::JPV0:
+    case Opcode::CALL:
+    case Opcode::RET:
+    case Opcode::SKP:
+    case Opcode::SKNP:
+    case Opcode::LDx0:
+      mAsm.AddWord(pc_offset, Instructions::instruction_size);
+      mAsm.MovEax(static_cast<std::uint32_t>(index + 1));
+      mExits.push_back(mAsm.Jmp());
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  void Exit(std::uint16_t pc, std::size_t executed) {
+    Spill();
+    mAsm.MovWord(pc_offset, pc);
+    mAsm.MovEax(static_cast<std::uint32_t>(executed));
+    mExits.push_back(mAsm.Jmp());
+  }
+
+  /// Writes back the registers changed since they were loaded. Exits all
+  /// follow the last instruction, so spilling there does not change what
+  /// later code sees as dirty.
+  void Spill() {
+    for (std::size_t i = 0; i < mHomeCount; ++i) {
+      if (mDirty & 1u << mHomes[i].guest) {
+        mAsm.StoreByte(mHomes[i].host, v_offset + mHomes[i].guest);
+      }
+    }
+  }
+
+  void Reload() {
+    for (std::size_t i = 0; i < mHomeCount; ++i) {
+      mAsm.LoadByte(mHomes[i].host, v_offset + mHomes[i].guest);
+    }
+    mDirty = 0;
+  }
+
+  const Block &mBlock;
+  Assembler mAsm;
+  std::array<Home, max_block_registers> mHomes{};
+  std::size_t mHomeCount = 0;
+  std::array<HostRegister, cpu::register_count> mHome{};
+  std::uint16_t mDirty = 0;
+  std::vector<std::size_t> mExits;
+};
+
+} // namespace
+
+bool IsSupported() { return true; }
+
+NativeBlock::NativeBlock(void *code, std::size_t size,
+                         std::uint32_t maxInstructions)
+    : mCode(code), mSize(size), mEntry(reinterpret_cast<Entry>(code)),
+      mMaxInstructions(maxInstructions) {}
+
+NativeBlock::~NativeBlock() { munmap(mCode, mSize); }
+
+std::unique_ptr<NativeBlock> Compile(const Block &block) {
+  BlockCompiler compiler(block);
+  if (!compiler.Compile()) {
+    return nullptr;
+  }
+  const auto &code = compiler.GetCode();
+  const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const auto size = (code.size() + page - 1) / page * page;
+  // Written first and only then made executable, never both at once.
+  auto *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+  std::memcpy(memory, code.data(), code.size());
+  if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(memory, size);
+    return nullptr;
+  }
+  return std::make_unique<NativeBlock>(memory, size,
+                                       compiler.GetMaxInstructions());
+}
+
+#else
+
+bool IsSupported() { return false; }
+
+NativeBlock::NativeBlock(void *code, std::size_t size,
+                         std::uint32_t maxInstructions)
+    : mCode(code), mSize(size), mEntry(nullptr),
+      mMaxInstructions(maxInstructions) {}
+
+NativeBlock::~NativeBlock() = default;
+
+std::unique_ptr<NativeBlock> Compile(const Block &) { return nullptr; }
+
+#endif
+
+} // namespace emulator::jit
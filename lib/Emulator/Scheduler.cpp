@@ -0,0 +1,64 @@
+#include "Emulator/Scheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace emulator {
+
+namespace {
+// Falling further behind than this drops the missed frames instead of running
+// them back to back.
+constexpr std::uint64_t max_frames_behind = 3;
+} // namespace
+
+Scheduler::Scheduler(std::uint64_t instructionsPerFrame, Pacing pacing)
+    : mInstructionsPerFrame(std::max<std::uint64_t>(instructionsPerFrame, 1)),
+      mPacing(pacing), mSpeed(1), mFrameDuration(frame_duration) {
+  Resynchronise();
+}
+
+void Scheduler::WaitForFrame() {
+  if (mPacing != Pacing::RealTime) {
+    return;
+  }
+  const auto deadline =
+      mEpoch + mFrameDuration * (mClock.frames - mEpochFrame);
+  const auto now = Clock::now();
+  if (now < deadline) {
+    std::this_thread::sleep_until(deadline);
+  } else if (now - deadline > mFrameDuration * max_frames_behind) {
+    Resynchronise();
+  }
+}
+
+void Scheduler::SetInstructionsPerFrame(std::uint64_t instructionsPerFrame) {
+  mInstructionsPerFrame = std::max<std::uint64_t>(instructionsPerFrame, 1);
+  mClock.frameInstructions =
+      std::min(mClock.frameInstructions, mInstructionsPerFrame - 1);
+}
+
+void Scheduler::SetPacing(Pacing pacing) {
+  mPacing = pacing;
+  Resynchronise();
+}
+
+void Scheduler::SetSpeed(double speed) {
+  assert(speed > 0 && "Speed must be positive");
+  mSpeed = speed;
+  mFrameDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double, std::nano>(frame_duration) / speed);
+  // The deadlines so far were at the old speed.
+  Resynchronise();
+}
+
+void Scheduler::SetClock(const VirtualClock &clock) {
+  mClock = clock;
+  Resynchronise();
+}
+
+void Scheduler::Resynchronise() {
+  mEpoch = Clock::now();
+  mEpochFrame = mClock.frames;
+}
+
+} // namespace emulator
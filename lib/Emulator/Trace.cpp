@@ -0,0 +1,146 @@
+#include "Emulator/Trace.h"
+#include <Instructions/Disassembler.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <iostream>
+
+namespace emulator {
+
+namespace {
+/// Packs value little endian at offset, returns the offset after it.
+template <typename T>
+std::size_t Put(std::array<char, trace_record_size> &bytes, std::size_t offset,
+                T value) {
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    bytes[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+  return offset + sizeof(T);
+}
+
+template <typename T>
+std::size_t Get(const std::array<char, trace_record_size> &bytes,
+                std::size_t offset, T &value) {
+  value = 0;
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    value |= static_cast<T>(static_cast<T>(
+                                static_cast<unsigned char>(bytes[offset + i]))
+                            << (8 * i));
+  }
+  return offset + sizeof(T);
+}
+} // namespace
+
+void WriteText(const TraceRecord &record, std::ostream &os) {
+  // Formatted on the stack, so the writer keeps up with the ring.
+  std::array<char, Disassembler::max_line_size + 64> line;
+  auto *const end = line.data() + line.size();
+  auto *out = std::to_chars(line.data(), end, record.cycle).ptr;
+  *out++ = '\t';
+  out = Disassembler::Format(record.word, record.pc, out);
+  if (record.changedRegister != no_register) {
+    out += std::snprintf(out, static_cast<std::size_t>(end - out),
+                         "\tV%X=0x%x", record.changedRegister,
+                         record.changedValue);
+  }
+  out += std::snprintf(out, static_cast<std::size_t>(end - out),
+                       "\tVF=0x%x\tI=0x%x\n", record.vf, record.i);
+  os.write(line.data(), out - line.data());
+}
+
+void WriteBinary(const TraceRecord &record, std::ostream &os) {
+  std::array<char, trace_record_size> bytes;
+  auto offset = Put(bytes, 0, record.cycle);
+  offset = Put(bytes, offset, record.pc);
+  offset = Put(bytes, offset, record.word);
+  offset = Put(bytes, offset, record.i);
+  offset = Put(bytes, offset, record.changedRegister);
+  offset = Put(bytes, offset, record.changedValue);
+  Put(bytes, offset, record.vf);
+  os.write(bytes.data(), bytes.size());
+}
+
+bool ReadRecord(std::istream &is, TraceRecord &record) {
+  std::array<char, trace_record_size> bytes;
+  if (!is.read(bytes.data(), bytes.size())) {
+    return false;
+  }
+  auto offset = Get(bytes, 0, record.cycle);
+  offset = Get(bytes, offset, record.pc);
+  offset = Get(bytes, offset, record.word);
+  offset = Get(bytes, offset, record.i);
+  offset = Get(bytes, offset, record.changedRegister);
+  offset = Get(bytes, offset, record.changedValue);
+  Get(bytes, offset, record.vf);
+  return true;
+}
+
+bool DecodeTrace(std::istream &is, std::ostream &os) {
+  char magic[sizeof(trace_magic)];
+  if (!is.read(magic, sizeof(magic)) ||
+      !std::equal(std::begin(magic), std::end(magic),
+                  std::begin(trace_magic))) {
+    return false;
+  }
+  TraceRecord record;
+  while (ReadRecord(is, record)) {
+    WriteText(record, os);
+  }
+  return true;
+}
+
+Tracer::~Tracer() { Close(); }
+
+bool Tracer::Open(const std::filesystem::path &path, TraceFormat format) {
+  Close();
+  mOutput.open(path, std::ios::binary | std::ios::trunc);
+  if (!mOutput) {
+    std::cerr << "Failed to open trace: " << path << std::endl;
+    return false;
+  }
+  mFormat = format;
+  if (mFormat == TraceFormat::Binary) {
+    mOutput.write(trace_magic, sizeof(trace_magic));
+  }
+  mRing = std::make_unique<util::SpscRing<TraceRecord, ring_size>>();
+  mDropped = 0;
+  mUnannounced = 0;
+  mWriter = std::jthread([this](std::stop_token stop) { Drain(stop); });
+  return true;
+}
+
+void Tracer::Close() {
+  if (mWriter.joinable()) {
+    mWriter.request_stop();
+    mWriter.join();
+  }
+  if (mOutput.is_open()) {
+    mOutput.close();
+  }
+}
+
+void Tracer::Write(const TraceRecord &record) {
+  if (mFormat == TraceFormat::Binary) {
+    WriteBinary(record, mOutput);
+  } else {
+    WriteText(record, mOutput);
+  }
+}
+
+void Tracer::Drain(std::stop_token stop) {
+  // Closing has to wake the writer wherever it sleeps.
+  std::stop_callback wake(stop, [this] { mWake.Notify(); });
+  auto write = [this](const TraceRecord &record) { Write(record); };
+  while (!stop.stop_requested()) {
+    if (mRing->Drain(write) == 0) {
+      mWake.Wait();
+    }
+  }
+  // The emulator no longer records once it asked the writer to stop.
+  mRing->Drain(write);
+  mOutput.flush();
+}
+
+} // namespace emulator
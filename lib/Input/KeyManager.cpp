@@ -1,16 +1,15 @@
 #include "Input/KeyManager.h"
 
 namespace input {
-KeyManager::KeyManager() {
-  for (int i = 0x1; i <= 0xF; ++i) {
-    KEY key = static_cast<KEY>(i);
-    mKeysState.emplace(key, KeyState(key));
-  }
-}
 
-void KeyManager::PressKey(KEY key) { mKeysState.at(key).pressed = true; }
-void KeyManager::ReleaseKey(KEY key) { mKeysState.at(key).pressed = false; }
-bool KeyManager::IsKeyPressed(KEY key) const {
-  return mKeysState.at(key).pressed;
+KeyLatch KeyManager::Latch() {
+  KeyLatch latch;
+  // Held first, an edge racing with the latch then shows up exactly once,
+  // in this latch or the next.
+  latch.held = GetHeld();
+  latch.pressed = mPressed.exchange(0, std::memory_order_relaxed);
+  latch.released = mReleased.exchange(0, std::memory_order_relaxed);
+  return latch;
 }
+
 } // namespace input
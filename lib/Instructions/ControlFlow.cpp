@@ -0,0 +1,226 @@
+#include "Instructions/ControlFlow.h"
+#include "Instructions/Decoder.h"
+#include "Instructions/Instruction.h"
+
+#include <algorithm>
+
+namespace Disassembler {
+
+namespace {
+using Instructions::DecodedInstruction;
+using Instructions::Opcode;
+
+/// Whether opcode is the last instruction of a block.
+bool EndsBlock(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::JP:
+  case Opcode::JPV0:
+  case Opcode::CALL:
+  case Opcode::RET:
+  case Opcode::SExkk:
+  case Opcode::SExy:
+  case Opcode::SNExkk:
+  case Opcode::SNExy:
+  case Opcode::SKP:
+  case Opcode::SKNP:
+  case Opcode::SYS:
+  case Opcode::EXIT:
+  case Opcode::ILLEGAL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Adds the exit and successors of a block ending with instruction at
+/// address.
+void SetExit(BasicBlock &block, const DecodedInstruction &instruction,
+             std::uint16_t address) {
+  const auto next = static_cast<std::uint16_t>(address + 2);
+  switch (instruction.opcode) {
+  case Opcode::JP:
+    block.successors = {instruction.nnn};
+    break;
+  case Opcode::CALL:
+    block.calls = true;
+    block.callTarget = instruction.nnn;
+    block.successors = {next};
+    break;
+  case Opcode::RET:
+    block.exit = BlockExit::Return;
+    break;
+  case Opcode::JPV0:
+    block.exit = BlockExit::Indirect;
+    break;
+  case Opcode::SExkk:
+  case Opcode::SExy:
+  case Opcode::SNExkk:
+  case Opcode::SNExy:
+  case Opcode::SKP:
+  case Opcode::SKNP:
+    block.successors = {next, static_cast<std::uint16_t>(next + 2)};
+    break;
+  default:
+    block.exit = BlockExit::Halt;
+    break;
+  }
+}
+} // namespace
+
+ControlFlowGraph::ControlFlowGraph()
+    : mInstructions(cpu::memory_size, false), mCode(cpu::memory_size, false),
+      mInstructionCount(0) {}
+
+ControlFlowGraph
+ControlFlowGraph::Analyse(std::span<const std::uint8_t> program,
+                          std::uint16_t load, std::uint16_t entry) {
+  ControlFlowGraph graph;
+  const auto end =
+      std::min<std::size_t>(load + program.size(), cpu::memory_size);
+  auto inProgram = [load, end](std::size_t address) {
+    return address >= load && address + 2 <= end;
+  };
+  auto decode = [&program, load](std::uint16_t address) {
+    const auto offset = address - load;
+    return Instructions::Decode(static_cast<std::uint16_t>(
+        program[offset] << 8 | program[offset + 1]));
+  };
+
+  // Find every reachable instruction, and the leaders starting blocks.
+  std::vector<bool> leaders(cpu::memory_size, false);
+  std::vector<std::uint16_t> work;
+  std::vector<std::uint16_t> entries = {entry};
+  auto addLeader = [&leaders, &work](std::size_t address) {
+    if (address < cpu::memory_size && !leaders[address]) {
+      leaders[address] = true;
+      work.push_back(static_cast<std::uint16_t>(address));
+    }
+  };
+  addLeader(entry);
+  while (!work.empty()) {
+    auto address = work.back();
+    work.pop_back();
+    while (inProgram(address) && !graph.mInstructions[address]) {
+      graph.mInstructions[address] = true;
+      graph.mCode[address] = graph.mCode[address + 1] = true;
+      ++graph.mInstructionCount;
+      const auto instruction = decode(address);
+      const auto next = address + Instructions::instruction_size;
+      if (instruction.opcode == Opcode::LDnnn && inProgram(instruction.nnn)) {
+        graph.mDataReferences.push_back(instruction.nnn);
+      }
+      if (!EndsBlock(instruction.opcode)) {
+        address = static_cast<std::uint16_t>(next);
+        continue;
+      }
+      switch (instruction.opcode) {
+      case Opcode::JP:
+        addLeader(instruction.nnn);
+        break;
+      case Opcode::CALL:
+        addLeader(instruction.nnn);
+        addLeader(next);
+        entries.push_back(instruction.nnn);
+        break;
+      case Opcode::JPV0:
+        graph.mIndirectJumps.push_back(address);
+        break;
+      case Opcode::SExkk:
+      case Opcode::SExy:
+      case Opcode::SNExkk:
+      case Opcode::SNExy:
+      case Opcode::SKP:
+      case Opcode::SKNP:
+        addLeader(next);
+        addLeader(next + Instructions::instruction_size);
+        break;
+      default:
+        break;
+      }
+      break;
+    }
+  }
+
+  // Cut the instructions into blocks at the leaders.
+  for (std::size_t start = 0; start < cpu::memory_size; ++start) {
+    if (!leaders[start] || !graph.mInstructions[start]) {
+      continue;
+    }
+    BasicBlock block{};
+    block.start = static_cast<std::uint16_t>(start);
+    auto address = block.start;
+    while (true) {
+      const auto instruction = decode(address);
+      const auto next =
+          static_cast<std::uint16_t>(address + Instructions::instruction_size);
+      block.end = next;
+      if (EndsBlock(instruction.opcode)) {
+        SetExit(block, instruction, address);
+        break;
+      }
+      if (!inProgram(next)) {
+        block.exit = BlockExit::Halt;
+        break;
+      }
+      if (leaders[next]) {
+        block.successors = {next};
+        break;
+      }
+      address = next;
+    }
+    graph.mBlocks.push_back(std::move(block));
+  }
+
+  // Functions are the blocks reachable from their entry without calls.
+  std::sort(entries.begin() + 1, entries.end());
+  entries.erase(std::unique(entries.begin() + 1, entries.end()), entries.end());
+  entries.erase(std::remove(entries.begin() + 1, entries.end(), entry),
+                entries.end());
+  for (auto functionEntry : entries) {
+    Function function{functionEntry, {}, {}};
+    std::vector<bool> seen(cpu::memory_size, false);
+    std::vector<std::uint16_t> pending = {functionEntry};
+    while (!pending.empty()) {
+      const auto start = pending.back();
+      pending.pop_back();
+      const auto *block = graph.FindBlock(start);
+      if (block == nullptr || seen[start]) {
+        continue;
+      }
+      seen[start] = true;
+      function.blocks.push_back(start);
+      if (block->calls) {
+        function.callees.push_back(block->callTarget);
+      }
+      pending.insert(pending.end(), block->successors.begin(),
+                     block->successors.end());
+    }
+    std::sort(function.blocks.begin(), function.blocks.end());
+    std::sort(function.callees.begin(), function.callees.end());
+    function.callees.erase(
+        std::unique(function.callees.begin(), function.callees.end()),
+        function.callees.end());
+    graph.mFunctions.push_back(std::move(function));
+  }
+
+  std::sort(graph.mIndirectJumps.begin(), graph.mIndirectJumps.end());
+  auto &references = graph.mDataReferences;
+  std::sort(references.begin(), references.end());
+  references.erase(std::unique(references.begin(), references.end()),
+                   references.end());
+  return graph;
+}
+
+const BasicBlock *ControlFlowGraph::FindBlock(std::uint16_t address) const {
+  const auto found = std::lower_bound(
+      mBlocks.begin(), mBlocks.end(), address,
+      [](const BasicBlock &block, std::uint16_t start) {
+        return block.start < start;
+      });
+  if (found == mBlocks.end() || found->start != address) {
+    return nullptr;
+  }
+  return &*found;
+}
+
+} // namespace Disassembler
@@ -1,42 +1,142 @@
 #include "Instructions/Disassembler.h"
+#include "Instructions/Decoder.h"
 #include "Instructions/InstructionUtil.h"
 
 #include <CPU/Memory.h>
 
 #include <algorithm>
-#include <iostream>
-#include <sstream>
+#include <string_view>
 
 namespace Disassembler {
 
+namespace {
+using Instructions::Opcode;
+
+char *Append(char *out, std::string_view text) {
+  return std::copy(text.begin(), text.end(), out);
+}
+
+/// Lower case hex without leading zeroes, as std::hex prints it.
+char *AppendHex(char *out, std::uint32_t value) {
+  char digits[8];
+  int count = 0;
+  do {
+    digits[count++] = "0123456789abcdef"[value & 0xF];
+    value >>= 4;
+  } while (value != 0);
+  while (count > 0) {
+    *out++ = digits[--count];
+  }
+  return out;
+}
+
+char *AppendRegister(char *out, std::uint8_t index) {
+  *out++ = 'V';
+  *out++ = "0123456789ABCDEF"[index & 0xF];
+  return out;
+}
+} // namespace
+
 const Instructions::InstructionDef &GetInstructionDef(std::uint16_t data) {
-  auto res = std::find_if(Instructions::InstructionDefinitions.begin(),
-                          Instructions::InstructionDefinitions.end(),
-                          [data](const Instructions::InstructionDef &def) {
-                            return def.ContainsOpcode(data);
-                          });
-  if (res == Instructions::InstructionDefinitions.end()) {
-    std::cerr << "Could not find instruction for the data 0x" << std::hex
-              << static_cast<int>(data) << std::endl;
-    assert(false);
-    return Instructions::InstructionDefinitions[0];
+  return Instructions::GetDefinition(data);
+}
+
+char *Format(std::uint16_t word, std::uint16_t address, char *out) {
+  const auto instruction = Instructions::Decode(word);
+  out = Append(out, "0x");
+  out = AppendHex(out, address);
+  *out++ = '\t';
+  out = AppendHex(out, word);
+  *out++ = '\t';
+  out = Append(out, Instructions::GetMnemonic(instruction.opcode));
+
+  // The operands in the order the Instruction classes dump them.
+  switch (instruction.opcode) {
+  case Opcode::SYS:
+  case Opcode::JP:
+  case Opcode::CALL:
+    out = Append(out, " 0x");
+    return AppendHex(out, instruction.nnn);
+  case Opcode::JPV0:
+    out = Append(out, " V0 0x");
+    return AppendHex(out, instruction.nnn);
+  case Opcode::LDnnn:
+    out = Append(out, " I 0x");
+    return AppendHex(out, instruction.nnn);
+  case Opcode::RND:
+  case Opcode::SExkk:
+  case Opcode::SNExkk:
+  case Opcode::LDxkk:
+  case Opcode::ADDxkk:
+    *out++ = ' ';
+    out = AppendRegister(out, instruction.x);
+    out = Append(out, " 0x");
+    return AppendHex(out, instruction.kk);
+  case Opcode::SExy:
+  case Opcode::SNExy:
+  case Opcode::LDxy:
+  case Opcode::ADDxy:
+  case Opcode::SUB:
+  case Opcode::SUBN:
+  case Opcode::OR:
+  case Opcode::AND:
+  case Opcode::XOR:
+  case Opcode::SHR:
+  case Opcode::SHL:
+  case Opcode::DRW:
+    *out++ = ' ';
+    out = AppendRegister(out, instruction.x);
+    *out++ = ' ';
+    out = AppendRegister(out, instruction.y);
+    if (instruction.opcode == Opcode::DRW) {
+      out = Append(out, " 0x");
+      out = AppendHex(out, instruction.n);
+    }
+    return out;
+  case Opcode::LDxdt:
+    *out++ = ' ';
+    out = AppendRegister(out, instruction.x);
+    return Append(out, " VDelay");
+  case Opcode::LDx0:
+    *out++ = ' ';
+    out = AppendRegister(out, instruction.x);
+    return Append(out, " K");
+  case Opcode::LDxi:
+    *out++ = ' ';
+    out = AppendRegister(out, instruction.x);
+    return Append(out, " [I]");
+  case Opcode::SKP:
+  case Opcode::SKNP:
+    *out++ = ' ';
+    return AppendRegister(out, instruction.x);
+  case Opcode::LDdtx:
+    return AppendRegister(Append(out, " VDelay "), instruction.x);
+  case Opcode::LDstx:
+    return AppendRegister(Append(out, " VSound "), instruction.x);
+  case Opcode::LDfx:
+    return AppendRegister(Append(out, " F "), instruction.x);
+  case Opcode::LDbx:
+    return AppendRegister(Append(out, " B "), instruction.x);
+  case Opcode::LDix:
+    return AppendRegister(Append(out, " [I] "), instruction.x);
+  case Opcode::ADDix:
+    return AppendRegister(Append(out, " I "), instruction.x);
+  default:
+    return out;
   }
-  return *res;
 }
 
 std::string DisassembleToString(const std::vector<std::uint16_t> &input) {
-  std::stringstream sstream;
+  std::string text(input.size() * (max_line_size + 1), '\0');
+  auto *out = text.data();
   std::uint16_t address = instruction_start;
-  for (auto &c : input) {
-    auto &def = GetInstructionDef(c);
-    auto *instruction = CreateInstruction(address, def.GetOpcode(), c);
-    instruction->Dump(sstream);
-    sstream << "\n";
-    delete instruction;
+  for (auto word : input) {
+    out = Format(word, address, out);
+    *out++ = '\n';
     address += Instructions::instruction_size;
   }
-
-  return sstream.str();
+  text.resize(out - text.data());
+  return text;
 }
 
 Instructions::Instruction *Disassemble(std::uint16_t input,
@@ -1,5 +1,5 @@
 #include "Instructions/InstructionUtil.h"
-#include "Output/Sprites.h"
+#include "Instructions/Semantics.h"
 
 #include <CPU/CpuState.h>
 #include <Instructions/Instruction.h>
@@ -22,6 +22,8 @@ constexpr std::uint16_t regx_mask = 0x0F00;
 constexpr std::uint16_t regy_mask = 0x00F0;
 constexpr std::uint16_t const_mask = 0x00FF;
 constexpr std::uint16_t const_nibble_mask = 0x000F;
+
+std::uint8_t X(Register reg) { return static_cast<std::uint8_t>(reg); }
 } // namespace
 
 Instruction::Instruction(Opcode opcode, std::uint16_t address,
@@ -54,17 +56,12 @@ void SysInstruction::Execute(CpuState & /*state*/) {
 ClsInstruction::ClsInstruction(std::uint16_t address, std::uint16_t data)
     : Instruction(Opcode::CLS, address, data) {}
 
-void ClsInstruction::Execute(CpuState &state) { state.display.Clear(); }
+void ClsInstruction::Execute(CpuState &state) { Semantics::Cls(state); }
 
 RetInstruction::RetInstruction(std::uint16_t address, std::uint16_t data)
     : Instruction(Opcode::RET, address, data) {}
 
-void RetInstruction::Execute(CpuState &state) {
-  state.registers.PC = state.memory.PopStack(state.registers.SP);
-  state.registers.SP -= 1;
-
-  state.registers.PC -= instruction_size;
-}
+void RetInstruction::Execute(CpuState &state) { Semantics::Ret(state); }
 
 JpInstruction::JpInstruction(std::uint16_t address, std::uint16_t data)
     : Instruction(Opcode::JP, address, data) {
@@ -77,8 +74,21 @@ void JpInstruction::Dump(std::ostream &os) {
 }
 
 void JpInstruction::Execute(CpuState &state) {
-  state.registers.PC = mExecAddr;
-  state.registers.PC -= instruction_size;
+  Semantics::Jp(state, mExecAddr);
+}
+
+JpV0Instruction::JpV0Instruction(std::uint16_t address, std::uint16_t data)
+    : Instruction(Opcode::JPV0, address, data) {
+  mExecAddr = data & addr12bit_mask;
+}
+
+void JpV0Instruction::Dump(std::ostream &os) {
+  Instruction::Dump(os);
+  os << " " << cpu::ToString(Register::V0) << " 0x" << std::hex << mExecAddr;
+}
+
+void JpV0Instruction::Execute(CpuState &state) {
+  Semantics::JpV0(state, mExecAddr);
 }
 
 RndInstruction::RndInstruction(std::uint16_t address, std::uint16_t data)
@@ -94,9 +104,7 @@ void RndInstruction::Dump(std::ostream &os) {
 }
 
 void RndInstruction::Execute(CpuState &state) {
-  auto &reg = ::GetRegister(mRegister, state);
-  std::uint8_t randomVal = (std::uint8_t)(rand() % 256);
-  reg = randomVal & mConstant;
+  Semantics::Rnd(state, X(mRegister), mConstant);
 }
 
 CallInstruction::CallInstruction(std::uint16_t address, std::uint16_t data)
@@ -110,13 +118,7 @@ void CallInstruction::Dump(std::ostream &os) {
 }
 
 void CallInstruction::Execute(CpuState &state) {
-  // Increase the stack pointer
-  state.registers.SP += 1;
-  // Write to the stack
-  state.memory.PushStack(state.registers.PC, state.registers.SP);
-  // Set pc to the address to execute
-  state.registers.PC = mExecAddr;
-  state.registers.PC -= instruction_size;
+  Semantics::Call(state, mExecAddr);
 }
 
 SexkkInstruction::SexkkInstruction(std::uint16_t address, std::uint16_t data)
@@ -132,10 +134,7 @@ void SexkkInstruction::Dump(std::ostream &os) {
 }
 
 void SexkkInstruction::Execute(CpuState &state) {
-  const auto &reg = ::GetRegister(mRegister, state);
-  if (reg == mConstant) {
-    state.registers.PC += instruction_size;
-  }
+  Semantics::Sexkk(state, X(mRegister), mConstant);
 }
 
 SexyInstruction::SexyInstruction(std::uint16_t address, std::uint16_t data)
@@ -150,11 +149,7 @@ void SexyInstruction::Dump(std::ostream &os) {
 }
 
 void SexyInstruction::Execute(CpuState &state) {
-  const auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  if (regx == regy) {
-    state.registers.PC += instruction_size;
-  }
+  Semantics::Sexy(state, X(mRegisterX), X(mRegisterY));
 }
 
 SnexkkInstruction::SnexkkInstruction(std::uint16_t address, std::uint16_t data)
@@ -170,10 +165,7 @@ void SnexkkInstruction::Dump(std::ostream &os) {
 }
 
 void SnexkkInstruction::Execute(CpuState &state) {
-  const auto &reg = ::GetRegister(mRegister, state);
-  if (reg != mConstant) {
-    state.registers.PC += instruction_size;
-  }
+  Semantics::Snexkk(state, X(mRegister), mConstant);
 }
 
 SnexyInstruction::SnexyInstruction(std::uint16_t address, std::uint16_t data)
@@ -188,11 +180,7 @@ void SnexyInstruction::Dump(std::ostream &os) {
 }
 
 void SnexyInstruction::Execute(CpuState &state) {
-  const auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  if (regx != regy) {
-    state.registers.PC += instruction_size;
-  }
+  Semantics::Snexy(state, X(mRegisterX), X(mRegisterY));
 }
 
 LdxkkInstruction::LdxkkInstruction(std::uint16_t address, std::uint16_t data)
@@ -208,8 +196,7 @@ void LdxkkInstruction::Dump(std::ostream &os) {
 }
 
 void LdxkkInstruction::Execute(CpuState &state) {
-  auto &reg = ::GetRegister(mRegister, state);
-  reg = mConstant;
+  Semantics::Ldxkk(state, X(mRegister), mConstant);
 }
 
 LdxyInstruction::LdxyInstruction(std::uint16_t address, std::uint16_t data)
@@ -224,9 +211,7 @@ void LdxyInstruction::Dump(std::ostream &os) {
 }
 
 void LdxyInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  regx = regy;
+  Semantics::Ldxy(state, X(mRegisterX), X(mRegisterY));
 }
 
 LdnnnInstruction::LdnnnInstruction(std::uint16_t address, std::uint16_t data)
@@ -240,7 +225,9 @@ void LdnnnInstruction::Dump(std::ostream &os) {
      << "0x" << std::hex << mValue;
 }
 
-void LdnnnInstruction::Execute(CpuState &state) { state.registers.I = mValue; }
+void LdnnnInstruction::Execute(CpuState &state) {
+  Semantics::Ldnnn(state, mValue);
+}
 
 LdxdtInstruction::LdxdtInstruction(std::uint16_t address, std::uint16_t data)
     : Instruction(Opcode::LDxdt, address, data) {
@@ -254,12 +241,25 @@ void LdxdtInstruction::Dump(std::ostream &os) {
 }
 
 void LdxdtInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  regx = state.registers.VDelay;
+  Semantics::Ldxdt(state, X(mRegisterX));
+}
+
+Ldx0Instruction::Ldx0Instruction(std::uint16_t address, std::uint16_t data)
+    : Instruction(Opcode::LDx0, address, data) {
+  mRegisterX = static_cast<cpu::Register>((data & regx_mask) >> 8);
+}
+
+void Ldx0Instruction::Dump(std::ostream &os) {
+  Instruction::Dump(os);
+  os << " " << cpu::ToString(mRegisterX) << " K";
+}
+
+void Ldx0Instruction::Execute(CpuState &state) {
+  Semantics::Ldx0(state, X(mRegisterX));
 }
 
 LddtxInstruction::LddtxInstruction(std::uint16_t address, std::uint16_t data)
-    : Instruction(Opcode::LDxdt, address, data) {
+    : Instruction(Opcode::LDdtx, address, data) {
   mRegisterX = static_cast<cpu::Register>((data & regx_mask) >> 8);
 }
 
@@ -270,12 +270,11 @@ void LddtxInstruction::Dump(std::ostream &os) {
 }
 
 void LddtxInstruction::Execute(CpuState &state) {
-  const auto &regx = ::GetRegister(mRegisterX, state);
-  state.registers.VDelay = regx;
+  Semantics::Lddtx(state, X(mRegisterX));
 }
 
 LdstxInstruction::LdstxInstruction(std::uint16_t address, std::uint16_t data)
-    : Instruction(Opcode::LDxdt, address, data) {
+    : Instruction(Opcode::LDstx, address, data) {
   mRegisterX = static_cast<cpu::Register>((data & regx_mask) >> 8);
 }
 
@@ -286,8 +285,7 @@ void LdstxInstruction::Dump(std::ostream &os) {
 }
 
 void LdstxInstruction::Execute(CpuState &state) {
-  const auto &regx = ::GetRegister(mRegisterX, state);
-  state.registers.VSound = regx;
+  Semantics::Ldstx(state, X(mRegisterX));
 }
 
 LdfxInstruction::LdfxInstruction(std::uint16_t address, std::uint16_t data)
@@ -301,10 +299,21 @@ void LdfxInstruction::Dump(std::ostream &os) {
 }
 
 void LdfxInstruction::Execute(CpuState &state) {
-  const auto &regx = ::GetRegister(mRegisterX, state);
-  // Get sprite address and store in register I
-  state.registers.I = regx;
-  //  state.registers.I = Output::Sprites::GetSpriteAddress(regx);
+  Semantics::Ldfx(state, X(mRegisterX));
+}
+
+LdbxInstruction::LdbxInstruction(std::uint16_t address, std::uint16_t data)
+    : Instruction(Opcode::LDbx, address, data) {
+  mRegisterX = static_cast<cpu::Register>((data & regx_mask) >> 8);
+}
+
+void LdbxInstruction::Dump(std::ostream &os) {
+  Instruction::Dump(os);
+  os << " B " << cpu::ToString(mRegisterX);
+}
+
+void LdbxInstruction::Execute(CpuState &state) {
+  Semantics::Ldbx(state, X(mRegisterX));
 }
 
 LdixInstruction::LdixInstruction(std::uint16_t address, std::uint16_t data)
@@ -318,10 +327,7 @@ void LdixInstruction::Dump(std::ostream &os) {
 }
 
 void LdixInstruction::Execute(CpuState &state) {
-  for (int i = 0; i < static_cast<int>(mRegisterX); ++i) {
-    const auto &reg = ::GetRegister(static_cast<Register>(i), state);
-    state.memory.Write(state.registers.I + i, reg);
-  }
+  Semantics::Ldix(state, X(mRegisterX));
 }
 
 LdxiInstruction::LdxiInstruction(std::uint16_t address, std::uint16_t data)
@@ -336,10 +342,7 @@ void LdxiInstruction::Dump(std::ostream &os) {
 }
 
 void LdxiInstruction::Execute(CpuState &state) {
-  for (int i = 0; i < static_cast<int>(mRegisterX); ++i) {
-    auto &reg = ::GetRegister(static_cast<Register>(i), state);
-    reg = state.memory.Read(state.registers.I + i);
-  }
+  Semantics::Ldxi(state, X(mRegisterX));
 }
 
 AddxkkInstruction::AddxkkInstruction(std::uint16_t address, std::uint16_t data)
@@ -355,8 +358,7 @@ void AddxkkInstruction::Dump(std::ostream &os) {
 }
 
 void AddxkkInstruction::Execute(CpuState &state) {
-  auto &reg = ::GetRegister(mRegister, state);
-  reg = reg + mConstant;
+  Semantics::Addxkk(state, X(mRegister), mConstant);
 }
 
 AddxyInstruction::AddxyInstruction(std::uint16_t address, std::uint16_t data)
@@ -371,18 +373,7 @@ void AddxyInstruction::Dump(std::ostream &os) {
 }
 
 void AddxyInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  const uint16_t xval = regx;
-  const uint16_t yval = regy;
-  const uint16_t sum = xval + yval;
-  // if the result is bigger than fits in a uint8 we set the carry flag
-  if (sum > std::numeric_limits<uint8_t>::max()) {
-    state.registers.VF = 1;
-  } else {
-    state.registers.VF = 0;
-  }
-  regx = static_cast<std::uint8_t>(sum & 0xFF);
+  Semantics::Addxy(state, X(mRegisterX), X(mRegisterY));
 }
 
 AddixInstruction::AddixInstruction(std::uint16_t address, std::uint16_t data)
@@ -396,8 +387,7 @@ void AddixInstruction::Dump(std::ostream &os) {
 }
 
 void AddixInstruction::Execute(CpuState &state) {
-  const auto &regx = ::GetRegister(mRegisterX, state);
-  state.registers.I = state.registers.I + regx;
+  Semantics::Addix(state, X(mRegisterX));
 }
 
 SubInstruction::SubInstruction(std::uint16_t address, std::uint16_t data)
@@ -412,14 +402,7 @@ void SubInstruction::Dump(std::ostream &os) {
 }
 
 void SubInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  if (regx > regy) {
-    state.registers.VF = 1;
-  } else {
-    state.registers.VF = 0;
-  }
-  regx = regx - regy;
+  Semantics::Sub(state, X(mRegisterX), X(mRegisterY));
 }
 
 SubnInstruction::SubnInstruction(std::uint16_t address, std::uint16_t data)
@@ -434,14 +417,7 @@ void SubnInstruction::Dump(std::ostream &os) {
 }
 
 void SubnInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  if (regx < regy) {
-    state.registers.VF = 1;
-  } else {
-    state.registers.VF = 0;
-  }
-  regx = regx - regy;
+  Semantics::Subn(state, X(mRegisterX), X(mRegisterY));
 }
 
 OrInstruction::OrInstruction(std::uint16_t address, std::uint16_t data)
@@ -456,9 +432,7 @@ void OrInstruction::Dump(std::ostream &os) {
 }
 
 void OrInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  regx = regx | regy;
+  Semantics::Or(state, X(mRegisterX), X(mRegisterY));
 }
 
 AndInstruction::AndInstruction(std::uint16_t address, std::uint16_t data)
@@ -473,9 +447,7 @@ void AndInstruction::Dump(std::ostream &os) {
 }
 
 void AndInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  regx = regx & regy;
+  Semantics::And(state, X(mRegisterX), X(mRegisterY));
 }
 
 XorInstruction::XorInstruction(std::uint16_t address, std::uint16_t data)
@@ -490,9 +462,7 @@ void XorInstruction::Dump(std::ostream &os) {
 }
 
 void XorInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  regx = regx ^ regy;
+  Semantics::Xor(state, X(mRegisterX), X(mRegisterY));
 }
 
 ShrInstruction::ShrInstruction(std::uint16_t address, std::uint16_t data)
@@ -507,14 +477,7 @@ void ShrInstruction::Dump(std::ostream &os) {
 }
 
 void ShrInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  if (regx & 1) {
-    state.registers.VF = 1;
-  } else {
-    state.registers.VF = 0;
-  }
-  regx = regx >> 1;
+  Semantics::Shr(state, X(mRegisterX));
 }
 
 ShlInstruction::ShlInstruction(std::uint16_t address, std::uint16_t data)
@@ -529,14 +492,35 @@ void ShlInstruction::Dump(std::ostream &os) {
 }
 
 void ShlInstruction::Execute(CpuState &state) {
-  auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-  if (regx & 0b1000'0000) {
-    state.registers.VF = 1;
-  } else {
-    state.registers.VF = 0;
-  }
-  regx = regx << 1;
+  Semantics::Shl(state, X(mRegisterX));
+}
+
+SkpInstruction::SkpInstruction(std::uint16_t address, std::uint16_t data)
+    : Instruction(Opcode::SKP, address, data) {
+  mRegisterX = static_cast<cpu::Register>((data & regx_mask) >> 8);
+}
+
+void SkpInstruction::Dump(std::ostream &os) {
+  Instruction::Dump(os);
+  os << " " << cpu::ToString(mRegisterX);
+}
+
+void SkpInstruction::Execute(CpuState &state) {
+  Semantics::Skp(state, X(mRegisterX));
+}
+
+SknpInstruction::SknpInstruction(std::uint16_t address, std::uint16_t data)
+    : Instruction(Opcode::SKNP, address, data) {
+  mRegisterX = static_cast<cpu::Register>((data & regx_mask) >> 8);
+}
+
+void SknpInstruction::Dump(std::ostream &os) {
+  Instruction::Dump(os);
+  os << " " << cpu::ToString(mRegisterX);
+}
+
+void SknpInstruction::Execute(CpuState &state) {
+  Semantics::Sknp(state, X(mRegisterX));
 }
 
 DrwInstruction::DrwInstruction(std::uint16_t address, std::uint16_t data)
@@ -553,13 +537,7 @@ void DrwInstruction::Dump(std::ostream &os) {
 }
 
 void DrwInstruction::Execute(CpuState &state) {
-  // Position to draw at
-  const auto &regx = ::GetRegister(mRegisterX, state);
-  const auto &regy = ::GetRegister(mRegisterY, state);
-
-  std::vector<std::uint8_t> data =
-      state.memory.ReadSprite(state.registers.I, mConstant);
-  state.display.Draw(regx, regy, data);
+  Semantics::Drw(state, X(mRegisterX), X(mRegisterY), mConstant);
 }
 
 } // namespace Instructions
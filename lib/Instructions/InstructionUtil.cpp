@@ -4,7 +4,9 @@
 
 namespace Instructions {
 
-std::string ToString(Opcode opcode) {
+std::string ToString(Opcode opcode) { return std::string(GetMnemonic(opcode)); }
+
+std::string_view GetMnemonic(Opcode opcode) {
   switch (opcode) {
   case Opcode::CLS:
     return "CLS";
@@ -13,6 +15,7 @@ std::string ToString(Opcode opcode) {
   case Opcode::SYS:
     return "SYS";
   case Opcode::JP:
+  case Opcode::JPV0:
     return "JP";
   case Opcode::RND:
     return "RND";
@@ -72,6 +75,8 @@ std::string ToString(Opcode opcode) {
     return "LOW";
   case Opcode::HIGH:
     return "HIGH";
+  case Opcode::ILLEGAL:
+    return "ILLEGAL";
   }
 }
 
@@ -86,6 +91,8 @@ Instruction *CreateInstruction(std::uint16_t address, Opcode opcode,
     return new SysInstruction(address, data);
   case Opcode::JP:
     return new JpInstruction(address, data);
+  case Opcode::JPV0:
+    return new JpV0Instruction(address, data);
   case Opcode::RND:
     return new RndInstruction(address, data);
   case Opcode::CALL:
@@ -107,7 +114,7 @@ Instruction *CreateInstruction(std::uint16_t address, Opcode opcode,
   case Opcode::LDxdt:
     return new LdxdtInstruction(address, data);
   case Opcode::LDx0:
-    return new Instruction(opcode, address, data);
+    return new Ldx0Instruction(address, data);
   case Opcode::LDdtx:
     return new LddtxInstruction(address, data);
   case Opcode::LDstx:
@@ -115,7 +122,7 @@ Instruction *CreateInstruction(std::uint16_t address, Opcode opcode,
   case Opcode::LDfx:
     return new LdfxInstruction(address, data);
   case Opcode::LDbx:
-    return new Instruction(opcode, address, data);
+    return new LdbxInstruction(address, data);
   case Opcode::LDix:
     return new LdixInstruction(address, data);
   case Opcode::LDxi:
@@ -141,9 +148,9 @@ Instruction *CreateInstruction(std::uint16_t address, Opcode opcode,
   case Opcode::SHL:
     return new ShlInstruction(address, data);
   case Opcode::SKP:
-    return new Instruction(opcode, address, data);
+    return new SkpInstruction(address, data);
   case Opcode::SKNP:
-    return new Instruction(opcode, address, data);
+    return new SknpInstruction(address, data);
   case Opcode::DRW:
     return new DrwInstruction(address, data);
   // Super chip8 instructions.
@@ -159,6 +166,8 @@ Instruction *CreateInstruction(std::uint16_t address, Opcode opcode,
     return new Instruction(opcode, address, data);
   case Opcode::HIGH:
     return new Instruction(opcode, address, data);
+  case Opcode::ILLEGAL:
+    return new Instruction(opcode, address, data);
   }
 }
 
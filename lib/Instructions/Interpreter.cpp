@@ -0,0 +1,128 @@
+#include "Instructions/Interpreter.h"
+#include "Instructions/Semantics.h"
+
+namespace Interpreter {
+
+using Instructions::Opcode;
+namespace Semantics = Instructions::Semantics;
+
+bool Execute(const Instructions::DecodedInstruction &instruction,
+             cpu::CpuState &state) {
+  const auto x = instruction.x;
+  const auto y = instruction.y;
+  switch (instruction.opcode) {
+  case Opcode::CLS:
+    Semantics::Cls(state);
+    return true;
+  case Opcode::RET:
+    return Semantics::Ret(state);
+  case Opcode::JP:
+    Semantics::Jp(state, instruction.nnn);
+    return true;
+  case Opcode::JPV0:
+    Semantics::JpV0(state, instruction.nnn);
+    return true;
+  case Opcode::RND:
+    Semantics::Rnd(state, x, instruction.kk);
+    return true;
+  case Opcode::CALL:
+    return Semantics::Call(state, instruction.nnn);
+  case Opcode::SExkk:
+    Semantics::Sexkk(state, x, instruction.kk);
+    return true;
+  case Opcode::SExy:
+    Semantics::Sexy(state, x, y);
+    return true;
+  case Opcode::SNExkk:
+    Semantics::Snexkk(state, x, instruction.kk);
+    return true;
+  case Opcode::SNExy:
+    Semantics::Snexy(state, x, y);
+    return true;
+  case Opcode::LDxkk:
+    Semantics::Ldxkk(state, x, instruction.kk);
+    return true;
+  case Opcode::LDxy:
+    Semantics::Ldxy(state, x, y);
+    return true;
+  case Opcode::LDnnn:
+    Semantics::Ldnnn(state, instruction.nnn);
+    return true;
+  case Opcode::LDxdt:
+    Semantics::Ldxdt(state, x);
+    return true;
+  case Opcode::LDx0:
+    Semantics::Ldx0(state, x);
+    return true;
+  case Opcode::LDdtx:
+    Semantics::Lddtx(state, x);
+    return true;
+  case Opcode::LDstx:
+    Semantics::Ldstx(state, x);
+    return true;
+  case Opcode::LDfx:
+    Semantics::Ldfx(state, x);
+    return true;
+  case Opcode::LDbx:
+    Semantics::Ldbx(state, x);
+    return true;
+  case Opcode::LDix:
+    Semantics::Ldix(state, x);
+    return true;
+  case Opcode::LDxi:
+    Semantics::Ldxi(state, x);
+    return true;
+  case Opcode::ADDxkk:
+    Semantics::Addxkk(state, x, instruction.kk);
+    return true;
+  case Opcode::ADDxy:
+    Semantics::Addxy(state, x, y);
+    return true;
+  case Opcode::ADDix:
+    Semantics::Addix(state, x);
+    return true;
+  case Opcode::OR:
+    Semantics::Or(state, x, y);
+    return true;
+  case Opcode::AND:
+    Semantics::And(state, x, y);
+    return true;
+  case Opcode::XOR:
+    Semantics::Xor(state, x, y);
+    return true;
+  case Opcode::SUB:
+    Semantics::Sub(state, x, y);
+    return true;
+  case Opcode::SHR:
+    Semantics::Shr(state, x);
+    return true;
+  case Opcode::SUBN:
+    Semantics::Subn(state, x, y);
+    return true;
+  case Opcode::SHL:
+    Semantics::Shl(state, x);
+    return true;
+  case Opcode::SKP:
+    Semantics::Skp(state, x);
+    return true;
+  case Opcode::SKNP:
+    Semantics::Sknp(state, x);
+    return true;
+  case Opcode::DRW:
+    Semantics::Drw(state, x, y, instruction.n);
+    return true;
+  // Not implemented by the Instruction classes either.
+  case Opcode::SYS:
+  case Opcode::SCD:
+  case Opcode::SCR:
+  case Opcode::SCL:
+  case Opcode::EXIT:
+  case Opcode::LOW:
+  case Opcode::HIGH:
+  case Opcode::ILLEGAL:
+    return false;
+  }
+  return false;
+}
+
+} // namespace Interpreter
@@ -0,0 +1,158 @@
+#include "Instructions/ThreadedCode.h"
+#include "Instructions/Semantics.h"
+
+namespace Instructions {
+
+Handler GetHandler(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::CLS:
+    return [](CpuState &state, const DecodedInstruction &) {
+      Semantics::Cls(state);
+    };
+  case Opcode::RET:
+    return [](CpuState &state, const DecodedInstruction &) {
+      Semantics::Ret(state);
+    };
+  case Opcode::JP:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Jp(state, instruction.nnn);
+    };
+  case Opcode::JPV0:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::JpV0(state, instruction.nnn);
+    };
+  case Opcode::RND:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Rnd(state, instruction.x, instruction.kk);
+    };
+  case Opcode::CALL:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Call(state, instruction.nnn);
+    };
+  case Opcode::SExkk:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Sexkk(state, instruction.x, instruction.kk);
+    };
+  case Opcode::SExy:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Sexy(state, instruction.x, instruction.y);
+    };
+  case Opcode::SNExkk:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Snexkk(state, instruction.x, instruction.kk);
+    };
+  case Opcode::SNExy:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Snexy(state, instruction.x, instruction.y);
+    };
+  case Opcode::LDxkk:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldxkk(state, instruction.x, instruction.kk);
+    };
+  case Opcode::LDxy:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldxy(state, instruction.x, instruction.y);
+    };
+  case Opcode::LDnnn:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldnnn(state, instruction.nnn);
+    };
+  case Opcode::LDxdt:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldxdt(state, instruction.x);
+    };
+  case Opcode::LDx0:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldx0(state, instruction.x);
+    };
+  case Opcode::LDdtx:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Lddtx(state, instruction.x);
+    };
+  case Opcode::LDstx:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldstx(state, instruction.x);
+    };
+  case Opcode::LDfx:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldfx(state, instruction.x);
+    };
+  case Opcode::LDbx:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldbx(state, instruction.x);
+    };
+  case Opcode::LDix:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldix(state, instruction.x);
+    };
+  case Opcode::LDxi:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Ldxi(state, instruction.x);
+    };
+  case Opcode::ADDxkk:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Addxkk(state, instruction.x, instruction.kk);
+    };
+  case Opcode::ADDxy:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Addxy(state, instruction.x, instruction.y);
+    };
+  case Opcode::ADDix:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Addix(state, instruction.x);
+    };
+  case Opcode::OR:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Or(state, instruction.x, instruction.y);
+    };
+  case Opcode::AND:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::And(state, instruction.x, instruction.y);
+    };
+  case Opcode::XOR:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Xor(state, instruction.x, instruction.y);
+    };
+  case Opcode::SUB:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Sub(state, instruction.x, instruction.y);
+    };
+  case Opcode::SHR:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Shr(state, instruction.x);
+    };
+  case Opcode::SUBN:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Subn(state, instruction.x, instruction.y);
+    };
+  case Opcode::SHL:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Shl(state, instruction.x);
+    };
+  case Opcode::SKP:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Skp(state, instruction.x);
+    };
+  case Opcode::SKNP:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Sknp(state, instruction.x);
+    };
+  case Opcode::DRW:
+    return [](CpuState &state, const DecodedInstruction &instruction) {
+      Semantics::Drw(state, instruction.x, instruction.y, instruction.n);
+    };
+  // Not implemented by the Instruction classes either.
+  case Opcode::SYS:
+  case Opcode::SCD:
+  case Opcode::SCR:
+  case Opcode::SCL:
+  case Opcode::EXIT:
+  case Opcode::LOW:
+  case Opcode::HIGH:
+  case Opcode::ILLEGAL:
+    return nullptr;
+  }
+  return nullptr;
+}
+
+} // namespace Instructions
@@ -1,18 +1,100 @@
 #include "Output/Display.h"
 
-#include <iostream>
+#include <algorithm>
+#include <bit>
+#include <limits>
 
 namespace Output {
-Display::Display() { mScreen.resize(display_width * display_height, 0U); }
+Display::Display() : mPresented{}, mPresentedHighResolution(false) {
+  SetHighResolution(false);
+  Clear();
+  mTouched = 0;
+}
+
+bool Display::Draw(std::size_t x, std::size_t y,
+                   std::span<const std::uint8_t> data) {
+  x %= mWidth;
+  y %= mHeight;
+  const auto rows = std::min(data.size(), mHeight - y);
+  const auto word = x / row_word_bits;
+  const auto shift = x % row_word_bits;
+  const bool spills = word + 1 < row_words;
+  if (rows > 0) {
+    mTouched |= (~RowMask{0} >> (std::numeric_limits<RowMask>::digits - rows))
+                << y;
+  }
+
+  std::uint64_t erased = 0;
+  for (std::size_t i = 0; i < rows; ++i) {
+    const std::uint64_t sprite = std::uint64_t{data[i]} << (row_word_bits - 8);
+    auto &row = mScreen[y + i];
+
+    const std::uint64_t first = (sprite >> shift) & mVisible[word];
+    erased |= row[word] & first;
+    row[word] ^= first;
+
+    if (spills) {
+      // Two shifts so a zero shift moves the whole sprite out of the word.
+      const std::uint64_t second =
+          ((sprite << 1) << (row_word_bits - 1 - shift)) & mVisible[word + 1];
+      erased |= row[word + 1] & second;
+      row[word + 1] ^= second;
+    }
+  }
+  return erased != 0;
+}
+
+void Display::Clear() {
+  mScreen.fill(Row{});
+  mTouched = ~RowMask{0};
+}
 
-void Display::Draw(std::size_t x, std::size_t y,
-                   std::vector<std::uint8_t> data) {
-  std::cout << "Drawing to screen\n";
-  for (auto i = 0U; i < data.size(); ++i) {
-    mScreen[x * display_width + y + i] ^= data[i];
+void Display::SetHighResolution(bool enabled) {
+  mWidth = enabled ? display_width : lowres_display_width;
+  mHeight = enabled ? display_height : lowres_display_height;
+  for (std::size_t i = 0; i < row_words; ++i) {
+    const auto start = i * row_word_bits;
+    const auto visible =
+        std::min(mWidth - std::min(mWidth, start), row_word_bits);
+    mVisible[i] =
+        visible == 0 ? 0 : ~std::uint64_t{0} << (row_word_bits - visible);
   }
 }
 
-void Display::Clear() { std::fill(mScreen.begin(), mScreen.end(), 0); }
+void Display::Restore(const Display &saved) {
+  SetHighResolution(saved.IsHighResolution());
+  mScreen = saved.mScreen;
+  mTouched = ~RowMask{0};
+}
+
+RowMask Display::GetDamage() const {
+  if (IsHighResolution() != mPresentedHighResolution) {
+    return ~RowMask{0};
+  }
+  RowMask damage = 0;
+  for (auto touched = mTouched; touched != 0; touched &= touched - 1) {
+    const auto y = std::countr_zero(touched);
+    if (mScreen[y] != mPresented[y]) {
+      damage |= RowMask{1} << y;
+    }
+  }
+  return damage;
+}
+
+RowMask Display::AcknowledgeDamage() {
+  const auto damage = GetDamage();
+  for (auto touched = mTouched; touched != 0; touched &= touched - 1) {
+    const auto y = std::countr_zero(touched);
+    mPresented[y] = mScreen[y];
+  }
+  mTouched = 0;
+  mPresentedHighResolution = IsHighResolution();
+  return damage;
+}
+
+bool Display::GetPixel(std::size_t x, std::size_t y) const {
+  const auto &word = mScreen[y][x / row_word_bits];
+  return (word >> (row_word_bits - 1 - x % row_word_bits)) & 1;
+}
 
 } // namespace Output
@@ -1,6 +1,13 @@
 #include "catch.hpp"
 
+#include "CPU/CpuState.h"
+#include "CPU/CpuUtil.h"
 #include "CPU/Memory.h"
+#include "CPU/Random.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 
 TEST_CASE("Test Valid Addresses") {
   cpu::Memory memory;
@@ -22,3 +29,190 @@ TEST_CASE("Read write memory") {
 
   SECTION("Zero initialised") { CHECK(memory.Read(cpu::memory_start) == 0x0); }
 }
+
+TEST_CASE("Unchecked memory access") {
+  cpu::Memory memory;
+
+  SECTION("Addresses wrap at the end of memory") {
+    memory.Store(cpu::memory_size + 0x234, 0xAB);
+    CHECK(memory.Load(0x234) == 0xAB);
+    CHECK(memory.Read(0x234) == 0xAB);
+  }
+
+  SECTION("Fetch is big endian") {
+    memory.WriteUint16(cpu::memory_start, 0x1234);
+    CHECK(memory.Fetch(cpu::memory_start) == 0x1234);
+    CHECK(memory.ReadUint16(cpu::memory_start) == 0x1234);
+  }
+
+  SECTION("Views wrapping around the end stay contiguous") {
+    memory.Store(cpu::memory_size - 1, 0x11);
+    memory.Store(0x0, 0x22);
+    memory.Store(0x1, 0x33);
+    CHECK(memory.Fetch(cpu::memory_size - 1) == 0x1122);
+    const auto view = memory.View(cpu::memory_size - 1, 3);
+    CHECK(std::vector<std::uint8_t>(view.begin(), view.end()) ==
+          std::vector<std::uint8_t>{0x11, 0x22, 0x33});
+  }
+
+  SECTION("Loading a buffer") {
+    const std::vector<std::uint8_t> rom = {0x60, 0x01, 0x12, 0x00};
+    CHECK(memory.LoadIntoMemory(rom, cpu::memory_start));
+    const auto sprite = memory.ReadSprite(cpu::memory_start, 4);
+    CHECK(std::equal(sprite.begin(), sprite.end(), rom.begin(), rom.end()));
+  }
+}
+
+TEST_CASE("Memory snapshots") {
+  cpu::Memory memory;
+  memory.Write(cpu::memory_start, 0x12);
+  memory.PushStack(0x234, 1);
+  auto snapshot = memory.TakeSnapshot();
+
+  SECTION("Restore undoes later writes") {
+    memory.Write(cpu::memory_start, 0x34);
+    memory.Write(cpu::memory_size - 1, 0x56);
+    memory.PushStack(0x456, 1);
+    memory.RestoreSnapshot(snapshot);
+    CHECK(memory.Read(cpu::memory_start) == 0x12);
+    CHECK(memory.Read(cpu::memory_size - 1) == 0x0);
+    CHECK(memory.PopStack(1) == 0x234);
+  }
+
+  SECTION("Snapshots share unchanged pages") {
+    memory.Write(cpu::memory_start, 0x34);
+    auto next = memory.TakeSnapshot();
+    const auto changed = cpu::memory_start / cpu::page_size;
+    for (std::size_t page = 0; page < cpu::page_count; ++page) {
+      CHECK((snapshot.pages[page] == next.pages[page]) == (page != changed));
+    }
+    CHECK((*snapshot.pages[changed])[0] == 0x12);
+    CHECK((*next.pages[changed])[0] == 0x34);
+  }
+
+  SECTION("Restoring an older snapshot") {
+    memory.Write(cpu::memory_start, 0x34);
+    auto next = memory.TakeSnapshot();
+    memory.RestoreSnapshot(snapshot);
+    CHECK(memory.Read(cpu::memory_start) == 0x12);
+    memory.RestoreSnapshot(next);
+    CHECK(memory.Read(cpu::memory_start) == 0x34);
+  }
+}
+
+namespace {
+class LineRecorder : public cpu::WriteObserver {
+public:
+  void OnWatchedLineWritten(std::size_t line) override {
+    lines.push_back(line);
+  }
+  std::vector<std::size_t> lines;
+};
+} // namespace
+
+TEST_CASE("Write tracking") {
+  cpu::Memory memory;
+  memory.TakeSnapshot();
+  memory.TakeDirtyPages();
+  memory.TakeWrittenLines();
+
+  SECTION("Dirty pages until taken") {
+    CHECK(memory.GetDirtyPages() == 0);
+    memory.Write(0x345, 0x1);
+    memory.WriteUint16(0x5FF, 0x0203);
+    CHECK(memory.GetDirtyPages() == (1U << 3 | 1U << 5 | 1U << 6));
+    CHECK(memory.TakeDirtyPages() == (1U << 3 | 1U << 5 | 1U << 6));
+    CHECK(memory.GetDirtyPages() == 0);
+  }
+
+  SECTION("Dirty pages and snapshots do not interfere") {
+    memory.Write(0x345, 0x1);
+    // A snapshot leaves the dirty pages to their consumer.
+    const auto snapshot = memory.TakeSnapshot();
+    CHECK(memory.GetDirtyPages() == 1U << 3);
+
+    // Taking them leaves the page for the next snapshot to copy.
+    memory.Write(0x346, 0x2);
+    CHECK(memory.TakeDirtyPages() == 1U << 3);
+    CHECK(memory.TakeSnapshot().pages[3] != snapshot.pages[3]);
+
+    // Restoring dirties the pages it changes.
+    memory.RestoreSnapshot(snapshot);
+    CHECK(memory.GetDirtyPages() == 1U << 3);
+    CHECK(memory.Read(0x346) == 0);
+  }
+
+  SECTION("Written lines until taken") {
+    const std::vector<std::uint8_t> code = {0x1, 0x2, 0x3};
+    REQUIRE(memory.LoadIntoMemory(code, 0x30E));
+    const auto written = memory.TakeWrittenLines();
+    CHECK(written[0x30 / 64] == (3ULL << (0x30 % 64)));
+    CHECK_FALSE(memory.HasWrittenLines());
+  }
+
+  SECTION("Observer hears about watched lines only") {
+    LineRecorder recorder;
+    memory.SetWriteObserver(&recorder);
+    cpu::LineMask watched{};
+    watched[0x21 / 64] |= 1ULL << (0x21 % 64);
+    memory.SetWatchedLines(watched);
+
+    memory.Write(0x200, 0x1);
+    memory.Store(0x21F, 0x2);
+    memory.Store(0x1210, 0x3);
+    CHECK(recorder.lines == std::vector<std::size_t>{0x21, 0x21});
+
+    memory.SetWriteObserver(nullptr);
+    memory.Write(0x210, 0x4);
+    CHECK(recorder.lines.size() == 2);
+  }
+}
+
+TEST_CASE("Register file") {
+  cpu::CpuState state;
+  for (std::uint8_t index = 0; index < cpu::register_count; ++index) {
+    state.registers.V[index] = index * 3;
+  }
+
+  SECTION("Indexed by register nibble") {
+    CHECK(state.registers[0x0] == 0);
+    CHECK(state.registers[0xF] == 45);
+    CHECK(&state.registers[0x1F] == &state.registers.V[0xF]);
+  }
+
+  SECTION("GetRegister reads the same storage") {
+    CHECK(&cpu::GetRegister(cpu::Register::V0, state) ==
+          &state.registers.V[0x0]);
+    CHECK(cpu::GetRegister(cpu::Register::VA, state) == 30);
+    cpu::GetRegister(cpu::Register::VDelay, state) = 7;
+    CHECK(state.registers.VDelay == 7);
+    CHECK(&cpu::GetRegister(cpu::Register::SP, state) == &state.registers.SP);
+  }
+}
+
+TEST_CASE("Random numbers") {
+  SECTION("Matches the reference sequence") {
+    cpu::Random random;
+    random.SetState({1, 2, 3, 4});
+    for (std::uint32_t expected :
+         {11520U, 0U, 5927040U, 70819200U, 2031721883U, 1637235492U}) {
+      CHECK(random.Next() == expected);
+    }
+  }
+
+  SECTION("Seeds decide the sequence") {
+    cpu::Random first(7);
+    cpu::Random second(7);
+    cpu::Random third(8);
+    bool differs = false;
+    for (int i = 0; i < 16; ++i) {
+      const auto value = first.NextByte();
+      CHECK(second.NextByte() == value);
+      differs |= third.NextByte() != value;
+    }
+    CHECK(differs);
+
+    first.Seed(8);
+    CHECK(first == cpu::Random(8));
+  }
+}
@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include "Instructions/ControlFlow.h"
+
+#include <cstdint>
+#include <vector>
+
+using Disassembler::BlockExit;
+using Disassembler::ControlFlowGraph;
+
+namespace {
+std::vector<std::uint8_t> Assemble(const std::vector<std::uint16_t> &words) {
+  std::vector<std::uint8_t> bytes;
+  for (auto word : words) {
+    bytes.push_back(static_cast<std::uint8_t>(word >> 8));
+    bytes.push_back(static_cast<std::uint8_t>(word & 0xFF));
+  }
+  return bytes;
+}
+} // namespace
+
+TEST_CASE("Control flow recovery") {
+  SECTION("Loops and skips") {
+    const auto program = Assemble({
+        0x6000, // 0x200 LD V0 0x0
+        0x7001, // 0x202 ADD V0 0x1
+        0x300A, // 0x204 SE V0 0xA
+        0x1202, // 0x206 JP 0x202
+        0x1208, // 0x208 JP 0x208
+        0xF0F0, // 0x20A sprite data
+    });
+    const auto graph = ControlFlowGraph::Analyse(program);
+    const auto &blocks = graph.GetBlocks();
+    REQUIRE(blocks.size() == 4);
+    CHECK(blocks[0].start == 0x200);
+    CHECK(blocks[0].end == 0x202);
+    CHECK(blocks[0].successors == std::vector<std::uint16_t>{0x202});
+    CHECK(blocks[1].start == 0x202);
+    CHECK(blocks[1].end == 0x206);
+    CHECK(blocks[1].successors == std::vector<std::uint16_t>{0x206, 0x208});
+    CHECK(blocks[2].successors == std::vector<std::uint16_t>{0x202});
+    CHECK(blocks[3].successors == std::vector<std::uint16_t>{0x208});
+
+    CHECK(graph.GetInstructionCount() == 5);
+    CHECK(graph.IsCode(0x209));
+    CHECK_FALSE(graph.IsCode(0x20A));
+    CHECK(graph.FindBlock(0x204) == nullptr);
+  }
+
+  SECTION("Calls and returns") {
+    const auto program = Assemble({
+        0x2206, // 0x200 CALL 0x206
+        0x220A, // 0x202 CALL 0x20A
+        0x1204, // 0x204 JP 0x204
+        0x220A, // 0x206 CALL 0x20A
+        0x00EE, // 0x208 RET
+        0x00EE, // 0x20A RET
+    });
+    const auto graph = ControlFlowGraph::Analyse(program);
+    const auto &functions = graph.GetFunctions();
+    REQUIRE(functions.size() == 3);
+    CHECK(functions[0].entry == 0x200);
+    CHECK(functions[0].blocks ==
+          std::vector<std::uint16_t>{0x200, 0x202, 0x204});
+    CHECK(functions[0].callees == std::vector<std::uint16_t>{0x206, 0x20A});
+    CHECK(functions[1].entry == 0x206);
+    CHECK(functions[1].callees == std::vector<std::uint16_t>{0x20A});
+    CHECK(functions[2].entry == 0x20A);
+    CHECK(functions[2].callees.empty());
+
+    const auto *call = graph.FindBlock(0x200);
+    REQUIRE(call != nullptr);
+    CHECK(call->calls);
+    CHECK(call->callTarget == 0x206);
+    CHECK(call->successors == std::vector<std::uint16_t>{0x202});
+    CHECK(graph.FindBlock(0x20A)->exit == BlockExit::Return);
+  }
+
+  SECTION("Indirect jumps, data and odd addresses") {
+    const auto program = Assemble({
+        0xA20A, // 0x200 LD I 0x20A
+        0x1205, // 0x202 JP 0x205
+        0x00B3, // 0x204 SYS 0x0B3, never reached as such
+        0x0000, // 0x206 at 0x205: B300 JP V0 0x300
+        0x0000, // 0x208
+        0x3C3C, // 0x20A sprite
+    });
+    const auto graph = ControlFlowGraph::Analyse(program);
+    CHECK(graph.IsInstruction(0x205));
+    CHECK_FALSE(graph.IsInstruction(0x204));
+    CHECK(graph.GetIndirectJumps() == std::vector<std::uint16_t>{0x205});
+    CHECK(graph.FindBlock(0x205)->exit == BlockExit::Indirect);
+    CHECK(graph.GetDataReferences() == std::vector<std::uint16_t>{0x20A});
+    CHECK_FALSE(graph.IsCode(0x20A));
+  }
+
+  SECTION("Running off the end halts") {
+    const auto program = Assemble({0x6001, 0x6102});
+    const auto graph = ControlFlowGraph::Analyse(program);
+    REQUIRE(graph.GetBlocks().size() == 1);
+    CHECK(graph.GetBlocks()[0].end == 0x204);
+    CHECK(graph.GetBlocks()[0].exit == BlockExit::Halt);
+  }
+}
@@ -1,9 +1,16 @@
 #include "catch.hpp"
 
+#include "Instructions/Decoder.h"
 #include "Instructions/Disassembler.h"
 
+#include <bit>
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace Instructions;
 
 TEST_CASE("Test retrieving definition") {
   for (auto &def : InstructionDefinitions) {
@@ -15,13 +22,78 @@ TEST_CASE("Test retrieving definition") {
   }
 }
 
+TEST_CASE("Decode table matches definitions") {
+  // Reference decoder: the most specific matching definition wins.
+  for (std::uint32_t word = 0; word <= 0xFFFF; ++word) {
+    const auto data = static_cast<std::uint16_t>(word);
+    const InstructionDef *expected = &IllegalInstructionDef;
+    for (auto &def : InstructionDefinitions) {
+      if (def.ContainsOpcode(data) &&
+          (expected == &IllegalInstructionDef ||
+           std::popcount(def.GetOpcodeMask()) >
+               std::popcount(expected->GetOpcodeMask()))) {
+        expected = &def;
+      }
+    }
+    const auto &def = GetDefinition(data);
+    INFO("Decoding: 0x" << std::hex << word);
+    REQUIRE(def.GetOpcode() == expected->GetOpcode());
+    REQUIRE(def.GetOpcodeNum() == expected->GetOpcodeNum());
+  }
+}
+
+TEST_CASE("Decode") {
+  SECTION("Operands") {
+    constexpr auto drw = Decode(0xD12F);
+    static_assert(drw.opcode == Opcode::DRW);
+    CHECK(drw.x == 0x1);
+    CHECK(drw.y == 0x2);
+    CHECK(drw.n == 0xF);
+    CHECK(drw.kk == 0x2F);
+    CHECK(drw.nnn == 0x12F);
+  }
+
+  SECTION("Exact system instructions") {
+    CHECK(Decode(0x00E0).opcode == Opcode::CLS);
+    CHECK(Decode(0x00EE).opcode == Opcode::RET);
+    CHECK(Decode(0x01E0).opcode == Opcode::SYS);
+    CHECK(Decode(0x10E0).opcode == Opcode::JP);
+    CHECK(Decode(0x10EE).opcode == Opcode::JP);
+  }
+
+  SECTION("Illegal") {
+    for (std::uint16_t data : {0x5001, 0x800F, 0x9FF1, 0xE000, 0xF0FF}) {
+      INFO("Decoding: 0x" << std::hex << data);
+      CHECK(Decode(data).opcode == Opcode::ILLEGAL);
+      CHECK(Disassembler::GetInstructionDef(data).GetNemonic() == "ILLEGAL");
+    }
+  }
+}
+
 TEST_CASE("Disassemble To String") {
   std::vector<std::uint16_t> input = {0x00E0, 0x610F, 0x620A, 0x8124};
   auto disassembled = Disassembler::DisassembleToString(input);
   INFO("Checking Disassembly: " << disassembled);
-  auto expected = "0x600 CLS\n"
-                  "0x602 LD V1 0xf\n"
-                  "0x604 LD V2 0xa\n"
-                  "0x606 ADD V1 V2\n";
+  auto expected = "0x200\te0\tCLS\n"
+                  "0x202\t610f\tLD V1 0xf\n"
+                  "0x204\t620a\tLD V2 0xa\n"
+                  "0x206\t8124\tADD V1 V2\n";
   CHECK(disassembled == expected);
 }
+
+TEST_CASE("Format matches Dump") {
+  for (std::uint16_t address : {0x200, 0xFFE}) {
+    for (std::uint32_t word = 0; word <= 0xFFFF; ++word) {
+      std::unique_ptr<Instruction> instruction(Disassembler::Disassemble(
+          static_cast<std::uint16_t>(word), address));
+      std::ostringstream dumped;
+      instruction->Dump(dumped);
+
+      char line[Disassembler::max_line_size];
+      char *end =
+          Disassembler::Format(static_cast<std::uint16_t>(word), address, line);
+      REQUIRE(end - line <= static_cast<std::ptrdiff_t>(sizeof(line)));
+      REQUIRE(std::string(line, end - line) == dumped.str());
+    }
+  }
+}
@@ -0,0 +1,170 @@
+#include "catch.hpp"
+
+#include "Emulator/BlockCache.h"
+#include "Emulator/Emulator.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+std::filesystem::path WriteRom(const std::string &name,
+                               const std::vector<std::uint16_t> &words) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream os(path, std::ios::binary);
+  for (auto word : words) {
+    os.put(static_cast<char>(word >> 8));
+    os.put(static_cast<char>(word & 0xFF));
+  }
+  return path;
+}
+
+void CheckSameState(const cpu::CpuState &lhs, const cpu::CpuState &rhs) {
+  CHECK(lhs.registers.V == rhs.registers.V);
+  CHECK(lhs.registers.I == rhs.registers.I);
+  CHECK(lhs.registers.PC == rhs.registers.PC);
+  CHECK(lhs.registers.SP == rhs.registers.SP);
+  CHECK(lhs.registers.VDelay == rhs.registers.VDelay);
+  CHECK(lhs.display.GetScreen() == rhs.display.GetScreen());
+  for (std::uint16_t address = cpu::memory_start; address < cpu::memory_size;
+       ++address) {
+    REQUIRE(lhs.memory.Read(address) == rhs.memory.Read(address));
+  }
+}
+} // namespace
+
+TEST_CASE("Block compilation") {
+  cpu::Memory memory;
+  // LD V1 0x1, ADD V1 0x1, SE V1 0x5, JP 0x202, LD V2 0x2
+  const std::vector<std::uint8_t> code = {0x61, 0x01, 0x71, 0x01, 0x31,
+                                          0x05, 0x12, 0x02, 0x62, 0x02};
+  REQUIRE(memory.LoadIntoMemory(code, cpu::memory_start));
+  emulator::BlockCache cache;
+
+  SECTION("Blocks end after skips and jumps") {
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    CHECK(block->code.size() == 3);
+    CHECK(block->end == 0x206);
+    CHECK(cache.Get(0x200, memory) == block);
+
+    auto *jump = cache.Get(0x206, memory);
+    REQUIRE(jump != nullptr);
+    CHECK(jump->code.size() == 1);
+    CHECK(cache.GetBlockCount() == 2);
+  }
+
+  SECTION("Blocks end before instructions without a handler") {
+    memory.WriteUint16(0x204, 0x0123); // SYS 0x123
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    CHECK(block->code.size() == 2);
+    CHECK(cache.Get(0x204, memory) == nullptr);
+  }
+
+  SECTION("Blocks end after key skips") {
+    memory.WriteUint16(0x202, 0xE0A1); // SKNP V0
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    CHECK(block->code.size() == 2);
+    CHECK(block->end == 0x204);
+    CHECK_FALSE(block->skipJump);
+  }
+
+  SECTION("Writes invalidate overlapping blocks only") {
+    cache.Get(0x200, memory);
+    cache.Get(0x208, memory);
+    memory.TakeWrittenLines();
+
+    memory.Store(0x300, 0xFF);
+    CHECK_FALSE(cache.Invalidate(memory.TakeWrittenLines()));
+    CHECK(cache.GetBlockCount() == 2);
+
+    memory.Store(0x203, 0x02);
+    CHECK(cache.Invalidate(memory.TakeWrittenLines()));
+    CHECK(cache.GetBlockCount() == 0);
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    CHECK(block->code[1].operands.kk == 0x02);
+  }
+
+  SECTION("Observed writes mark blocks stale") {
+    memory.SetWriteObserver(&cache);
+    cache.Get(0x200, memory);
+    memory.Store(0x300, 0xFF);
+    CHECK_FALSE(cache.HasStaleBlocks());
+
+    memory.Store(0x203, 0x02);
+    CHECK(cache.HasStaleBlocks());
+    CHECK(cache.InvalidateStale());
+    CHECK_FALSE(cache.HasStaleBlocks());
+    CHECK(cache.GetBlockCount() == 0);
+    memory.SetWriteObserver(nullptr);
+  }
+}
+
+TEST_CASE("Threaded engine") {
+  SECTION("Matches the interpreter") {
+    const std::vector<std::vector<std::uint16_t>> roms = {
+        // Arithmetic with skips
+        {0x6001, 0x7101, 0x8214, 0x3100, 0x8325, 0x8413, 0x1202},
+        // Draws digits and counts down the delay timer
+        {0x6A10, 0xFA15, 0xF029, 0xD125, 0x7103, 0x7201, 0x7001, 0xFB07,
+         0x1204},
+        // BCD into memory and back
+        {0xA300, 0xF333, 0xF265, 0x7301, 0x1202},
+        // Subroutine calls
+        {0x2206, 0x7101, 0x1200, 0x7001, 0x00EE},
+    };
+    for (std::size_t i = 0; i < roms.size(); ++i) {
+      auto path = WriteRom("test_threaded.ch8", roms[i]);
+      auto interpreter = std::make_unique<emulator::Emulator>();
+      auto threaded = std::make_unique<emulator::Emulator>();
+      threaded->SetEngine(emulator::Engine::Threaded);
+      REQUIRE(interpreter->LoadGame(path));
+      REQUIRE(threaded->LoadGame(path));
+
+      for (std::uint64_t budget : {1, 7, 100, 1000}) {
+        CHECK(interpreter->RunFor(budget) == budget);
+        CHECK(threaded->RunFor(budget) == budget);
+        CheckSameState(interpreter->GetState(), threaded->GetState());
+      }
+      std::filesystem::remove(path);
+    }
+  }
+
+  SECTION("Runs code it overwrote") {
+    auto path = WriteRom("test_threaded_smc.ch8",
+                         {
+                             0x6170, // LD V1 0x70
+                             0x2210, // CALL 0x210
+                             0xA211, // LD I 0x211
+                             0x6005, // LD V0 0x05
+                             0xF055, // LD [I] V0, ADD V1 0x1 -> ADD V1 0x5
+                             0x2210, // CALL 0x210
+                             0x120C, // JP 0x20C
+                             0x0000, //
+                             0x7101, // ADD V1 0x1
+                             0x00EE, // RET
+                         });
+    emulator::Emulator emulator;
+    emulator.SetEngine(emulator::Engine::Threaded);
+    REQUIRE(emulator.LoadGame(path));
+    emulator.RunFor(100);
+    CHECK(emulator.GetState().registers.V[0x1] == 0x70 + 1 + 5);
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Halts on instructions it cannot execute") {
+    auto path = WriteRom("test_threaded_halt.ch8", {0x6001, 0x0123});
+    emulator::Emulator emulator;
+    emulator.SetEngine(emulator::Engine::Threaded);
+    REQUIRE(emulator.LoadGame(path));
+    CHECK(emulator.RunFor(10) == 1);
+    CHECK(emulator.GetState().registers.PC == 0x202);
+    std::filesystem::remove(path);
+  }
+}
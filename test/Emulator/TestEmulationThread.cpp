@@ -0,0 +1,157 @@
+#include "catch.hpp"
+
+#include "Emulator/EmulationThread.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+std::filesystem::path WriteRom(const std::string &name,
+                               const std::vector<std::uint16_t> &words) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream os(path, std::ios::binary);
+  for (auto word : words) {
+    os.put(static_cast<char>(word >> 8));
+    os.put(static_cast<char>(word & 0xFF));
+  }
+  return path;
+}
+
+/// Takes frames until one matches, returns false when none did in time.
+bool WaitForFrame(emulator::EmulationThread &thread,
+                  const std::function<bool(const emulator::Frame &)> &match) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (thread.UpdateFrame() && match(thread.GetFrame())) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+} // namespace
+
+TEST_CASE("Emulation thread") {
+  // Draws the digit 0 in the top left corner, then loops forever.
+  auto path = WriteRom("test_emulation_thread.ch8",
+                       {0x6000, 0xF029, 0xD005, 0x1206});
+  emulator::EmulationThread thread(emulator::Pacing::Unthrottled);
+  CHECK_FALSE(thread.UpdateFrame());
+
+  REQUIRE(thread.Send({emulator::CommandType::Load, path}));
+  REQUIRE(WaitForFrame(thread, [](const emulator::Frame &frame) {
+    return frame.instructions >= 3;
+  }));
+  CHECK(thread.GetFrame().screen[0][0] >> 56 == 0xF0);
+  CHECK(thread.GetFrame().width == Output::lowres_display_width);
+
+  SECTION("Pauses and steps") {
+    REQUIRE(thread.Send({emulator::CommandType::Pause, {}}));
+    REQUIRE(WaitForFrame(thread, [](const emulator::Frame &frame) {
+      return frame.paused;
+    }));
+    const auto paused = thread.GetFrame().instructions;
+    REQUIRE(thread.Send({emulator::CommandType::Step, {}}));
+    REQUIRE(WaitForFrame(thread, [&](const emulator::Frame &frame) {
+      return frame.instructions == paused + 1;
+    }));
+    CHECK(thread.GetFrame().paused);
+  }
+
+  SECTION("Resets and stays paused") {
+    REQUIRE(thread.Send({emulator::CommandType::Pause, {}}));
+    REQUIRE(thread.Send({emulator::CommandType::Reset, {}}));
+    REQUIRE(WaitForFrame(thread, [](const emulator::Frame &frame) {
+      return frame.instructions == 0;
+    }));
+    const auto &frame = thread.GetFrame();
+    CHECK(frame.paused);
+    CHECK(frame.damage == ~Output::RowMask{0});
+    CHECK(frame.screen[0][0] == 0);
+
+    REQUIRE(thread.Send({emulator::CommandType::TogglePause, {}}));
+    CHECK(WaitForFrame(thread, [](const emulator::Frame &frame) {
+      return !frame.paused && frame.instructions >= 3;
+    }));
+  }
+
+  SECTION("Uncapped, only publishes frames the frontend takes") {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(thread.UpdateFrame());
+    const auto taken = thread.GetFrame().number;
+    // Thousands of frames pass, one of them is published.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(thread.UpdateFrame());
+    CHECK(thread.GetFrame().number == taken + 1);
+    CHECK_FALSE(thread.UpdateFrame());
+  }
+
+  SECTION("Switches speed without touching the machine") {
+    emulator::Command command{emulator::CommandType::SetSpeed, {}};
+    command.speed = 2;
+    REQUIRE(thread.Send(command));
+    REQUIRE(WaitForFrame(thread, [](const emulator::Frame &frame) {
+      return frame.speed == 2;
+    }));
+    const auto before = thread.GetFrame().instructions;
+    command.speed = 0;
+    REQUIRE(thread.Send(command));
+    REQUIRE(WaitForFrame(thread, [&](const emulator::Frame &frame) {
+      return frame.speed == 0 && frame.instructions > before;
+    }));
+    CHECK(thread.GetFrame().screen[0][0] >> 56 == 0xF0);
+  }
+
+  SECTION("Keeps the game when loading fails") {
+    REQUIRE(thread.Send({emulator::CommandType::Pause, {}}));
+    REQUIRE(WaitForFrame(thread, [](const emulator::Frame &frame) {
+      return frame.paused;
+    }));
+    const auto paused = thread.GetFrame().instructions;
+    REQUIRE(thread.Send(
+        {emulator::CommandType::Load, path.string() + ".missing"}));
+    REQUIRE(thread.Send({emulator::CommandType::Step, {}}));
+    REQUIRE(WaitForFrame(thread, [&](const emulator::Frame &frame) {
+      return frame.instructions == paused + 1;
+    }));
+    CHECK(thread.GetFrame().screen[0][0] >> 56 == 0xF0);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Emulation thread sleeps while waiting for a key") {
+  // Waits for a key, then draws its digit in the top left corner.
+  auto path = WriteRom("test_emulation_thread_wait.ch8",
+                       {0xF10A, 0xF129, 0xD005, 0x1206});
+  emulator::EmulationThread thread;
+  REQUIRE(thread.Send({emulator::CommandType::Load, path}));
+  REQUIRE(WaitForFrame(thread, [](const emulator::Frame &frame) {
+    return frame.waitingForKey;
+  }));
+  // Asleep, so not a single frame follows.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  CHECK_FALSE(thread.UpdateFrame());
+
+  SECTION("Wakes up on a key press") {
+    thread.PressKey(input::KEY::KEY_7);
+    REQUIRE(WaitForFrame(thread, [](const emulator::Frame &frame) {
+      return frame.screen[1][0] >> 56 == 0x10;
+    }));
+    CHECK_FALSE(thread.GetFrame().waitingForKey);
+  }
+
+  SECTION("Wakes up for commands") {
+    REQUIRE(thread.Send({emulator::CommandType::Pause, {}}));
+    CHECK(WaitForFrame(thread, [](const emulator::Frame &frame) {
+      return frame.paused;
+    }));
+  }
+  std::filesystem::remove(path);
+}
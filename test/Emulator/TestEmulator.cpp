@@ -0,0 +1,506 @@
+#include "catch.hpp"
+
+#include "Emulator/Emulator.h"
+#include "Emulator/InstructionCache.h"
+#include "Emulator/Jit.h"
+#include "Input/KeyManager.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+std::filesystem::path WriteRom(const std::string &name,
+                               const std::vector<std::uint8_t> &rom) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream os(path, std::ios::binary);
+  os.write(reinterpret_cast<const char *>(rom.data()), rom.size());
+  return path;
+}
+} // namespace
+
+TEST_CASE("Instruction cache") {
+  emulator::InstructionCache cache;
+
+  SECTION("Reuses decoded instructions") {
+    auto *first = cache.Get(cpu::instruction_start, 0x610F);
+    auto *second = cache.Get(cpu::instruction_start, 0x610F);
+    CHECK(first == second);
+    CHECK(first->GetOpcode() == Instructions::Opcode::LDxkk);
+    CHECK(first->GetAddress() == cpu::instruction_start);
+  }
+
+  SECTION("Decodes again when memory changed") {
+    cache.Get(cpu::instruction_start, 0x610F);
+    auto *changed = cache.Get(cpu::instruction_start, 0x8124);
+    CHECK(changed->GetData() == 0x8124);
+    CHECK(changed->GetOpcode() == Instructions::Opcode::ADDxy);
+  }
+}
+
+TEST_CASE("Stepping") {
+  // LD V1 0xF, ADD V1 0x1, JP 0x202
+  auto path = WriteRom("test_emulator_step.ch8",
+                       {0x61, 0x0F, 0x71, 0x01, 0x12, 0x02});
+  emulator::Emulator emulator;
+  REQUIRE(emulator.LoadGame(path));
+
+  emulator.Step();
+  CHECK(emulator.GetState().registers.V[0x1] == 0x0F);
+  CHECK(emulator.GetState().registers.PC == cpu::instruction_start + 2);
+
+  for (int i = 0; i < 10; ++i) {
+    emulator.Step();
+    emulator.Step();
+  }
+  CHECK(emulator.GetState().registers.V[0x1] == 0x0F + 10);
+  CHECK(emulator.GetState().registers.PC == cpu::instruction_start + 2);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Running calls back before every frame") {
+  // ADD V0 0x1 three times, then SYS, which halts
+  auto path = WriteRom("test_emulator_run.ch8",
+                       {0x70, 0x01, 0x70, 0x01, 0x70, 0x01, 0x00, 0x00});
+  emulator::Emulator emulator;
+  emulator.GetScheduler().SetInstructionsPerFrame(2);
+  REQUIRE(emulator.LoadGame(path));
+  std::vector<std::uint8_t> seen;
+  emulator.Run([&seen](emulator::Emulator &running) {
+    seen.push_back(running.GetState().registers.V[0x0]);
+  });
+  CHECK(seen == std::vector<std::uint8_t>{0, 2});
+  CHECK(emulator.GetState().registers.PC == 0x206);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Snapshots") {
+  // LD V1 0xF, ADD V1 0x1, LD I 0x300, LD [I] V1, JP 0x202
+  auto path = WriteRom("test_emulator_snapshot.ch8",
+                       {0x61, 0x0F, 0x71, 0x01, 0xA3, 0x00, 0xF1, 0x55, 0x12,
+                        0x02});
+  emulator::Emulator emulator;
+  REQUIRE(emulator.LoadGame(path));
+  emulator.RunFor(5);
+  const auto snapshot = emulator.TakeSnapshot();
+  const auto &state = emulator.GetState();
+  CHECK(state.registers.V[0x1] == 0x10);
+  CHECK(state.memory.Read(0x301) == 0x10);
+
+  emulator.RunFor(40);
+  CHECK(state.registers.V[0x1] == 0x10 + 10);
+  CHECK(state.memory.Read(0x301) == 0x10 + 10);
+
+  emulator.RestoreSnapshot(snapshot);
+  CHECK(state.registers.V[0x1] == 0x10);
+  CHECK(state.registers.PC == snapshot.registers.PC);
+  CHECK(state.memory.Read(0x301) == 0x10);
+
+  // Running on from the snapshot retraces the same steps.
+  emulator.RunFor(40);
+  CHECK(state.registers.V[0x1] == 0x10 + 10);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Snapshots keep the keypad") {
+  // LD V0 0x1, LD V1 K, JP 0x204
+  auto path = WriteRom("test_emulator_snapshot_keys.ch8",
+                       {0x60, 0x01, 0xF1, 0x0A, 0x12, 0x04});
+  emulator::Emulator emulator;
+  REQUIRE(emulator.LoadGame(path));
+  const auto &state = emulator.GetState();
+
+  SECTION("A press not taken yet is taken again") {
+    emulator.RunFor(1);
+    emulator.SetKeys(1 << 6);
+    const auto snapshot = emulator.TakeSnapshot();
+    emulator.RunFor(1);
+    CHECK(state.registers.V[0x1] == 6);
+
+    emulator.SetKeys(0);
+    emulator.RestoreSnapshot(snapshot);
+    CHECK(state.keys == 1 << 6);
+    CHECK_FALSE(emulator.IsWaitingForKey());
+    emulator.RunFor(1);
+    CHECK(state.registers.PC == 0x204);
+    CHECK(state.registers.V[0x1] == 6);
+  }
+
+  SECTION("Restored in the middle of a key wait it waits again") {
+    emulator.RunFor(2);
+    REQUIRE(emulator.IsWaitingForKey());
+    const auto snapshot = emulator.TakeSnapshot();
+    emulator.SetKeys(1 << 3);
+    CHECK_FALSE(emulator.IsWaitingForKey());
+
+    emulator.RestoreSnapshot(snapshot);
+    CHECK(state.keys == 0);
+    CHECK(emulator.IsWaitingForKey());
+    emulator.RunFor(5);
+    CHECK(state.registers.PC == 0x202);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Restoring a snapshot damages the screen shown") {
+  // LD V0 0x0, LD F V0, DRW V0 V0 5, CLS, JP 0x208
+  auto path = WriteRom("test_emulator_snapshot_damage.ch8",
+                       {0x60, 0x00, 0xF0, 0x29, 0xD0, 0x05, 0x00, 0xE0, 0x12,
+                        0x08});
+  emulator::Emulator emulator;
+  REQUIRE(emulator.LoadGame(path));
+  emulator.RunFor(3);
+  emulator.AcknowledgeDamage();
+  const auto snapshot = emulator.TakeSnapshot();
+
+  // The frontend shows the cleared screen.
+  emulator.RunFor(1);
+  CHECK(emulator.AcknowledgeDamage() == 0x1F);
+
+  emulator.RestoreSnapshot(snapshot);
+  CHECK(emulator.GetState().display.GetPixel(0, 0));
+  CHECK(emulator.AcknowledgeDamage() == 0x1F);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Random numbers are reproducible") {
+  // RND V0 0xFF, LD I 0x300, LD [I] V0, ADD I V0 with V0 as offset, JP 0x200
+  auto path = WriteRom("test_emulator_random.ch8",
+                       {0xC0, 0xFF, 0xA3, 0x00, 0xF0, 0x1E, 0xF0, 0x55, 0x12,
+                        0x00});
+  auto draw = [](emulator::Emulator &emulator) {
+    std::vector<std::uint8_t> values;
+    for (int i = 0; i < 16; ++i) {
+      emulator.RunFor(5);
+      values.push_back(emulator.GetState().registers.V[0x0]);
+    }
+    return values;
+  };
+  emulator::Emulator first;
+  emulator::Emulator second;
+  REQUIRE(first.LoadGame(path));
+  REQUIRE(second.LoadGame(path));
+
+  SECTION("Same seed, same numbers") {
+    first.SetSeed(42);
+    second.SetSeed(42);
+    CHECK(draw(first) == draw(second));
+    second.SetSeed(43);
+    CHECK(draw(first) != draw(second));
+  }
+
+  SECTION("Snapshots restore the generator") {
+    const auto snapshot = first.TakeSnapshot();
+    const auto values = draw(first);
+    first.RestoreSnapshot(snapshot);
+    CHECK(draw(first) == values);
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Keys are latched at frame boundaries") {
+  // SKNP V0, ADD V1 0x1, JP 0x200
+  auto path = WriteRom("test_emulator_keys.ch8",
+                       {0xE0, 0xA1, 0x71, 0x01, 0x12, 0x00});
+  for (auto engine : {emulator::Engine::Instructions,
+                      emulator::Engine::Interpreter,
+                      emulator::Engine::Threaded}) {
+    INFO("Engine " << static_cast<int>(engine));
+    emulator::Emulator emulator;
+    emulator.SetEngine(engine);
+    REQUIRE(emulator.LoadGame(path));
+    input::KeyManager keys;
+    emulator.SetKeyManager(&keys);
+    const auto &registers = emulator.GetState().registers;
+
+    emulator.RunFor(4);
+    keys.PressKey(input::KEY::KEY_0);
+    emulator.RunFor(6);
+    CHECK(registers.V[0x1] == 0);
+    // Held for the whole next frame.
+    emulator.RunFor(10);
+    CHECK(registers.V[0x1] == 3);
+
+    keys.ReleaseKey(input::KEY::KEY_0);
+    emulator.RunFor(10);
+    const auto released = registers.V[0x1];
+    emulator.RunFor(10);
+    CHECK(registers.V[0x1] == released);
+
+    // A tap between two latches is held for one frame.
+    keys.PressKey(input::KEY::KEY_0);
+    keys.ReleaseKey(input::KEY::KEY_0);
+    emulator.RunFor(10);
+    CHECK(registers.V[0x1] == released);
+    emulator.RunFor(10);
+    CHECK(registers.V[0x1] > released);
+    const auto tapped = registers.V[0x1];
+    emulator.RunFor(10);
+    CHECK(registers.V[0x1] == tapped);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("SUBN subtracts Vx from Vy") {
+  // LD V0 0x0F, LD V1 0xFF, SUBN V0 V1, LD V4 VF, LD V2 0xFF, LD V3 0x10,
+  // SUBN V2 V3, JP 0x20E
+  auto path = WriteRom("test_emulator_subn.ch8",
+                       {0x60, 0x0F, 0x61, 0xFF, 0x80, 0x17, 0x84, 0xF0, 0x62,
+                        0xFF, 0x63, 0x10, 0x82, 0x37, 0x12, 0x0E});
+  for (bool jit : {false, true}) {
+    for (auto engine : {emulator::Engine::Instructions,
+                        emulator::Engine::Interpreter,
+                        emulator::Engine::Threaded}) {
+      INFO("Engine " << static_cast<int>(engine) << " jit " << jit);
+      emulator::Emulator emulator;
+      emulator.SetEngine(engine);
+      emulator.SetJitEnabled(jit && emulator::jit::IsSupported());
+      REQUIRE(emulator.LoadGame(path));
+      REQUIRE(emulator.RunFor(8) == 8);
+      const auto &registers = emulator.GetState().registers;
+      CHECK(registers.V[0x0] == 0xF0);
+      CHECK(registers.V[0x4] == 1);
+      CHECK(registers.V[0x2] == 0x11);
+      CHECK(registers.V[0xF] == 0);
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Equal operands do not borrow") {
+  // LD V0 0x42, LD V1 0x42, SUB V0 V1, LD V4 VF, LD V2 0x42, LD V3 0x42,
+  // SUBN V2 V3, LD V5 VF, JP 0x210
+  auto path = WriteRom("test_emulator_sub.ch8",
+                       {0x60, 0x42, 0x61, 0x42, 0x80, 0x15, 0x84, 0xF0, 0x62,
+                        0x42, 0x63, 0x42, 0x82, 0x37, 0x85, 0xF0, 0x12, 0x10});
+  for (bool jit : {false, true}) {
+    for (auto engine : {emulator::Engine::Instructions,
+                        emulator::Engine::Interpreter,
+                        emulator::Engine::Threaded}) {
+      INFO("Engine " << static_cast<int>(engine) << " jit " << jit);
+      emulator::Emulator emulator;
+      emulator.SetEngine(engine);
+      emulator.SetJitEnabled(jit && emulator::jit::IsSupported());
+      REQUIRE(emulator.LoadGame(path));
+      REQUIRE(emulator.RunFor(9) == 9);
+      const auto &registers = emulator.GetState().registers;
+      CHECK(registers.V[0x0] == 0);
+      CHECK(registers.V[0x4] == 1);
+      CHECK(registers.V[0x2] == 0);
+      CHECK(registers.V[0x5] == 1);
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Stack faults halt the machine") {
+  // Like a batch run, a ROM recursing forever or returning without a call
+  // stops short while the good ROM next to it runs its whole budget.
+  struct Case {
+    std::vector<std::uint8_t> rom;
+    std::uint64_t executed;
+    std::uint8_t sp;
+    // A faulting ROM stops on the call or return.
+    std::uint16_t pc;
+  };
+  const std::vector<Case> cases = {
+      // CALL 0x200
+      {{0x22, 0x00}, cpu::stack_size - 1, cpu::stack_size - 1, 0x200},
+      // ADD V0 0x1, RET
+      {{0x70, 0x01, 0x00, 0xEE}, 1, 0, 0x202},
+      // ADD V0 0x1, CALL 0x206, JP 0x200, RET
+      {{0x70, 0x01, 0x22, 0x06, 0x12, 0x00, 0x00, 0xEE}, 100, 0, 0x200},
+  };
+  for (bool jit : {false, true}) {
+    for (auto engine : {emulator::Engine::Instructions,
+                        emulator::Engine::Interpreter,
+                        emulator::Engine::Threaded}) {
+      for (const auto &test : cases) {
+        INFO("Engine " << static_cast<int>(engine) << " jit " << jit
+                       << " rom size " << test.rom.size());
+        auto path = WriteRom("test_emulator_stack.ch8", test.rom);
+        emulator::Emulator emulator;
+        emulator.SetEngine(engine);
+        emulator.SetJitEnabled(jit && emulator::jit::IsSupported());
+        REQUIRE(emulator.LoadGame(path));
+        CHECK(emulator.RunFor(100) == test.executed);
+        const auto &registers = emulator.GetState().registers;
+        CHECK(registers.SP == test.sp);
+        CHECK(registers.PC == test.pc);
+        std::filesystem::remove(path);
+      }
+    }
+  }
+}
+
+TEST_CASE("Unimplemented instructions halt the machine") {
+  const std::vector<std::vector<std::uint8_t>> roms = {
+      // LD V0 0x01, SYS 0x000
+      {0x60, 0x01, 0x00, 0x00},
+      // LD V0 0x01, HIGH
+      {0x60, 0x01, 0x00, 0xFF},
+      // LD V0 0x01, ILLEGAL
+      {0x60, 0x01, 0xF0, 0xFF},
+  };
+  for (bool jit : {false, true}) {
+    for (auto engine : {emulator::Engine::Instructions,
+                        emulator::Engine::Interpreter,
+                        emulator::Engine::Threaded}) {
+      for (const auto &rom : roms) {
+        INFO("Engine " << static_cast<int>(engine) << " jit " << jit
+                       << " word " << static_cast<int>(rom[2])
+                       << static_cast<int>(rom[3]));
+        auto path = WriteRom("test_emulator_unimplemented.ch8", rom);
+        emulator::Emulator emulator;
+        emulator.SetEngine(engine);
+        emulator.SetJitEnabled(jit && emulator::jit::IsSupported());
+        REQUIRE(emulator.LoadGame(path));
+        CHECK(emulator.RunFor(100) == 1);
+        const auto &registers = emulator.GetState().registers;
+        CHECK(registers.V[0x0] == 0x01);
+        CHECK(registers.PC == 0x202);
+        std::filesystem::remove(path);
+      }
+    }
+  }
+}
+
+TEST_CASE("Key waits let time pass") {
+  // LD V0 0x20, LD VDelay V0, LD V1 K, LD V2 VDelay, JP 0x208
+  auto path =
+      WriteRom("test_emulator_wait.ch8",
+               {0x60, 0x20, 0xF0, 0x15, 0xF1, 0x0A, 0xF2, 0x07, 0x12, 0x08});
+  for (auto engine : {emulator::Engine::Instructions,
+                      emulator::Engine::Interpreter,
+                      emulator::Engine::Threaded}) {
+    INFO("Engine " << static_cast<int>(engine));
+    emulator::Emulator emulator;
+    emulator.SetEngine(engine);
+    REQUIRE(emulator.LoadGame(path));
+    input::KeyManager keys;
+    emulator.SetKeyManager(&keys);
+    const auto &registers = emulator.GetState().registers;
+
+    // Counts as running the wait over and over.
+    CHECK(emulator.RunFor(100) == 100);
+    CHECK(emulator.IsWaitingForKey());
+    CHECK(registers.PC == 0x204);
+    CHECK(registers.VDelay == 0x20 - 10);
+    CHECK(emulator.GetScheduler().GetClock().instructions == 100);
+
+    // Pressed after the latch, taken at the next one.
+    keys.PressKey(input::KEY::KEY_6);
+    CHECK(emulator.RunFor(10) == 10);
+    CHECK(registers.PC == 0x204);
+    CHECK_FALSE(emulator.IsWaitingForKey());
+    emulator.RunFor(2);
+    CHECK(registers.V[0x1] == 6);
+    CHECK(registers.V[0x2] == 0x20 - 11);
+
+    // Frames passed without running tick the timers all the same.
+    emulator::Emulator passing;
+    passing.SetEngine(engine);
+    REQUIRE(passing.LoadGame(path));
+    passing.SetKeyManager(&keys);
+    const auto &passed = passing.GetState().registers;
+    passing.RunFor(10);
+    REQUIRE(passing.IsWaitingForKey());
+    passing.PassFrames(5);
+    CHECK(passing.GetScheduler().GetClock().frames == 6);
+    CHECK(passed.VDelay == 0x20 - 6);
+    passing.PassFrames(100);
+    CHECK(passed.VDelay == 0);
+
+    // A tap wakes it as well.
+    keys.PressKey(input::KEY::KEY_A);
+    keys.ReleaseKey(input::KEY::KEY_A);
+    passing.LatchKeys();
+    passing.RunFor(2);
+    CHECK(passed.V[0x1] == 0xA);
+    CHECK(passed.PC == 0x208);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Idle loops are skipped exactly") {
+  const std::vector<std::vector<std::uint8_t>> roms = {
+      // Counts passes of a delay poll leaving at 0.
+      {0x60, 0x17, 0xF0, 0x15, 0xF1, 0x07, 0x31, 0x00, 0x12, 0x04, 0x72, 0x01,
+       0x12, 0x00},
+      // A poll testing against a register, leaving at 3.
+      {0x63, 0x03, 0x60, 0x09, 0xF0, 0x15, 0xF1, 0x07, 0x51, 0x30, 0x12, 0x06,
+       0x72, 0x01, 0x12, 0x02},
+      // A poll that never leaves once the timer runs out.
+      {0x60, 0x0C, 0xF0, 0x15, 0xF1, 0x07, 0x31, 0x40, 0x12, 0x04},
+      // Draws a digit and jumps to itself.
+      {0x60, 0x00, 0xF0, 0x29, 0xD0, 0x05, 0x12, 0x06},
+  };
+  const auto trace =
+      std::filesystem::temp_directory_path() / "test_emulator_idle.trace";
+  for (auto engine : {emulator::Engine::Instructions,
+                      emulator::Engine::Interpreter,
+                      emulator::Engine::Threaded}) {
+    for (std::uint64_t perFrame : {1, 7, 10}) {
+      for (std::size_t rom = 0; rom < roms.size(); ++rom) {
+        INFO("Engine " << static_cast<int>(engine) << ", " << perFrame
+                       << " per frame, rom " << rom);
+        auto path = WriteRom("test_emulator_idle.ch8", roms[rom]);
+        // Tracing runs every instruction, the reference.
+        emulator::Emulator skipping;
+        emulator::Emulator running;
+        for (auto *emulator : {&skipping, &running}) {
+          emulator->SetEngine(engine);
+          emulator->GetScheduler().SetInstructionsPerFrame(perFrame);
+          REQUIRE(emulator->LoadGame(path));
+        }
+        REQUIRE(running.StartTrace(trace));
+        for (std::uint64_t budget : {1, 5, 40, 333, 2000}) {
+          REQUIRE(skipping.RunFor(budget) == running.RunFor(budget));
+          const auto &lhs = skipping.GetState();
+          const auto &rhs = running.GetState();
+          CHECK(lhs.registers.V == rhs.registers.V);
+          CHECK(lhs.registers.PC == rhs.registers.PC);
+          CHECK(lhs.registers.VDelay == rhs.registers.VDelay);
+          CHECK(lhs.display.GetScreen() == rhs.display.GetScreen());
+          CHECK(skipping.GetScheduler().GetClock().frameInstructions ==
+                running.GetScheduler().GetClock().frameInstructions);
+        }
+        running.StopTrace();
+        std::filesystem::remove(path);
+      }
+    }
+  }
+  std::filesystem::remove(trace);
+}
+
+TEST_CASE("Loading games") {
+  emulator::Emulator emulator;
+
+  SECTION("Fills program memory") {
+    auto path = WriteRom("test_emulator_load.ch8", {0x12, 0x34, 0x56});
+    REQUIRE(emulator.LoadGame(path));
+    CHECK(emulator.GetState().memory.Fetch(cpu::instruction_start) == 0x1234);
+    CHECK(emulator.GetState().memory.Read(cpu::instruction_start + 2) == 0x56);
+    CHECK(emulator.GetState().registers.PC == cpu::instruction_start);
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Rejects games larger than memory") {
+    auto path = WriteRom(
+        "test_emulator_large.ch8",
+        std::vector<std::uint8_t>(cpu::memory_size - cpu::memory_start + 1));
+    CHECK_FALSE(emulator.LoadGame(path));
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Rejects missing files and directories") {
+    CHECK_FALSE(emulator.LoadGame(std::filesystem::temp_directory_path() /
+                                  "test_emulator_missing.ch8"));
+    CHECK_FALSE(emulator.LoadGame(std::filesystem::temp_directory_path()));
+  }
+}
@@ -0,0 +1,263 @@
+#include "catch.hpp"
+
+#include "Emulator/Emulator.h"
+#include "Emulator/Fleet.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+std::filesystem::path WriteRom(const std::string &name,
+                               const std::vector<std::uint16_t> &words) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream os(path, std::ios::binary);
+  for (auto word : words) {
+    os.put(static_cast<char>(word >> 8));
+    os.put(static_cast<char>(word & 0xFF));
+  }
+  return path;
+}
+
+void CheckSameMachine(const emulator::Fleet &fleet, std::size_t machine,
+                      const cpu::CpuState &state) {
+  const auto registers = fleet.GetRegisters(machine);
+  CHECK(registers.V == state.registers.V);
+  CHECK(registers.I == state.registers.I);
+  CHECK(registers.PC == state.registers.PC);
+  CHECK(registers.SP == state.registers.SP);
+  CHECK(registers.VDelay == state.registers.VDelay);
+  CHECK(registers.VSound == state.registers.VSound);
+  CHECK(fleet.GetRandom(machine) == state.random);
+  CHECK(fleet.GetDisplay(machine).GetScreen() == state.display.GetScreen());
+  std::vector<std::uint8_t> lhs;
+  std::vector<std::uint8_t> rhs;
+  for (std::uint16_t address = 0; address < cpu::memory_size; ++address) {
+    lhs.push_back(fleet.Load(machine, address));
+    rhs.push_back(state.memory.Load(address));
+  }
+  CHECK(lhs == rhs);
+}
+
+/// A random program without calls, ending in a jump back to the start.
+std::vector<std::uint16_t> RandomRom(std::mt19937 &random) {
+  constexpr std::size_t length = 32;
+  auto pick = [&random](std::uint32_t bound) {
+    return static_cast<std::uint16_t>(random() % bound);
+  };
+  std::vector<std::uint16_t> words;
+  for (std::size_t i = 0; i < length - 1; ++i) {
+    const auto x = pick(16) << 8;
+    const auto y = pick(16) << 4;
+    switch (pick(12)) {
+    case 0:
+      words.push_back(0x7000 | x | pick(256));
+      break;
+    case 1:
+    case 2: {
+      constexpr std::uint16_t alu[] = {0, 1, 2, 3, 4, 5, 6, 7, 0xE};
+      words.push_back(0x8000 | x | y | alu[pick(9)]);
+      break;
+    }
+    case 3:
+      words.push_back((pick(2) ? 0x3000 : 0x4000) | x | pick(4));
+      break;
+    case 4:
+      words.push_back((pick(2) ? 0x5000 : 0x9000) | x | y);
+      break;
+    case 5:
+      words.push_back(0x1200 | pick(length) * 2);
+      break;
+    case 6:
+      // Sometimes into the program itself.
+      words.push_back(pick(2) ? (0xA300 | pick(0x100)) : (0xA200 | pick(0x40)));
+      break;
+    case 7: {
+      constexpr std::uint16_t memory[] = {0x1E, 0x33, 0x55, 0x65};
+      words.push_back(0xF000 | (x & 0x300) | memory[pick(4)]);
+      break;
+    }
+    case 8:
+      words.push_back(0xD000 | x | y | pick(16));
+      break;
+    case 9:
+      words.push_back(0xC000 | x | pick(256));
+      break;
+    case 10:
+      // Rarely a key wait, most programs would otherwise stop at one.
+      if (pick(8) == 0) {
+        words.push_back(0xF00A | x);
+      } else {
+        words.push_back(pick(2) ? (0xE09E | x) : (0xE0A1 | x));
+      }
+      break;
+    default:
+      words.push_back(pick(2) ? (0xF015 | x) : (0xF007 | x));
+      break;
+    }
+  }
+  words.push_back(0x1200);
+  return words;
+}
+
+/// Runs the rom on a fleet and on one Emulator per machine, every machine
+/// starting with different registers, and compares them after each budget.
+void CheckMatchesEmulators(const std::vector<std::uint16_t> &rom,
+                           std::size_t size) {
+  auto path = WriteRom("test_fleet.ch8", rom);
+  emulator::Fleet fleet(size);
+  REQUIRE(fleet.LoadGame(path));
+  std::vector<std::unique_ptr<emulator::Emulator>> emulators;
+  for (std::size_t machine = 0; machine < size; ++machine) {
+    auto emulator = std::make_unique<emulator::Emulator>();
+    REQUIRE(emulator->LoadGame(path));
+    // Machines draw different random numbers from the first one on.
+    emulator->SetSeed(machine);
+    fleet.Seed(machine, machine);
+    const auto keys = static_cast<input::KeyMask>(machine * 0x1357);
+    emulator->SetKeys(keys);
+    fleet.SetKeys(machine, keys);
+    // Half the machines keep the loaded state, so some stay together.
+    if (machine % 2 == 1) {
+      auto snapshot = emulator->TakeSnapshot();
+      for (std::uint8_t index = 0; index < cpu::register_count; ++index) {
+        snapshot.registers.V[index] =
+            static_cast<std::uint8_t>(machine * (index + 3));
+      }
+      snapshot.random = cpu::Random(machine * 3);
+      emulator->RestoreSnapshot(snapshot);
+      fleet.Restore(machine, snapshot);
+    }
+    emulators.push_back(std::move(emulator));
+  }
+
+  std::vector<std::uint64_t> executed(size, 0);
+  for (std::uint64_t budget : {1, 7, 300, 2000}) {
+    std::uint64_t total = 0;
+    for (std::size_t machine = 0; machine < size; ++machine) {
+      const auto count = emulators[machine]->RunFor(budget);
+      executed[machine] += count;
+      total += count;
+    }
+    REQUIRE(fleet.RunFor(budget) == total);
+    for (std::size_t machine = 0; machine < size; ++machine) {
+      CHECK(fleet.GetInstructions(machine) == executed[machine]);
+      CheckSameMachine(fleet, machine, emulators[machine]->GetState());
+    }
+  }
+  std::filesystem::remove(path);
+}
+} // namespace
+
+TEST_CASE("Fleet") {
+  SECTION("Machines are independent") {
+    auto path = WriteRom("test_fleet.ch8", {0x7001, 0x1200});
+    emulator::Fleet fleet(3);
+    REQUIRE(fleet.LoadGame(path));
+    auto emulator = std::make_unique<emulator::Emulator>();
+    REQUIRE(emulator->LoadGame(path));
+    auto snapshot = emulator->TakeSnapshot();
+    snapshot.registers.V[0x0] = 0x10;
+    fleet.Restore(1, snapshot);
+
+    CHECK(fleet.RunFor(10) == 30);
+    CHECK(fleet.GetRegisters(0).V[0x0] == 5);
+    CHECK(fleet.GetRegisters(1).V[0x0] == 0x15);
+    CHECK(fleet.GetRegisters(2).V[0x0] == 5);
+    CHECK(fleet.GetScheduler().GetClock().frames == 1);
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Machines halt on their own") {
+    // Only machines with V0 set reach the SYS instruction.
+    auto path = WriteRom("test_fleet.ch8", {0x3000, 0x0123, 0x1200});
+    emulator::Fleet fleet(4);
+    REQUIRE(fleet.LoadGame(path));
+    auto emulator = std::make_unique<emulator::Emulator>();
+    REQUIRE(emulator->LoadGame(path));
+    auto snapshot = emulator->TakeSnapshot();
+    snapshot.registers.V[0x0] = 1;
+    fleet.Restore(2, snapshot);
+
+    CHECK(fleet.RunFor(10) == 31);
+    CHECK(fleet.GetRunningCount() == 3);
+    CHECK(fleet.IsHalted(2));
+    CHECK(fleet.GetInstructions(2) == 1);
+    CHECK(fleet.GetRegisters(2).PC == 0x202);
+    CHECK(fleet.GetInstructions(3) == 10);
+    std::filesystem::remove(path);
+  }
+
+  SECTION("SUBN subtracts Vx from Vy") {
+    // LD V0 0x0F, LD V1 0xFF, SUBN V0 V1, LD V4 VF, LD V2 0xFF, LD V3 0x10,
+    // SUBN V2 V3, JP 0x20E
+    auto path = WriteRom("test_fleet.ch8", {0x600F, 0x61FF, 0x8017, 0x84F0,
+                                            0x62FF, 0x6310, 0x8237, 0x120E});
+    emulator::Fleet fleet(2);
+    REQUIRE(fleet.LoadGame(path));
+    CHECK(fleet.RunFor(8) == 16);
+    const auto registers = fleet.GetRegisters(1);
+    CHECK(registers.V[0x0] == 0xF0);
+    CHECK(registers.V[0x4] == 1);
+    CHECK(registers.V[0x2] == 0x11);
+    CHECK(registers.V[0xF] == 0);
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Equal operands do not borrow") {
+    // LD V0 0x42, LD V1 0x42, SUB V0 V1, LD V4 VF, LD V2 0x42, LD V3 0x42,
+    // SUBN V2 V3, LD V5 VF, JP 0x210
+    auto path =
+        WriteRom("test_fleet.ch8", {0x6042, 0x6142, 0x8015, 0x84F0, 0x6242,
+                                    0x6342, 0x8237, 0x85F0, 0x1210});
+    emulator::Fleet fleet(2);
+    REQUIRE(fleet.LoadGame(path));
+    CHECK(fleet.RunFor(9) == 18);
+    const auto registers = fleet.GetRegisters(1);
+    CHECK(registers.V[0x0] == 0);
+    CHECK(registers.V[0x4] == 1);
+    CHECK(registers.V[0x2] == 0);
+    CHECK(registers.V[0x5] == 1);
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Matches the emulator on a fixed rom set") {
+    const std::vector<std::vector<std::uint16_t>> roms = {
+        // Flags observed and overwritten, skips over jumps
+        {0x6001, 0x61FF, 0x8014, 0x8F14, 0x8106, 0x810E, 0x8207, 0x3F01,
+         0x1200, 0x7001, 0x8F05, 0x4000, 0x1204, 0x1200},
+        // Draws digits and counts down the delay timer
+        {0x6A10, 0xFA15, 0xF029, 0xD125, 0x7103, 0x7201, 0x7001, 0xFB07,
+         0x1204},
+        // Subroutine calls and a computed jump
+        {0x2206, 0x7101, 0x120C, 0x7001, 0x00EE, 0x0000, 0x6000, 0xB200},
+        // Machines with V0 set recurse until their stack overflows
+        {0x3000, 0x2200, 0x7101, 0x1200},
+        // Returns without a call
+        {0x7001, 0x00EE, 0x1200},
+        // Random numbers steer the skips
+        {0xC30F, 0x3305, 0x1200, 0xC4FF, 0x8434, 0x1200},
+        // Overwrites its own loop with the BCD of V0, then runs into it
+        {0xA208, 0xF033, 0x7001, 0x1200, 0x6000, 0x1208},
+        // Keys steer the skips
+        {0x7001, 0xE09E, 0x1200, 0x7101, 0xE1A1, 0x1200, 0x7201, 0x1200},
+        // Takes the pressed keys, then waits for good
+        {0x7001, 0xF10A, 0x7201, 0xF30A, 0x1200},
+    };
+    for (const auto &rom : roms) {
+      CheckMatchesEmulators(rom, 5);
+    }
+  }
+
+  SECTION("Matches the emulator on random programs across batches") {
+    std::mt19937 random(0xF1);
+    for (int i = 0; i < 16; ++i) {
+      CheckMatchesEmulators(RandomRom(random),
+                            i % 4 == 0 ? emulator::fleet_batch_size + 3 : 9);
+    }
+  }
+}
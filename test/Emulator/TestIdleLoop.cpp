@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include "Emulator/BlockCache.h"
+#include "Emulator/IdleLoop.h"
+
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("Idle loops") {
+  cpu::Memory memory;
+  // JP 0x200, LD V3 VDelay, SE V3 0x0, JP 0x202, ADD V3 0x1, JP 0x208
+  const std::vector<std::uint8_t> code = {0x12, 0x00, 0xF3, 0x07, 0x33, 0x00,
+                                          0x12, 0x02, 0x73, 0x01, 0x12, 0x08};
+  REQUIRE(memory.LoadIntoMemory(code, cpu::memory_start));
+
+  SECTION("Jumps to themselves") {
+    const auto loop = emulator::FindIdleLoop(0x200, memory);
+    CHECK(loop.length == 1);
+    CHECK_FALSE(loop.readsDelay);
+    CHECK_FALSE(loop.Leaves(cpu::Registers{}, 0));
+  }
+
+  SECTION("Polls of the delay timer") {
+    const auto loop = emulator::FindIdleLoop(0x202, memory);
+    CHECK(loop.length == 3);
+    CHECK(loop.readsDelay);
+    CHECK(loop.x == 3);
+    cpu::Registers registers;
+    registers.V[0x3] = 0;
+    CHECK_FALSE(loop.Leaves(registers, 1));
+    CHECK(loop.Leaves(registers, 0));
+
+    // Tests against another register are fine as well.
+    memory.WriteUint16(0x204, 0x5340); // SE V3 V4
+    registers.V[0x4] = 7;
+    const auto compare = emulator::FindIdleLoop(0x202, memory);
+    REQUIRE(compare.length == 3);
+    CHECK(compare.Leaves(registers, 7));
+    CHECK_FALSE(compare.Leaves(registers, 0));
+  }
+
+  SECTION("Loops with other effects are not idle") {
+    // Counts, so every pass differs.
+    CHECK(emulator::FindIdleLoop(0x208, memory).length == 0);
+    CHECK(emulator::FindIdleLoop(0x20A, memory).length == 0);
+    memory.WriteUint16(0x206, 0x1200); // JP 0x200, not back to the poll
+    CHECK(emulator::FindIdleLoop(0x202, memory).length == 0);
+    memory.WriteUint16(0x206, 0x1202);
+    memory.WriteUint16(0x204, 0xE39E); // SKP V3
+    CHECK(emulator::FindIdleLoop(0x202, memory).length == 0);
+  }
+
+  SECTION("Blocks know when they are idle loops") {
+    emulator::BlockCache cache;
+    auto *poll = cache.Get(0x202, memory);
+    REQUIRE(poll != nullptr);
+    CHECK(poll->idle.length == 3);
+    auto *count = cache.Get(0x208, memory);
+    REQUIRE(count != nullptr);
+    CHECK(count->idle.length == 0);
+  }
+}
@@ -0,0 +1,259 @@
+#include "catch.hpp"
+
+#include "Emulator/BlockCache.h"
+#include "Emulator/Emulator.h"
+#include "Emulator/Jit.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+std::filesystem::path WriteRom(const std::string &name,
+                               const std::vector<std::uint16_t> &words) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream os(path, std::ios::binary);
+  for (auto word : words) {
+    os.put(static_cast<char>(word >> 8));
+    os.put(static_cast<char>(word & 0xFF));
+  }
+  return path;
+}
+
+void CheckSameState(const cpu::CpuState &lhs, const cpu::CpuState &rhs) {
+  CHECK(lhs.registers.V == rhs.registers.V);
+  CHECK(lhs.registers.I == rhs.registers.I);
+  CHECK(lhs.registers.PC == rhs.registers.PC);
+  CHECK(lhs.registers.SP == rhs.registers.SP);
+  CHECK(lhs.registers.VDelay == rhs.registers.VDelay);
+  CHECK(lhs.display.GetScreen() == rhs.display.GetScreen());
+  for (std::uint16_t address = cpu::memory_start; address < cpu::memory_size;
+       ++address) {
+    REQUIRE(lhs.memory.Read(address) == rhs.memory.Read(address));
+  }
+}
+
+/// A random program of the instructions the JIT translates or calls out
+/// for, ending in a jump back to the start. Calls and returns are left out
+/// so the stack cannot overflow, random numbers so runs are repeatable.
+std::vector<std::uint16_t> RandomRom(std::mt19937 &random) {
+  constexpr std::size_t length = 48;
+  auto pick = [&random](std::uint32_t bound) {
+    return static_cast<std::uint16_t>(random() % bound);
+  };
+  std::vector<std::uint16_t> words;
+  for (std::size_t i = 0; i < length - 1; ++i) {
+    const auto x = pick(16) << 8;
+    const auto y = pick(16) << 4;
+    const auto kk = pick(4) == 0 ? pick(256) : pick(4);
+    switch (pick(15)) {
+    case 0:
+      words.push_back(0x6000 | x | kk);
+      break;
+    case 1:
+      words.push_back(0x7000 | x | kk);
+      break;
+    case 2:
+    case 3: {
+      constexpr std::uint16_t alu[] = {0, 1, 2, 3, 4, 5, 6, 7, 0xE};
+      words.push_back(0x8000 | x | y | alu[pick(9)]);
+      break;
+    }
+    case 4:
+      words.push_back(0x3000 | x | kk);
+      break;
+    case 5:
+      words.push_back(0x4000 | x | kk);
+      break;
+    case 6:
+      words.push_back((pick(2) ? 0x5000 : 0x9000) | x | y);
+      break;
+    case 7:
+      words.push_back(0x1200 | pick(length) * 2);
+      break;
+    case 8:
+      words.push_back(0xA300 | pick(0x100));
+      break;
+    case 9:
+      words.push_back(0xF01E | x);
+      break;
+    case 10: {
+      constexpr std::uint16_t memory[] = {0x33, 0x55, 0x65};
+      words.push_back(0xF000 | (x & 0x300) | memory[pick(3)]);
+      break;
+    }
+    case 11:
+      words.push_back(0xD000 | x | y | pick(16));
+      break;
+    case 12:
+      words.push_back(pick(2) ? (0xF029 | x) : (0xF015 | x));
+      break;
+    case 13:
+      // Rarely a key wait, most programs would otherwise stop at one.
+      if (pick(8) == 0) {
+        words.push_back(0xF00A | x);
+      } else {
+        words.push_back(pick(2) ? (0xE09E | x) : (0xE0A1 | x));
+      }
+      break;
+    default:
+      words.push_back(0xF007 | x);
+      break;
+    }
+  }
+  words.push_back(0x1200);
+  return words;
+}
+
+void CheckMatchesInterpreter(const std::vector<std::uint16_t> &rom) {
+  auto path = WriteRom("test_jit.ch8", rom);
+  auto interpreter = std::make_unique<emulator::Emulator>();
+  auto jit = std::make_unique<emulator::Emulator>();
+  jit->SetEngine(emulator::Engine::Threaded);
+  REQUIRE(interpreter->LoadGame(path));
+  REQUIRE(jit->LoadGame(path));
+  interpreter->SetKeys(0x5A3C);
+  jit->SetKeys(0x5A3C);
+  for (std::uint64_t budget : {1, 50, 3, 500, 2000}) {
+    REQUIRE(interpreter->RunFor(budget) == jit->RunFor(budget));
+    CheckSameState(interpreter->GetState(), jit->GetState());
+  }
+  std::filesystem::remove(path);
+}
+} // namespace
+
+TEST_CASE("Native blocks") {
+  if (!emulator::jit::IsSupported()) {
+    SUCCEED("No native code generation on this host");
+    return;
+  }
+
+  SECTION("Skips followed by a jump are folded") {
+    cpu::Memory memory;
+    // ADD V1 0x1, SUB V1 V2, SNE V1 0x5, JP 0x200
+    const std::vector<std::uint8_t> code = {0x71, 0x01, 0x81, 0x25,
+                                            0x41, 0x05, 0x12, 0x00};
+    REQUIRE(memory.LoadIntoMemory(code, cpu::memory_start));
+    emulator::BlockCache cache;
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    CHECK(block->skipJump);
+    CHECK(block->GetCodeEnd() == 0x208);
+    auto native = emulator::jit::Compile(*block);
+    REQUIRE(native != nullptr);
+    CHECK(native->GetMaxInstructions() == 4);
+
+    cpu::CpuState state;
+    state.registers.PC = 0x200;
+    state.registers.V[0x2] = 0x1;
+    state.registers.V[0xF] = 0x7;
+    CHECK(native->Run(state) == 3);
+    CHECK(state.registers.PC == 0x208);
+    CHECK(state.registers.V[0x1] == 0x00);
+    CHECK(state.registers.V[0xF] == 0x1);
+
+    state.registers.V[0x1] = 0x05;
+    CHECK(native->Run(state) == 4);
+    CHECK(state.registers.PC == 0x200);
+    CHECK(state.registers.V[0x1] == 0x05);
+    CHECK(state.registers.V[0xF] == 0x1);
+
+    // A write to the folded jump drops the block.
+    memory.TakeWrittenLines();
+    memory.Store(0x207, 0x02);
+    CHECK(cache.Invalidate(memory.TakeWrittenLines()));
+  }
+
+  SECTION("SUBN subtracts Vx from Vy") {
+    cpu::Memory memory;
+    // SUBN V1 V2, LD V4 VF, SUBN V2 V3, JP 0x200
+    const std::vector<std::uint8_t> code = {0x81, 0x27, 0x84, 0xF0,
+                                            0x82, 0x37, 0x12, 0x00};
+    REQUIRE(memory.LoadIntoMemory(code, cpu::memory_start));
+    emulator::BlockCache cache;
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    auto native = emulator::jit::Compile(*block);
+    REQUIRE(native != nullptr);
+
+    cpu::CpuState state;
+    state.registers.PC = 0x200;
+    state.registers.V[0x1] = 0x0F;
+    state.registers.V[0x2] = 0xFF;
+    state.registers.V[0x3] = 0x10;
+    CHECK(native->Run(state) == 4);
+    CHECK(state.registers.V[0x1] == 0xF0);
+    CHECK(state.registers.V[0x4] == 1);
+    CHECK(state.registers.V[0x2] == 0x11);
+    CHECK(state.registers.V[0xF] == 0);
+  }
+
+  SECTION("Equal operands do not borrow") {
+    cpu::Memory memory;
+    // SUB V0 V1, LD V4 VF, SUBN V2 V3, JP 0x200
+    const std::vector<std::uint8_t> code = {0x80, 0x15, 0x84, 0xF0,
+                                            0x82, 0x37, 0x12, 0x00};
+    REQUIRE(memory.LoadIntoMemory(code, cpu::memory_start));
+    emulator::BlockCache cache;
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    auto native = emulator::jit::Compile(*block);
+    REQUIRE(native != nullptr);
+
+    cpu::CpuState state;
+    state.registers.PC = 0x200;
+    state.registers.V = {0x42, 0x42, 0x42, 0x42};
+    CHECK(native->Run(state) == 4);
+    CHECK(state.registers.V[0x0] == 0);
+    CHECK(state.registers.V[0x4] == 1);
+    CHECK(state.registers.V[0x2] == 0);
+    CHECK(state.registers.V[0xF] == 1);
+  }
+
+  SECTION("Blocks using too many registers stay threaded") {
+    cpu::Memory memory;
+    std::vector<std::uint8_t> code;
+    for (std::uint8_t x = 0; x <= emulator::jit::max_block_registers; ++x) {
+      code.push_back(0x60 | x);
+      code.push_back(x);
+    }
+    REQUIRE(memory.LoadIntoMemory(code, cpu::memory_start));
+    emulator::BlockCache cache;
+    auto *block = cache.Get(0x200, memory);
+    REQUIRE(block != nullptr);
+    CHECK(emulator::jit::Compile(*block) == nullptr);
+  }
+
+  SECTION("Matches the interpreter on a fixed rom set") {
+    const std::vector<std::vector<std::uint16_t>> roms = {
+        // Flags observed and overwritten, skips over jumps
+        {0x6001, 0x61FF, 0x8014, 0x8F14, 0x8106, 0x810E, 0x8207, 0x3F01,
+         0x1200, 0x7001, 0x8F05, 0x4000, 0x1204, 0x1200},
+        // Draws digits and counts down the delay timer
+        {0x6A10, 0xFA15, 0xF029, 0xD125, 0x7103, 0x7201, 0x7001, 0xFB07,
+         0x1204},
+        // BCD into memory and back
+        {0xA300, 0xF333, 0xF265, 0x7301, 0x1202},
+        // Subroutine calls and a computed jump
+        {0x2206, 0x7101, 0x120C, 0x7001, 0x00EE, 0x0000, 0x6000, 0xB200},
+        // Key skips over jumps and increments
+        {0x7001, 0xE09E, 0x1200, 0x7101, 0xE1A1, 0x1200, 0x7201, 0x1200},
+        // Takes the pressed keys, then waits for good
+        {0x7001, 0xF10A, 0x7201, 0xF30A, 0x1200},
+    };
+    for (const auto &rom : roms) {
+      CheckMatchesInterpreter(rom);
+    }
+  }
+
+  SECTION("Matches the interpreter on random programs") {
+    std::mt19937 random(0xC8);
+    for (int i = 0; i < 200; ++i) {
+      CheckMatchesInterpreter(RandomRom(random));
+    }
+  }
+}
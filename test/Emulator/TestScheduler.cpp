@@ -0,0 +1,93 @@
+#include "catch.hpp"
+
+#include "Emulator/Emulator.h"
+#include "Emulator/Scheduler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+TEST_CASE("Virtual clock") {
+  emulator::Scheduler scheduler(3);
+
+  SECTION("Frames end every instructions per frame") {
+    std::vector<bool> boundaries;
+    for (int i = 0; i < 7; ++i) {
+      boundaries.push_back(scheduler.Advance());
+    }
+    CHECK(boundaries ==
+          std::vector<bool>{false, false, true, false, false, true, false});
+    CHECK(scheduler.GetClock().instructions == 7);
+    CHECK(scheduler.GetClock().frames == 2);
+    CHECK(scheduler.InstructionsUntilFrame() == 2);
+  }
+
+  SECTION("Restoring the clock restores the frame phase") {
+    scheduler.Advance();
+    const auto clock = scheduler.GetClock();
+    scheduler.Advance();
+    scheduler.Advance();
+    scheduler.SetClock(clock);
+    CHECK_FALSE(scheduler.Advance());
+    CHECK(scheduler.Advance());
+  }
+
+  SECTION("Real time pacing waits for the frame deadline") {
+    scheduler.SetInstructionsPerFrame(1);
+    scheduler.SetPacing(emulator::Pacing::RealTime);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 6; ++i) {
+      REQUIRE(scheduler.Advance());
+      scheduler.WaitForFrame();
+    }
+    // Six frames at 60Hz take 100ms.
+    CHECK(std::chrono::steady_clock::now() - start >=
+          std::chrono::milliseconds(95));
+  }
+
+  SECTION("Speed scales the frame rate") {
+    scheduler.SetInstructionsPerFrame(1);
+    scheduler.SetPacing(emulator::Pacing::RealTime);
+    scheduler.SetSpeed(4);
+    CHECK(scheduler.GetFrameDuration() == emulator::frame_duration / 4);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 24; ++i) {
+      REQUIRE(scheduler.Advance());
+      scheduler.WaitForFrame();
+    }
+    // Twenty four frames at 240Hz take 100ms.
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(elapsed >= std::chrono::milliseconds(95));
+    CHECK(elapsed < std::chrono::milliseconds(390));
+  }
+}
+
+TEST_CASE("Timers count down once per frame") {
+  // LD V1 0x5, LD DT V1, LD ST V1, JP 0x206
+  auto path = std::filesystem::temp_directory_path() / "test_scheduler.ch8";
+  {
+    std::ofstream os(path, std::ios::binary);
+    const std::vector<std::uint8_t> rom = {0x61, 0x05, 0xF1, 0x15,
+                                           0xF1, 0x18, 0x12, 0x06};
+    os.write(reinterpret_cast<const char *>(rom.data()), rom.size());
+  }
+  emulator::Emulator emulator;
+  emulator.GetScheduler().SetInstructionsPerFrame(4);
+  REQUIRE(emulator.LoadGame(path));
+  const auto &registers = emulator.GetState().registers;
+
+  emulator.RunFor(3);
+  CHECK(registers.VDelay == 5);
+  CHECK(registers.VSound == 5);
+  emulator.RunFor(1);
+  CHECK(registers.VDelay == 4);
+  CHECK(registers.VSound == 4);
+  emulator.RunFor(4 * 10);
+  CHECK(registers.VDelay == 0);
+  CHECK(registers.VSound == 0);
+  CHECK(emulator.GetScheduler().GetClock().frames == 11);
+
+  std::filesystem::remove(path);
+}
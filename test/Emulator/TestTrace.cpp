@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include "Emulator/Emulator.h"
+#include "Emulator/Trace.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::filesystem::path WriteRom(const std::string &name,
+                               const std::vector<std::uint8_t> &rom) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream os(path, std::ios::binary);
+  os.write(reinterpret_cast<const char *>(rom.data()), rom.size());
+  return path;
+}
+
+std::vector<emulator::TraceRecord>
+ReadRecords(const std::filesystem::path &path) {
+  std::ifstream is(path, std::ios::binary);
+  char magic[sizeof(emulator::trace_magic)];
+  is.read(magic, sizeof(magic));
+  std::vector<emulator::TraceRecord> records;
+  emulator::TraceRecord record;
+  while (emulator::ReadRecord(is, record)) {
+    records.push_back(record);
+  }
+  return records;
+}
+} // namespace
+
+TEST_CASE("Tracing") {
+  // LD V1 0xF, ADD V1 0x1, LD I 0x300, JP 0x202
+  auto rom = WriteRom("test_trace.ch8",
+                      {0x61, 0x0F, 0x71, 0x01, 0xA3, 0x00, 0x12, 0x02});
+  auto trace = std::filesystem::temp_directory_path() / "test_trace.bin";
+  emulator::Emulator emulator;
+  REQUIRE(emulator.LoadGame(rom));
+
+  SECTION("Records every instruction") {
+    REQUIRE(emulator.StartTrace(trace));
+    emulator.RunFor(7);
+    emulator.StopTrace();
+
+    const auto records = ReadRecords(trace);
+    REQUIRE(records.size() == 7);
+    CHECK(records[0].cycle == 0);
+    CHECK(records[0].pc == 0x200);
+    CHECK(records[0].word == 0x610F);
+    CHECK(records[0].changedRegister == 1);
+    CHECK(records[0].changedValue == 0x0F);
+    CHECK(records[2].word == 0xA300);
+    CHECK(records[2].changedRegister == emulator::no_register);
+    CHECK(records[2].i == 0x300);
+    CHECK(records[4].cycle == 4);
+    CHECK(records[4].pc == 0x202);
+    CHECK(records[4].changedValue == 0x11);
+  }
+
+  SECTION("Identical runs write identical traces") {
+    auto again = std::filesystem::temp_directory_path() / "test_trace2.bin";
+    REQUIRE(emulator.StartTrace(trace));
+    emulator.RunFor(7);
+    emulator.StopTrace();
+    emulator::Emulator second;
+    REQUIRE(second.LoadGame(rom));
+    REQUIRE(second.StartTrace(again));
+    second.RunFor(7);
+    second.StopTrace();
+
+    auto read = [](const std::filesystem::path &path) {
+      std::ifstream is(path, std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(is), {});
+    };
+    const auto bytes = read(trace);
+    CHECK(bytes.size() ==
+          sizeof(emulator::trace_magic) + 7 * emulator::trace_record_size);
+    CHECK(bytes == read(again));
+    std::filesystem::remove(again);
+  }
+
+  SECTION("Decodes binary traces to text") {
+    REQUIRE(emulator.StartTrace(trace));
+    emulator.RunFor(2);
+    emulator.StopTrace();
+
+    std::ifstream is(trace, std::ios::binary);
+    std::ostringstream text;
+    REQUIRE(emulator::DecodeTrace(is, text));
+    CHECK(text.str() ==
+          "0\t0x200\t610f\tLD V1 0xf\tV1=0xf\tVF=0x0\tI=0x0\n"
+          "1\t0x202\t7101\tADD V1 0x1\tV1=0x10\tVF=0x0\tI=0x0\n");
+
+    std::istringstream notATrace("not a trace");
+    CHECK_FALSE(emulator::DecodeTrace(notATrace, text));
+  }
+
+  SECTION("Level off records nothing") {
+    REQUIRE(emulator.StartTrace(trace));
+    emulator.SetTraceLevel(emulator::TraceLevel::Off);
+    emulator.RunFor(4);
+    emulator.SetTraceLevel(emulator::TraceLevel::Instructions);
+    emulator.RunFor(1);
+    emulator.StopTrace();
+
+    const auto records = ReadRecords(trace);
+    REQUIRE(records.size() == 1);
+    CHECK(records[0].cycle == 4);
+  }
+
+  std::filesystem::remove(trace);
+  std::filesystem::remove(rom);
+}
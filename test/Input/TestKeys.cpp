@@ -2,20 +2,76 @@
 
 #include "Input/KeyManager.h"
 
+#include <bit>
+#include <thread>
+
 TEST_CASE("KeyState") {
   input::KeyManager manager;
 
   SECTION("Press Key") {
-    for (int i = 0x1; i <= 0xF; ++i) {
+    for (int i = 0x0; i <= 0xF; ++i) {
       manager.PressKey(static_cast<input::KEY>(i));
       CHECK(manager.IsKeyPressed(static_cast<input::KEY>(i)));
     }
+    CHECK(manager.GetHeld() == 0xFFFF);
   }
 
   SECTION("Release Key") {
-    for (int i = 0x1; i <= 0xF; ++i) {
+    for (int i = 0x0; i <= 0xF; ++i) {
       manager.ReleaseKey(static_cast<input::KEY>(i));
       CHECK_FALSE(manager.IsKeyPressed(static_cast<input::KEY>(i)));
     }
+    CHECK(manager.GetHeld() == 0);
+  }
+
+  SECTION("Latch collects edges") {
+    manager.PressKey(input::KEY::KEY_0);
+    manager.PressKey(input::KEY::KEY_A);
+    auto latch = manager.Latch();
+    CHECK(latch.held == 0x0401);
+    CHECK(latch.pressed == 0x0401);
+    CHECK(latch.released == 0);
+
+    // Edges are only reported once.
+    latch = manager.Latch();
+    CHECK(latch.held == 0x0401);
+    CHECK(latch.pressed == 0);
+
+    manager.ReleaseKey(input::KEY::KEY_0);
+    latch = manager.Latch();
+    CHECK(latch.held == 0x0400);
+    CHECK(latch.released == 0x0001);
+  }
+
+  SECTION("Taps between latches are kept for one frame") {
+    manager.PressKey(input::KEY::KEY_F);
+    manager.ReleaseKey(input::KEY::KEY_F);
+    auto latch = manager.Latch();
+    CHECK(latch.held == 0);
+    CHECK(latch.GetDown() == 0x8000);
+    CHECK(manager.Latch().GetDown() == 0);
+  }
+
+  SECTION("Keys change while another thread latches") {
+    constexpr int presses = 10'000;
+    std::jthread frontend([&manager] {
+      for (int i = 0; i < presses; ++i) {
+        manager.PressKey(static_cast<input::KEY>(i % 16));
+        manager.ReleaseKey(static_cast<input::KEY>(i % 16));
+      }
+    });
+    int pressed = 0;
+    int released = 0;
+    auto count = [&](const input::KeyLatch &latch) {
+      pressed += std::popcount(latch.pressed);
+      released += std::popcount(latch.released);
+    };
+    while (pressed < 16) {
+      count(manager.Latch());
+    }
+    frontend.join();
+    count(manager.Latch());
+    CHECK(released >= 16);
+    CHECK(manager.GetHeld() == 0);
   }
 }
@@ -42,10 +42,23 @@ TEST_CASE("Dump Instruction") {
     Verify(&randInstr, "0x0\tc10f\tRND V1 0xf");
 
     CpuState state;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x1] = 0xFF;
     randInstr.Execute(state);
 
-    CHECK(state.registers.V1 <= 0xF);
+    CHECK(state.registers.V[0x1] <= 0xF);
+
+    // Draws from the machine's own generator.
+    CpuState other;
+    for (int i = 0; i < 8; ++i) {
+      randInstr.Execute(state);
+      randInstr.Execute(other);
+      CHECK(state.registers.V[0x1] != 0xFF);
+    }
+    CHECK(state.random != other.random);
+    other.random = state.random;
+    randInstr.Execute(state);
+    randInstr.Execute(other);
+    CHECK(state.registers.V[0x1] == other.registers.V[0x1]);
   }
 
   SECTION("Call") {
@@ -58,16 +71,16 @@ TEST_CASE("Dump Instruction") {
     Verify(&sexkkInstr, "0x0\t310f\tSE V1 0xf");
 
     CpuState state;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x1] = 0x0F;
     state.registers.PC = 0;
     sexkkInstr.Execute(state);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
     CHECK(state.registers.PC == 2);
 
-    state.registers.V1 = 0x01;
+    state.registers.V[0x1] = 0x01;
     state.registers.PC = 0;
     sexkkInstr.Execute(state);
-    CHECK(state.registers.V1 == 0x01);
+    CHECK(state.registers.V[0x1] == 0x01);
     CHECK(state.registers.PC == 0);
   }
 
@@ -76,20 +89,20 @@ TEST_CASE("Dump Instruction") {
     Verify(&sexyInstr, "0x0\t5010\tSE V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0x0F;
     state.registers.PC = 0;
     sexyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
     CHECK(state.registers.PC == 2);
 
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0x01;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0x01;
     state.registers.PC = 0;
     sexyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x01);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x01);
     CHECK(state.registers.PC == 0);
   }
 
@@ -98,16 +111,16 @@ TEST_CASE("Dump Instruction") {
     Verify(&snexkkInstr, "0x0\t410f\tSNE V1 0xf");
 
     CpuState state;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x1] = 0x0F;
     state.registers.PC = 0;
     snexkkInstr.Execute(state);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
     CHECK(state.registers.PC == 0);
 
-    state.registers.V1 = 0x01;
+    state.registers.V[0x1] = 0x01;
     state.registers.PC = 0;
     snexkkInstr.Execute(state);
-    CHECK(state.registers.V1 == 0x01);
+    CHECK(state.registers.V[0x1] == 0x01);
     CHECK(state.registers.PC == 2);
   }
 
@@ -116,21 +129,52 @@ TEST_CASE("Dump Instruction") {
     Verify(&snexyInstr, "0x0\t9010\tSNE V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0x0F;
     state.registers.PC = 0;
     snexyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
     CHECK(state.registers.PC == 0);
 
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0x01;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0x01;
     state.registers.PC = 0;
     snexyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x01);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x01);
+    CHECK(state.registers.PC == 2);
+  }
+
+  SECTION("Skp") {
+    auto skpInstr = SkpInstruction(0x0, 0xE19E);
+    Verify(&skpInstr, "0x0\te19e\tSKP V1");
+
+    CpuState state;
+    state.registers.V[0x1] = 0x0A;
+    state.registers.PC = 0;
+    skpInstr.Execute(state);
+    CHECK(state.registers.PC == 0);
+
+    state.keys = 0x0400;
+    skpInstr.Execute(state);
+    CHECK(state.registers.PC == 2);
+  }
+
+  SECTION("Sknp") {
+    auto sknpInstr = SknpInstruction(0x0, 0xE1A1);
+    Verify(&sknpInstr, "0x0\te1a1\tSKNP V1");
+
+    CpuState state;
+    state.registers.V[0x1] = 0x00;
+    state.registers.PC = 0;
+    sknpInstr.Execute(state);
     CHECK(state.registers.PC == 2);
+
+    state.keys = 0x0001;
+    state.registers.PC = 0;
+    sknpInstr.Execute(state);
+    CHECK(state.registers.PC == 0);
   }
 
   SECTION("Jp") {
@@ -143,9 +187,9 @@ TEST_CASE("Dump Instruction") {
     Verify(&ldxkkInstr, "0x0\t610f\tLD V1 0xf");
 
     CpuState state;
-    state.registers.V1 = 0x0;
+    state.registers.V[0x1] = 0x0;
     ldxkkInstr.Execute(state);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
   }
 
   SECTION("Ldxy") {
@@ -153,11 +197,11 @@ TEST_CASE("Dump Instruction") {
     Verify(&ldxyInstr, "0x0\t8010\tLD V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0F;
     ldxyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
   }
 
   SECTION("Ldnnn") {
@@ -175,11 +219,28 @@ TEST_CASE("Dump Instruction") {
     Verify(&ldxdt, "0x0\tf107\tLD V1 VDelay");
 
     CpuState state;
-    state.registers.V1 = 0;
+    state.registers.V[0x1] = 0;
     state.registers.VDelay = 0xFF;
     ldxdt.Execute(state);
-    CHECK(state.registers.V1 == state.registers.VDelay);
-    CHECK(state.registers.V1 == 0xFF);
+    CHECK(state.registers.V[0x1] == state.registers.VDelay);
+    CHECK(state.registers.V[0x1] == 0xFF);
+  }
+
+  SECTION("Ldx0") {
+    auto ldx0 = Ldx0Instruction(0x0, 0xF10A);
+    Verify(&ldx0, "0x0\tf10a\tLD V1 K");
+
+    CpuState state;
+    state.registers.PC = 0x2;
+    ldx0.Execute(state);
+    CHECK(state.registers.PC == 0);
+
+    state.registers.PC = 0x2;
+    state.pressedKeys = 0x8010;
+    ldx0.Execute(state);
+    CHECK(state.registers.PC == 0x2);
+    CHECK(state.registers.V[0x1] == 0x4);
+    CHECK(state.pressedKeys == 0);
   }
 
   SECTION("Lddtx") {
@@ -187,11 +248,11 @@ TEST_CASE("Dump Instruction") {
     Verify(&lddtx, "0x0\tf115\tLD VDelay V1");
 
     CpuState state;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x1] = 0xFF;
     state.registers.VDelay = 0;
     lddtx.Execute(state);
-    CHECK(state.registers.V1 == state.registers.VDelay);
-    CHECK(state.registers.V1 == 0xFF);
+    CHECK(state.registers.V[0x1] == state.registers.VDelay);
+    CHECK(state.registers.V[0x1] == 0xFF);
   }
 
   SECTION("Ldstx") {
@@ -199,11 +260,11 @@ TEST_CASE("Dump Instruction") {
     Verify(&lddtx, "0x0\tf107\tLD VSound V1");
 
     CpuState state;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x1] = 0xFF;
     state.registers.VSound = 0;
     lddtx.Execute(state);
-    CHECK(state.registers.V1 == state.registers.VSound);
-    CHECK(state.registers.V1 == 0xFF);
+    CHECK(state.registers.V[0x1] == state.registers.VSound);
+    CHECK(state.registers.V[0x1] == 0xFF);
   }
 
   SECTION("Ldfx") {
@@ -211,7 +272,7 @@ TEST_CASE("Dump Instruction") {
     Verify(&ldfxInstr, "0x0\tf129\tLD F V1");
 
     CpuState state;
-    state.registers.V1 = 0x1;
+    state.registers.V[0x1] = 0x1;
     ldfxInstr.Execute(state);
     CHECK(state.registers.I == Output::Sprites::sprite_1_address);
   }
@@ -261,11 +322,11 @@ TEST_CASE("Dump Instruction") {
 
     CpuState state;
     addxkkInstr.Execute(state);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
 
-    state.registers.V1 = 0x10;
+    state.registers.V[0x1] = 0x10;
     addxkkInstr.Execute(state);
-    CHECK(state.registers.V1 == 0x1F);
+    CHECK(state.registers.V[0x1] == 0x1F);
   }
 
   SECTION("Addxy") {
@@ -273,40 +334,40 @@ TEST_CASE("Dump Instruction") {
     Verify(&addxyInstr, "0x0\t8014\tADD V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0F;
     addxyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x0F);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0;
     addxyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.V1 == 0x0);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0x1] == 0x0);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0b010101;
-    state.registers.V1 = 0b101010;
+    state.registers.V[0x0] = 0b010101;
+    state.registers.V[0x1] = 0b101010;
     addxyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b111111);
-    CHECK(state.registers.V1 == 0b101010);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0b111111);
+    CHECK(state.registers.V[0x1] == 0b101010);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0xFF;
-    state.registers.V1 = 0x01;
+    state.registers.V[0x0] = 0xFF;
+    state.registers.V[0x1] = 0x01;
     addxyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.V1 == 0x01);
-    CHECK(state.registers.VF == 0x1);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0x1] == 0x01);
+    CHECK(state.registers.V[0xF] == 0x1);
 
-    state.registers.V0 = 0xFF;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x0] = 0xFF;
+    state.registers.V[0x1] = 0xFF;
     addxyInstr.Execute(state);
-    CHECK(state.registers.V0 == 0xFE);
-    CHECK(state.registers.V1 == 0xFF);
-    CHECK(state.registers.VF == 0x1);
+    CHECK(state.registers.V[0x0] == 0xFE);
+    CHECK(state.registers.V[0x1] == 0xFF);
+    CHECK(state.registers.V[0xF] == 0x1);
   }
 
   SECTION("Addix") {
@@ -315,17 +376,17 @@ TEST_CASE("Dump Instruction") {
 
     CpuState state;
     state.registers.I = 0;
-    state.registers.V3 = 0;
+    state.registers.V[0x3] = 0;
     addixInstr.Execute(state);
     CHECK(state.registers.I == 0x0);
 
     state.registers.I = 0;
-    state.registers.V3 = 0x10;
+    state.registers.V[0x3] = 0x10;
     addixInstr.Execute(state);
     CHECK(state.registers.I == 0x10);
 
     state.registers.I = 0x10;
-    state.registers.V3 = 0x10;
+    state.registers.V[0x3] = 0x10;
     addixInstr.Execute(state);
     CHECK(state.registers.I == 0x20);
   }
@@ -335,26 +396,26 @@ TEST_CASE("Dump Instruction") {
     Verify(&subInstr, "0x0\t8015\tSUB V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0xFF;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0xFF;
+    state.registers.V[0x1] = 0x0F;
     subInstr.Execute(state);
-    CHECK(state.registers.V0 == 0xF0);
-    CHECK(state.registers.V1 == 0x0F);
-    CHECK(state.registers.VF == 0x1);
+    CHECK(state.registers.V[0x0] == 0xF0);
+    CHECK(state.registers.V[0x1] == 0x0F);
+    CHECK(state.registers.V[0xF] == 0x1);
 
-    state.registers.V0 = 0xFF;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x0] = 0xFF;
+    state.registers.V[0x1] = 0xFF;
     subInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x00);
-    CHECK(state.registers.V1 == 0xFF);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x00);
+    CHECK(state.registers.V[0x1] == 0xFF);
+    CHECK(state.registers.V[0xF] == 0x1);
 
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0xFF;
     subInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x10);
-    CHECK(state.registers.V1 == 0xFF);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x10);
+    CHECK(state.registers.V[0x1] == 0xFF);
+    CHECK(state.registers.V[0xF] == 0x0);
   }
 
   SECTION("Subn") {
@@ -362,26 +423,26 @@ TEST_CASE("Dump Instruction") {
     Verify(&subnInstr, "0x0\t8017\tSUBN V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0xFF;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0xFF;
+    state.registers.V[0x1] = 0x0F;
     subnInstr.Execute(state);
-    CHECK(state.registers.V0 == 0xF0);
-    CHECK(state.registers.V1 == 0x0F);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x10);
+    CHECK(state.registers.V[0x1] == 0x0F);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0xFF;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x0] = 0xFF;
+    state.registers.V[0x1] = 0xFF;
     subnInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x00);
-    CHECK(state.registers.V1 == 0xFF);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x00);
+    CHECK(state.registers.V[0x1] == 0xFF);
+    CHECK(state.registers.V[0xF] == 0x1);
 
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0xFF;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0xFF;
     subnInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x10);
-    CHECK(state.registers.V1 == 0xFF);
-    CHECK(state.registers.VF == 0x1);
+    CHECK(state.registers.V[0x0] == 0xF0);
+    CHECK(state.registers.V[0x1] == 0xFF);
+    CHECK(state.registers.V[0xF] == 0x1);
   }
 
   SECTION("Or") {
@@ -389,23 +450,23 @@ TEST_CASE("Dump Instruction") {
     Verify(&orInstr, "0x0\t8011\tOR V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0F;
     orInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
 
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0;
     orInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.V1 == 0x0);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0x1] == 0x0);
 
-    state.registers.V0 = 0b010101;
-    state.registers.V1 = 0b101010;
+    state.registers.V[0x0] = 0b010101;
+    state.registers.V[0x1] = 0b101010;
     orInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b111111);
-    CHECK(state.registers.V1 == 0b101010);
+    CHECK(state.registers.V[0x0] == 0b111111);
+    CHECK(state.registers.V[0x1] == 0b101010);
   }
 
   SECTION("And") {
@@ -413,29 +474,29 @@ TEST_CASE("Dump Instruction") {
     Verify(&orInstr, "0x0\t8012\tAND V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0x0F;
     orInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
 
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0F;
     orInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0x1] == 0x0F);
 
-    state.registers.V0 = 0b010101;
-    state.registers.V1 = 0b101010;
+    state.registers.V[0x0] = 0b010101;
+    state.registers.V[0x1] = 0b101010;
     orInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b0);
-    CHECK(state.registers.V1 == 0b101010);
+    CHECK(state.registers.V[0x0] == 0b0);
+    CHECK(state.registers.V[0x1] == 0b101010);
 
-    state.registers.V0 = 0b001111;
-    state.registers.V1 = 0b101010;
+    state.registers.V[0x0] = 0b001111;
+    state.registers.V[0x1] = 0b101010;
     orInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b1010);
-    CHECK(state.registers.V1 == 0b101010);
+    CHECK(state.registers.V[0x0] == 0b1010);
+    CHECK(state.registers.V[0x1] == 0b101010);
   }
 
   SECTION("Xor") {
@@ -443,35 +504,35 @@ TEST_CASE("Dump Instruction") {
     Verify(&xorInstr, "0x0\t8013\tXOR V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0F;
     xorInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0F);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0F);
+    CHECK(state.registers.V[0x1] == 0x0F);
 
-    state.registers.V0 = 0x0;
-    state.registers.V1 = 0x0;
+    state.registers.V[0x0] = 0x0;
+    state.registers.V[0x1] = 0x0;
     xorInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.V1 == 0x0);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0x1] == 0x0);
 
-    state.registers.V0 = 0b010101;
-    state.registers.V1 = 0b101010;
+    state.registers.V[0x0] = 0b010101;
+    state.registers.V[0x1] = 0b101010;
     xorInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b111111);
-    CHECK(state.registers.V1 == 0b101010);
+    CHECK(state.registers.V[0x0] == 0b111111);
+    CHECK(state.registers.V[0x1] == 0b101010);
 
-    state.registers.V0 = 0x0F;
-    state.registers.V1 = 0x0F;
+    state.registers.V[0x0] = 0x0F;
+    state.registers.V[0x1] = 0x0F;
     xorInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.V1 == 0x0F);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0x1] == 0x0F);
 
-    state.registers.V0 = 0b00001111;
-    state.registers.V1 = 0b10101010;
+    state.registers.V[0x0] = 0b00001111;
+    state.registers.V[0x1] = 0b10101010;
     xorInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b10100101);
-    CHECK(state.registers.V1 == 0b10101010);
+    CHECK(state.registers.V[0x0] == 0b10100101);
+    CHECK(state.registers.V[0x1] == 0b10101010);
   }
 
   SECTION("Shr") {
@@ -479,30 +540,30 @@ TEST_CASE("Dump Instruction") {
     Verify(&shrInstr, "0x0\t8016\tSHR V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0;
+    state.registers.V[0x0] = 0x0;
     shrInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0x1;
+    state.registers.V[0x0] = 0x1;
     shrInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.VF == 0x1);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0xF] == 0x1);
 
-    state.registers.V0 = 0x2;
+    state.registers.V[0x0] = 0x2;
     shrInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x1);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x1);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0xFF;
+    state.registers.V[0x0] = 0xFF;
     shrInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x7F);
-    CHECK(state.registers.VF == 0x1);
+    CHECK(state.registers.V[0x0] == 0x7F);
+    CHECK(state.registers.V[0xF] == 0x1);
 
-    state.registers.V0 = 0b10101010;
+    state.registers.V[0x0] = 0b10101010;
     shrInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b01010101);
-    CHECK(state.registers.VF == 0b0);
+    CHECK(state.registers.V[0x0] == 0b01010101);
+    CHECK(state.registers.V[0xF] == 0b0);
   }
 
   SECTION("Shl") {
@@ -510,30 +571,30 @@ TEST_CASE("Dump Instruction") {
     Verify(&shlInstr, "0x0\t801e\tSHL V0 V1");
 
     CpuState state;
-    state.registers.V0 = 0x0;
+    state.registers.V[0x0] = 0x0;
     shlInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x0);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x0);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0x1;
+    state.registers.V[0x0] = 0x1;
     shlInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x2);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x2);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0x2;
+    state.registers.V[0x0] = 0x2;
     shlInstr.Execute(state);
-    CHECK(state.registers.V0 == 0x4);
-    CHECK(state.registers.VF == 0x0);
+    CHECK(state.registers.V[0x0] == 0x4);
+    CHECK(state.registers.V[0xF] == 0x0);
 
-    state.registers.V0 = 0xF0;
+    state.registers.V[0x0] = 0xF0;
     shlInstr.Execute(state);
-    CHECK(state.registers.V0 == 0xE0);
-    CHECK(state.registers.VF == 0x1);
+    CHECK(state.registers.V[0x0] == 0xE0);
+    CHECK(state.registers.V[0xF] == 0x1);
 
-    state.registers.V0 = 0b10101010;
+    state.registers.V[0x0] = 0b10101010;
     shlInstr.Execute(state);
-    CHECK(state.registers.V0 == 0b01010100);
-    CHECK(state.registers.VF == 0b1);
+    CHECK(state.registers.V[0x0] == 0b01010100);
+    CHECK(state.registers.V[0xF] == 0b1);
   }
 
   SECTION("Drw") {
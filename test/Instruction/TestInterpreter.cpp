@@ -0,0 +1,160 @@
+#include "catch.hpp"
+
+#include "CPU/CpuUtil.h"
+#include "Instructions/Decoder.h"
+#include "Instructions/InstructionUtil.h"
+#include "Instructions/Interpreter.h"
+
+#include <cstdint>
+#include <memory>
+
+using namespace Instructions;
+
+namespace {
+void Prepare(CpuState &state) {
+  for (int i = 0; i <= static_cast<int>(Register::VF); ++i) {
+    cpu::GetRegister(static_cast<Register>(i), state) =
+        static_cast<std::uint8_t>(0x11 * i + 0x07);
+  }
+  state.registers.I = cpu::memory_start + 0x100;
+  state.registers.PC = cpu::memory_start;
+  state.registers.SP = 1;
+  state.registers.VDelay = 0x30;
+  // Key 7 is held, V0 holds 0x07, keys 6 and 9 were pressed.
+  state.keys = 0x0080;
+  state.pressedKeys = 0x0240;
+  state.memory.PushStack(cpu::memory_start + 0x40, state.registers.SP);
+  for (std::uint16_t i = 0; i < 0x10; ++i) {
+    state.memory.Write(state.registers.I + i, static_cast<std::uint8_t>(i));
+  }
+}
+
+void CheckEqual(CpuState &lhs, CpuState &rhs) {
+  for (int i = 0; i <= static_cast<int>(Register::VF); ++i) {
+    INFO("Register V" << i);
+    CHECK(cpu::GetRegister(static_cast<Register>(i), lhs) ==
+          cpu::GetRegister(static_cast<Register>(i), rhs));
+  }
+  CHECK(lhs.registers.I == rhs.registers.I);
+  CHECK(lhs.registers.PC == rhs.registers.PC);
+  CHECK(lhs.registers.SP == rhs.registers.SP);
+  CHECK(lhs.registers.VDelay == rhs.registers.VDelay);
+  CHECK(lhs.registers.VSound == rhs.registers.VSound);
+  CHECK(lhs.pressedKeys == rhs.pressedKeys);
+  for (std::uint16_t address = cpu::memory_start; address < cpu::memory_size;
+       ++address) {
+    REQUIRE(lhs.memory.Read(address) == rhs.memory.Read(address));
+  }
+  CHECK(lhs.display.GetScreen() == rhs.display.GetScreen());
+}
+} // namespace
+
+TEST_CASE("Interpreter matches instruction classes") {
+  // One word for every implemented opcode except RND.
+  const std::uint16_t words[] = {
+      0x00E0, 0x00EE, 0x1234, 0xB210, 0x2468, 0x3118, 0x3119, 0x5120,
+      0x5110, 0x4118, 0x4119, 0x9120, 0x9110, 0x61AB, 0x8120, 0xA123,
+      0xF207, 0xF315, 0xF418, 0xF529, 0xF633, 0xF755, 0xF865, 0x7901,
+      0x8124, 0x8FF4, 0xF41E, 0x8125, 0x8217, 0x8341, 0x8452, 0x8563,
+      0x8676, 0x878E, 0xD125, 0xE09E, 0xE19E, 0xE0A1, 0xE1A1, 0xF30A};
+
+  for (auto word : words) {
+    INFO("Executing: 0x" << std::hex << word);
+    CpuState expected;
+    CpuState actual;
+    Prepare(expected);
+    Prepare(actual);
+
+    std::unique_ptr<Instruction> instruction(CreateInstruction(
+        expected.registers.PC, GetDefinition(word).GetOpcode(), word));
+    instruction->Execute(expected);
+    REQUIRE(Interpreter::Execute(Decode(word), actual));
+
+    CheckEqual(expected, actual);
+  }
+}
+
+TEST_CASE("Interpreter") {
+  CpuState state;
+  Prepare(state);
+
+  SECTION("Unsupported instructions") {
+    for (std::uint16_t word : {0x0123, 0x00FB, 0x5121}) {
+      INFO("Executing: 0x" << std::hex << word);
+      CHECK_FALSE(Interpreter::Execute(Decode(word), state));
+      CHECK(state.registers.PC == cpu::memory_start);
+    }
+  }
+
+  SECTION("Call and return") {
+    const auto callAddress = state.registers.PC;
+    REQUIRE(Interpreter::Execute(Decode(0x2400), state));
+    state.registers.PC += instruction_size;
+    CHECK(state.registers.PC == 0x400);
+
+    REQUIRE(Interpreter::Execute(Decode(0x00EE), state));
+    state.registers.PC += instruction_size;
+    CHECK(state.registers.PC == callAddress + instruction_size);
+  }
+
+  SECTION("Stack overflow and underflow halt") {
+    state.registers.SP = cpu::stack_size - 1;
+    CHECK_FALSE(Interpreter::Execute(Decode(0x2400), state));
+    CHECK(state.registers.SP == cpu::stack_size - 1);
+    CHECK(state.registers.PC == cpu::memory_start);
+
+    state.registers.SP = 0;
+    CHECK_FALSE(Interpreter::Execute(Decode(0x00EE), state));
+    CHECK(state.registers.SP == 0);
+    CHECK(state.registers.PC == cpu::memory_start);
+  }
+
+  SECTION("Jump with offset") {
+    state.registers.V[0x0] = 0x10;
+    REQUIRE(Interpreter::Execute(Decode(0xB300), state));
+    state.registers.PC += instruction_size;
+    CHECK(state.registers.PC == 0x310);
+  }
+
+  SECTION("Key skips test the low nibble of the register") {
+    state.registers.V[0x2] = 0x17;
+    REQUIRE(Interpreter::Execute(Decode(0xE29E), state));
+    CHECK(state.registers.PC == cpu::memory_start + instruction_size);
+    REQUIRE(Interpreter::Execute(Decode(0xE2A1), state));
+    CHECK(state.registers.PC == cpu::memory_start + instruction_size);
+
+    state.keys = 0;
+    REQUIRE(Interpreter::Execute(Decode(0xE2A1), state));
+    CHECK(state.registers.PC == cpu::memory_start + 2 * instruction_size);
+  }
+
+  SECTION("Key wait takes the lowest key pressed") {
+    REQUIRE(Interpreter::Execute(Decode(0xF30A), state));
+    state.registers.PC += instruction_size;
+    CHECK(state.registers.V[0x3] == 6);
+    CHECK(state.pressedKeys == 0);
+    CHECK(state.registers.PC == cpu::memory_start + instruction_size);
+
+    // The presses were taken, the next wait stays on its instruction.
+    REQUIRE(Interpreter::Execute(Decode(0xF40A), state));
+    state.registers.PC += instruction_size;
+    CHECK(state.registers.V[0x4] == 0x4B);
+    CHECK(state.registers.PC == cpu::memory_start + instruction_size);
+  }
+
+  SECTION("Binary coded decimal") {
+    state.registers.V[0x3] = 234;
+    REQUIRE(Interpreter::Execute(Decode(0xF333), state));
+    CHECK(state.memory.Read(state.registers.I) == 2);
+    CHECK(state.memory.Read(state.registers.I + 1) == 3);
+    CHECK(state.memory.Read(state.registers.I + 2) == 4);
+  }
+
+  SECTION("Draw sets collision flag") {
+    state.registers.I += 1;
+    REQUIRE(Interpreter::Execute(Decode(0xD121), state));
+    CHECK(state.registers.V[0xF] == 0);
+    REQUIRE(Interpreter::Execute(Decode(0xD121), state));
+    CHECK(state.registers.V[0xF] == 1);
+  }
+}
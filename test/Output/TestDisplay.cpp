@@ -8,17 +8,133 @@ using namespace Output;
 TEST_CASE("Drawing") {
   Display display;
 
-  std::vector<std::uint8_t> sprite = {0xF, 0XF, 0XF};
-  display.Draw(0, 0, sprite);
+  std::vector<std::uint8_t> sprite = {0xF0, 0X81, 0XFF};
+  CHECK_FALSE(display.Draw(0, 0, sprite));
   for (auto i = 0U; i < sprite.size(); ++i) {
-    CHECK(display.GetScreen()[i] == sprite[i]);
+    for (auto bit = 0U; bit < 8; ++bit) {
+      INFO("Pixel " << bit << ", " << i);
+      CHECK(display.GetPixel(bit, i) == bool(sprite[i] & (0x80 >> bit)));
+    }
+  }
+  CHECK(display.GetRow(0)[0] == 0xF0ULL << 56);
+  CHECK_FALSE(display.GetPixel(8, 0));
+  CHECK_FALSE(display.GetPixel(0, 3));
+}
+
+TEST_CASE("Collision") {
+  Display display;
+  CHECK_FALSE(display.Draw(10, 5, std::vector<std::uint8_t>{0x0F}));
+  CHECK_FALSE(display.Draw(10, 5, std::vector<std::uint8_t>{0xF0}));
+  CHECK(display.GetRow(5)[0] == 0xFFULL << (56 - 10));
+
+  // Erasing a pixel reports a collision and clears it.
+  CHECK(display.Draw(17, 5, std::vector<std::uint8_t>{0x80}));
+  CHECK_FALSE(display.GetPixel(17, 5));
+  CHECK(display.GetPixel(16, 5));
+}
+
+TEST_CASE("Wrapping and clipping") {
+  Display display;
+  REQUIRE(display.GetWidth() == lowres_display_width);
+  REQUIRE(display.GetHeight() == lowres_display_height);
+
+  SECTION("Start position wraps") {
+    display.Draw(lowres_display_width + 2, lowres_display_height + 1,
+                 std::vector<std::uint8_t>{0x80});
+    CHECK(display.GetPixel(2, 1));
+  }
+
+  SECTION("Right edge clips") {
+    display.Draw(60, 0, std::vector<std::uint8_t>{0xFF});
+    CHECK(display.GetRow(0)[0] == 0xFULL);
+    CHECK(display.GetRow(0)[1] == 0x0ULL);
+    CHECK_FALSE(display.GetPixel(0, 0));
+  }
+
+  SECTION("Bottom edge clips") {
+    display.Draw(0, 30, std::vector<std::uint8_t>{0x80, 0x80, 0x80, 0x80});
+    CHECK(display.GetPixel(0, 30));
+    CHECK(display.GetPixel(0, 31));
+    CHECK_FALSE(display.GetPixel(0, 0));
+    CHECK(display.GetRow(32)[0] == 0);
+  }
+
+  SECTION("High resolution spans words") {
+    display.SetHighResolution(true);
+    CHECK(display.GetWidth() == display_width);
+    display.Draw(60, 40, std::vector<std::uint8_t>{0xFF});
+    CHECK(display.GetRow(40)[0] == 0xFULL);
+    CHECK(display.GetRow(40)[1] == 0xFULL << 60);
+    CHECK_FALSE(display.Draw(124, 40, std::vector<std::uint8_t>{0xFF}));
+    CHECK(display.GetRow(40)[1] == ((0xFULL << 60) | 0xFULL));
+    CHECK(display.Draw(64, 40, std::vector<std::uint8_t>{0x80}));
+    CHECK_FALSE(display.GetPixel(64, 40));
   }
 }
 
 TEST_CASE("Clearing") {
   Display display;
-  display.Draw(0, 0, {0xF, 0XF, 0XF});
-  CHECK(display.GetScreen()[0] == 0xF);
+  display.Draw(0, 0, std::vector<std::uint8_t>{0xF, 0XF, 0XF});
+  CHECK(display.GetPixel(7, 0));
   display.Clear();
-  CHECK(display.GetScreen()[0] == 0x0);
+  CHECK_FALSE(display.GetPixel(7, 0));
+  CHECK(display.GetRow(0)[0] == 0x0);
+}
+
+TEST_CASE("Damage") {
+  Display display;
+  CHECK_FALSE(display.HasDamage());
+
+  SECTION("Drawn rows until acknowledged") {
+    display.Draw(3, 4, std::vector<std::uint8_t>{0x80, 0x00, 0x81});
+    CHECK(display.GetDamage() == 0b101ULL << 4);
+    CHECK(display.AcknowledgeDamage() == 0b101ULL << 4);
+    CHECK_FALSE(display.HasDamage());
+    CHECK(display.GetPixel(3, 4));
+  }
+
+  SECTION("Changes undone within a frame are no damage") {
+    const std::vector<std::uint8_t> sprite = {0xF0, 0x90, 0xF0};
+    display.Draw(10, 10, sprite);
+    display.AcknowledgeDamage();
+
+    display.Clear();
+    CHECK(display.GetDamage() == 0b111ULL << 10);
+    display.Draw(10, 10, sprite);
+    CHECK_FALSE(display.HasDamage());
+
+    // Drawing the same sprite twice erases it again.
+    display.Draw(0, 30, sprite);
+    display.Draw(0, 30, sprite);
+    CHECK_FALSE(display.HasDamage());
+  }
+
+  SECTION("Changing resolution damages every row") {
+    display.SetHighResolution(true);
+    CHECK(display.AcknowledgeDamage() == ~RowMask{0});
+    CHECK_FALSE(display.HasDamage());
+    display.Draw(0, 63, std::vector<std::uint8_t>{0x80});
+    CHECK(display.GetDamage() == 1ULL << 63);
+  }
+
+  SECTION("Restoring damages the rows differing from what was presented") {
+    display.Draw(0, 0, std::vector<std::uint8_t>{0x80});
+    display.Draw(0, 2, std::vector<std::uint8_t>{0x80});
+    display.AcknowledgeDamage();
+    Display saved = display;
+    display.Draw(0, 2, std::vector<std::uint8_t>{0x80});
+    display.Draw(0, 3, std::vector<std::uint8_t>{0x80});
+    display.AcknowledgeDamage();
+
+    display.Restore(saved);
+    CHECK(display.GetPixel(0, 2));
+    CHECK(display.AcknowledgeDamage() == (1ULL << 2 | 1ULL << 3));
+  }
+
+  SECTION("Copies keep their damage") {
+    display.Draw(0, 0, std::vector<std::uint8_t>{0x80});
+    Display copy = display;
+    display.AcknowledgeDamage();
+    CHECK(copy.GetDamage() == 1);
+  }
 }
@@ -0,0 +1,37 @@
+#include "catch.hpp"
+
+#include "Util/Event.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST_CASE("Event") {
+  using namespace std::chrono_literals;
+  util::Event event;
+
+  SECTION("Times out without a notification") {
+    CHECK_FALSE(event.Wait(1ms));
+  }
+
+  SECTION("Keeps notifications until the next wait") {
+    event.Notify();
+    event.Notify();
+    CHECK(event.Wait(0ns));
+    // Both were taken at once.
+    CHECK_FALSE(event.Wait(0ns));
+  }
+
+  SECTION("Wakes a thread sleeping in another") {
+    std::atomic<bool> woken = false;
+    std::jthread sleeper([&] {
+      event.Wait();
+      woken = true;
+    });
+    std::this_thread::sleep_for(10ms);
+    CHECK_FALSE(woken);
+    event.Notify();
+    sleeper.join();
+    CHECK(woken);
+  }
+}
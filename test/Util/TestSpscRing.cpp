@@ -0,0 +1,52 @@
+#include "catch.hpp"
+
+#include "Util/SpscRing.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Single producer single consumer ring") {
+  SECTION("Rejects pushes when full") {
+    util::SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE(ring.TryPush(i));
+    }
+    CHECK_FALSE(ring.TryPush(4));
+    CHECK(ring.TryPop() == 0);
+    CHECK(ring.TryPush(4));
+
+    std::vector<int> drained;
+    CHECK(ring.Drain([&](int value) { drained.push_back(value); }) == 4);
+    CHECK(drained == std::vector<int>{1, 2, 3, 4});
+    CHECK(ring.Empty());
+    CHECK_FALSE(ring.TryPop());
+  }
+
+  SECTION("Keeps order across threads") {
+    constexpr std::uint64_t count = 200'000;
+    util::SpscRing<std::uint64_t, 64> ring;
+    std::jthread producer([&] {
+      for (std::uint64_t value = 0; value < count;) {
+        if (ring.TryPush(value)) {
+          ++value;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+    std::uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < count) {
+      const auto drained = ring.Drain([&](std::uint64_t value) {
+        ordered = ordered && value == expected;
+        ++expected;
+      });
+      if (drained == 0) {
+        std::this_thread::yield();
+      }
+    }
+    CHECK(ordered);
+  }
+}
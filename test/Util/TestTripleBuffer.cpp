@@ -0,0 +1,69 @@
+#include "catch.hpp"
+
+#include "Util/TripleBuffer.h"
+
+#include <cstdint>
+#include <thread>
+
+TEST_CASE("Triple buffer") {
+  SECTION("Hands over the newest value once") {
+    util::TripleBuffer<int> buffer;
+    CHECK_FALSE(buffer.Update());
+
+    buffer.GetBack() = 1;
+    buffer.Publish();
+    REQUIRE(buffer.Update());
+    CHECK(buffer.GetFront() == 1);
+    CHECK_FALSE(buffer.Update());
+    CHECK(buffer.GetFront() == 1);
+
+    // Values the consumer never took are dropped.
+    for (int value : {2, 3, 4}) {
+      buffer.GetBack() = value;
+      buffer.Publish();
+    }
+    REQUIRE(buffer.Update());
+    CHECK(buffer.GetFront() == 4);
+    CHECK_FALSE(buffer.Update());
+  }
+
+  SECTION("Tells the producer whether the value was taken") {
+    util::TripleBuffer<int> buffer;
+    CHECK(buffer.IsTaken());
+    buffer.GetBack() = 1;
+    buffer.Publish();
+    CHECK_FALSE(buffer.IsTaken());
+    REQUIRE(buffer.Update());
+    CHECK(buffer.IsTaken());
+  }
+
+  SECTION("Never tears values across threads") {
+    struct Pair {
+      std::uint64_t first;
+      std::uint64_t second;
+    };
+    constexpr std::uint64_t count = 200'000;
+    util::TripleBuffer<Pair> buffer;
+    std::jthread producer([&] {
+      for (std::uint64_t value = 1; value <= count; ++value) {
+        auto &pair = buffer.GetBack();
+        pair.first = value;
+        pair.second = value;
+        buffer.Publish();
+      }
+    });
+
+    std::uint64_t last = 0;
+    bool consistent = true;
+    while (last < count) {
+      if (!buffer.Update()) {
+        std::this_thread::yield();
+        continue;
+      }
+      const auto &pair = buffer.GetFront();
+      consistent = consistent && pair.first == pair.second && pair.first > last;
+      last = pair.first;
+    }
+    CHECK(consistent);
+  }
+}
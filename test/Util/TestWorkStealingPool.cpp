@@ -0,0 +1,51 @@
+#include "catch.hpp"
+
+#include "Util/WorkStealingPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Work stealing pool") {
+  SECTION("Runs every job once") {
+    for (std::size_t threads : {1, 2, 7, 64}) {
+      util::WorkStealingPool pool(threads);
+      std::vector<std::atomic<int>> runs(1000);
+      pool.Run(runs.size(), [&](std::size_t index) { runs[index] += 1; });
+      for (auto &count : runs) {
+        REQUIRE(count == 1);
+      }
+    }
+  }
+
+  SECTION("Idle threads steal") {
+    util::WorkStealingPool pool(4);
+    constexpr std::size_t jobs = 8;
+    std::atomic<std::size_t> finished = 0;
+    bool othersFinished = false;
+    pool.Run(jobs, [&](std::size_t index) {
+      // Whichever thread picks up the blocking job keeps the rest of its
+      // queue waiting, the other threads have to steal it.
+      if (index == 4) {
+        const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (finished != jobs - 1 &&
+               std::chrono::steady_clock::now() < deadline) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        othersFinished = finished == jobs - 1;
+      } else {
+        finished += 1;
+      }
+    });
+    CHECK(othersFinished);
+  }
+
+  SECTION("No jobs") {
+    util::WorkStealingPool pool(4);
+    int runs = 0;
+    pool.Run(0, [&](std::size_t) { ++runs; });
+    CHECK(runs == 0);
+  }
+}
@@ -1,44 +1,328 @@
+#include <CPU/Memory.h>
+#include <Instructions/ControlFlow.h>
 #include <Instructions/Disassembler.h>
+#include <Instructions/Instruction.h>
+#include <Util/WorkStealingPool.h>
 
-#include <Util/Binary.h>
-
-#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
 #include <iostream>
-#include <istream>
-#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
-int main(int argc, char *argv[]) {
-  std::cout << "Disassembler Begin: " << argc << " " << argv[0] << std::endl;
+namespace {
 
-  if (argc < 2) {
-    std::cerr << "Missing input file" << std::endl;
-    return 1;
+// Words formatted by one job, large enough to outweigh scheduling it.
+constexpr std::size_t chunk_words = 1 << 14;
+// Chunks formatted before their text is written out, per thread.
+constexpr std::size_t chunks_per_thread = 4;
+constexpr std::size_t output_buffer_size = 1 << 20;
+
+void PrintUsage() {
+  std::cerr << "Usage: Disassembler [--threads N] [--output FILE] [--code] "
+               "<rom>...\n"
+               "  --code  Only list instructions reachable from the entry "
+               "point\n";
+}
+
+/// A whole file mapped read only.
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    if (mData != nullptr) {
+      munmap(mData, mSize);
+    }
   }
 
-  std::ifstream is(argv[1], std::ios::binary);
-  if (!is) {
-    std::cerr << "Failed to open file: " << argv[1] << std::endl;
-    return 1;
+  bool Open(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      std::cerr << "Failed to open file: " << path << ", "
+                << std::strerror(errno) << std::endl;
+      return false;
+    }
+    struct stat status;
+    bool opened = fstat(fd, &status) == 0 && S_ISREG(status.st_mode);
+    mSize = opened ? static_cast<std::size_t>(status.st_size) : 0;
+    if (opened && mSize > 0) {
+      auto *data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+      opened = data != MAP_FAILED;
+      mData = opened ? data : nullptr;
+      if (opened) {
+        madvise(mData, mSize, MADV_SEQUENTIAL);
+      }
+    }
+    close(fd);
+    if (!opened) {
+      std::cerr << "Failed to map file: " << path << std::endl;
+    }
+    return opened;
+  }
+
+  std::span<const std::uint8_t> GetBytes() const {
+    return {static_cast<const std::uint8_t *>(mData), mSize};
+  }
+
+private:
+  void *mData = nullptr;
+  std::size_t mSize = 0;
+};
+
+/// Collects output and writes it to a file descriptor in large blocks.
+class Writer {
+public:
+  explicit Writer(int fd) : mFd(fd) { mBuffer.reserve(output_buffer_size); }
+  ~Writer() { Flush(); }
+
+  void Write(std::string_view text) {
+    if (mBuffer.size() + text.size() > mBuffer.capacity()) {
+      Flush();
+    }
+    if (text.size() >= mBuffer.capacity()) {
+      WriteFully(text);
+    } else {
+      mBuffer.insert(mBuffer.end(), text.begin(), text.end());
+    }
+  }
+  bool Flush() {
+    WriteFully({mBuffer.data(), mBuffer.size()});
+    mBuffer.clear();
+    return mOk;
+  }
+
+private:
+  void WriteFully(std::string_view text) {
+    while (mOk && !text.empty()) {
+      const auto count = write(mFd, text.data(), text.size());
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count <= 0) {
+        std::cerr << "Failed to write output, " << std::strerror(errno)
+                  << std::endl;
+        mOk = false;
+        return;
+      }
+      text.remove_prefix(static_cast<std::size_t>(count));
+    }
+  }
+
+  int mFd;
+  std::vector<char> mBuffer;
+  bool mOk = true;
+};
+
+struct Chunk {
+  std::span<const std::uint8_t> bytes;
+  // Address of the first word, each file starts at instruction_start.
+  std::uint16_t address;
+  // Written before the first chunk of each file.
+  std::string header;
+};
+
+/// Formats every whole word of chunk into text, one line each.
+void FormatChunk(const Chunk &chunk, std::string &text) {
+  const auto words = chunk.bytes.size() / 2;
+  text.resize(chunk.header.size() +
+              words * (Disassembler::max_line_size + 1));
+  auto *out = std::copy(chunk.header.begin(), chunk.header.end(), text.data());
+  auto address = chunk.address;
+  for (std::size_t i = 0; i < words; ++i) {
+    const auto word = static_cast<std::uint16_t>(chunk.bytes[2 * i] << 8 |
+                                                 chunk.bytes[2 * i + 1]);
+    out = Disassembler::Format(word, address, out);
+    *out++ = '\n';
+    address += Instructions::instruction_size;
+  }
+  text.resize(static_cast<std::size_t>(out - text.data()));
+}
+
+/// Formats the chunks in batches on the pool and writes them out in order.
+void Disassemble(const std::vector<Chunk> &chunks,
+                 util::WorkStealingPool &pool, Writer &writer) {
+  const auto batchSize = pool.GetThreadCount() * chunks_per_thread;
+  std::vector<std::string> texts(batchSize);
+  for (std::size_t first = 0; first < chunks.size(); first += batchSize) {
+    const auto count = std::min(batchSize, chunks.size() - first);
+    pool.Run(count, [&](std::size_t index) {
+      FormatChunk(chunks[first + index], texts[index]);
+    });
+    for (std::size_t index = 0; index < count; ++index) {
+      writer.Write(texts[index]);
+    }
+  }
+}
+
+/// Lists the instructions reachable in bytes in address order, with a line
+/// for every run of bytes in between that is never executed. An instruction
+/// a jump enters in the middle of another one gets a line of its own.
+void FormatCode(const std::string &input, std::span<const std::uint8_t> bytes,
+                std::string &text) {
+  const auto graph = Disassembler::ControlFlowGraph::Analyse(bytes);
+  const auto end = std::min<std::size_t>(cpu::instruction_start + bytes.size(),
+                                         cpu::memory_size);
+  text = "Disassembling: " + input + " " +
+         std::to_string(graph.GetInstructionCount()) + " instructions\n";
+  text.reserve(text.size() + graph.GetInstructionCount() *
+                                 (Disassembler::max_line_size + 1));
+  char line[Disassembler::max_line_size + 1];
+  std::size_t address = cpu::instruction_start;
+  while (address < end) {
+    const auto current = static_cast<std::uint16_t>(address);
+    if (graph.IsInstruction(current)) {
+      const auto offset = address - cpu::instruction_start;
+      const auto word =
+          static_cast<std::uint16_t>(bytes[offset] << 8 | bytes[offset + 1]);
+      auto *out = Disassembler::Format(word, current, line);
+      *out++ = '\n';
+      text.append(line, static_cast<std::size_t>(out - line));
+      // The next byte may start an instruction as well.
+      ++address;
+      continue;
+    }
+    if (graph.IsCode(current)) {
+      ++address;
+      continue;
+    }
+    const auto first = address;
+    while (address < end &&
+           !graph.IsCode(static_cast<std::uint16_t>(address))) {
+      ++address;
+    }
+    std::snprintf(line, sizeof(line), "0x%zx\tdata %zu bytes\n", first,
+                  address - first);
+    text += line;
+  }
+  for (auto jump : graph.GetIndirectJumps()) {
+    std::snprintf(line, sizeof(line), "0x%x\tunresolved jump\n", jump);
+    text += line;
   }
-  std::vector<std::uint16_t> inputBuff;
-  while (is) {
-    std::uint16_t data;
-    is.read((char *)&data, sizeof(std::uint16_t));
-    util::SwapBinary(data);
-    inputBuff.push_back(data);
+}
+
+/// Analyses every file on the pool and writes the listings out in order.
+void DisassembleCode(const std::vector<std::string> &inputs,
+                     const std::vector<std::span<const std::uint8_t>> &programs,
+                     util::WorkStealingPool &pool, Writer &writer) {
+  std::vector<std::string> texts(programs.size());
+  pool.Run(programs.size(), [&](std::size_t index) {
+    FormatCode(inputs[index], programs[index], texts[index]);
+  });
+  for (const auto &text : texts) {
+    writer.Write(text);
   }
+}
 
-  std::cout << "Disassembling: " << argv[1] << " " << inputBuff.size()
-            << " instructions" << std::endl;
+} // namespace
 
-  auto disassembled = Disassembler::DisassembleToString(inputBuff);
+int main(int argc, char *argv[]) {
+  std::size_t threads = std::max(1U, std::thread::hardware_concurrency());
+  std::string outputPath;
+  bool codeOnly = false;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    try {
+      if (arg == "--threads" && i + 1 < argc) {
+        threads = std::stoul(argv[++i]);
+      } else if (arg == "--output" && i + 1 < argc) {
+        outputPath = argv[++i];
+      } else if (arg == "--code") {
+        codeOnly = true;
+      } else if (arg.starts_with("--")) {
+        std::cerr << "Unknown argument: " << arg << std::endl;
+        PrintUsage();
+        return 1;
+      } else {
+        inputs.push_back(arg);
+      }
+    } catch (const std::exception &) {
+      std::cerr << "Invalid value for " << arg << ": " << argv[i]
+                << std::endl;
+      PrintUsage();
+      return 1;
+    }
+  }
+  if (inputs.empty()) {
+    std::cerr << "Missing input file" << std::endl;
+    PrintUsage();
+    return 1;
+  }
 
-  std::cout << disassembled << std::endl;
+  int fd = STDOUT_FILENO;
+  if (!outputPath.empty()) {
+    fd = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+              0644);
+    if (fd < 0) {
+      std::cerr << "Failed to open output: " << outputPath << std::endl;
+      return 1;
+    }
+  }
 
-  if (argc == 3) {
-    std::ofstream output(argv[2]);
-    output << disassembled;
+  // Small ROMs are one chunk each, so chunks of all files are formatted
+  // together to keep every thread busy.
+  std::vector<std::unique_ptr<MappedFile>> files;
+  std::vector<Chunk> chunks;
+  std::vector<std::string> opened;
+  std::vector<std::span<const std::uint8_t>> programs;
+  int status = 0;
+  for (const auto &input : inputs) {
+    auto file = std::make_unique<MappedFile>();
+    if (!file->Open(input)) {
+      status = 1;
+      continue;
+    }
+    const auto bytes = file->GetBytes();
+    if (bytes.size() % 2 != 0) {
+      std::cerr << "Ignoring the odd last byte of " << input << std::endl;
+    }
+    if (codeOnly) {
+      opened.push_back(input);
+      programs.push_back(bytes);
+      files.push_back(std::move(file));
+      continue;
+    }
+    const auto words = bytes.size() / 2;
+    auto header = "Disassembling: " + input + " " + std::to_string(words) +
+                  " instructions\n";
+    for (std::size_t word = 0; word == 0 || word < words;
+         word += chunk_words) {
+      const auto count = std::min(chunk_words, words - word);
+      chunks.push_back(
+          {bytes.subspan(2 * word, 2 * count),
+           static_cast<std::uint16_t>(cpu::instruction_start +
+                                      word * Instructions::instruction_size),
+           word == 0 ? std::move(header) : std::string()});
+    }
+    files.push_back(std::move(file));
   }
 
-  return 0;
+  util::WorkStealingPool pool(threads);
+  Writer writer(fd);
+  if (codeOnly) {
+    DisassembleCode(opened, programs, pool, writer);
+  } else {
+    Disassemble(chunks, pool, writer);
+  }
+  if (!writer.Flush()) {
+    status = 1;
+  }
+  if (fd != STDOUT_FILENO) {
+    close(fd);
+  }
+  return status;
 }
@@ -0,0 +1,265 @@
+#include <Emulator/Emulator.h>
+#include <Util/CacheLine.h>
+#include <Util/WorkStealingPool.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum class Status {
+  // Ran the whole budget.
+  Completed,
+  // Stopped early on an instruction it could not execute.
+  Halted,
+  LoadFailed,
+};
+
+std::string ToString(Status status) {
+  switch (status) {
+  case Status::Completed:
+    return "completed";
+  case Status::Halted:
+    return "halted";
+  case Status::LoadFailed:
+    return "load-failed";
+  }
+  return "unknown";
+}
+
+// Every worker writes its own results, keep them on separate cache lines.
+struct alignas(util::cache_line_size) Result {
+  Status status = Status::LoadFailed;
+  std::uint64_t instructions = 0;
+  std::uint16_t pc = 0;
+  std::uint64_t screenHash = 0;
+  std::uint64_t registerHash = 0;
+};
+
+struct Options {
+  std::vector<std::filesystem::path> roms;
+  std::uint64_t instructions = 1'000'000;
+  std::uint64_t frames = 0;
+  std::uint64_t instructionsPerFrame = emulator::instructions_per_frame;
+  std::size_t threads = std::max(1U, std::thread::hardware_concurrency());
+  emulator::Engine engine = emulator::Engine::Interpreter;
+  bool jit = true;
+  // Every ROM starts from the same seed, so results do not depend on the
+  // thread that ran it.
+  std::uint64_t seed = cpu::default_seed;
+  std::filesystem::path output;
+};
+
+/// FNV-1a, stable across runs and hosts.
+class Hasher {
+public:
+  void Add(std::uint64_t value, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; ++i) {
+      mHash ^= (value >> (i * 8)) & 0xFF;
+      mHash *= 0x100000001b3ULL;
+    }
+  }
+  std::uint64_t Get() const { return mHash; }
+
+private:
+  std::uint64_t mHash = 0xcbf29ce484222325ULL;
+};
+
+std::uint64_t HashScreen(const Output::Display &display) {
+  Hasher hasher;
+  for (const auto &row : display.GetScreen()) {
+    for (auto word : row) {
+      hasher.Add(word, sizeof(word));
+    }
+  }
+  return hasher.Get();
+}
+
+std::uint64_t HashRegisters(const cpu::CpuState &state) {
+  const auto &registers = state.registers;
+  Hasher hasher;
+  for (auto reg : registers.V) {
+    hasher.Add(reg, sizeof(reg));
+  }
+  for (auto reg : {registers.VDelay, registers.VSound, registers.SP}) {
+    hasher.Add(reg, sizeof(reg));
+  }
+  hasher.Add(registers.I, sizeof(registers.I));
+  hasher.Add(registers.PC, sizeof(registers.PC));
+  return hasher.Get();
+}
+
+Result RunRom(const std::filesystem::path &rom, const Options &options) {
+  Result result;
+  auto emulator = std::make_unique<emulator::Emulator>();
+  emulator->SetEngine(options.engine);
+  emulator->SetJitEnabled(options.jit && emulator::jit::IsSupported());
+  emulator->SetSeed(options.seed);
+  emulator->GetScheduler().SetInstructionsPerFrame(
+      options.instructionsPerFrame);
+  if (!emulator->LoadGame(rom)) {
+    return result;
+  }
+  result.instructions = emulator->RunFor(options.instructions);
+  result.status = result.instructions == options.instructions
+                      ? Status::Completed
+                      : Status::Halted;
+  const auto &state = emulator->GetState();
+  result.pc = state.registers.PC;
+  result.screenHash = HashScreen(state.display);
+  result.registerHash = HashRegisters(state);
+  return result;
+}
+
+bool AddRoms(const std::filesystem::path &path, Options &options) {
+  std::error_code error;
+  if (std::filesystem::is_directory(path, error)) {
+    std::vector<std::filesystem::path> roms;
+    for (const auto &entry :
+         std::filesystem::directory_iterator(path, error)) {
+      if (entry.is_regular_file()) {
+        roms.push_back(entry.path());
+      }
+    }
+    // Directory order is not stable, the result order has to be.
+    std::sort(roms.begin(), roms.end());
+    options.roms.insert(options.roms.end(), roms.begin(), roms.end());
+    return !error;
+  }
+  options.roms.push_back(path);
+  return true;
+}
+
+bool AddRomList(const std::filesystem::path &list, Options &options) {
+  std::ifstream is(list);
+  if (!is) {
+    std::cerr << "Failed to open ROM list: " << list << std::endl;
+    return false;
+  }
+  std::string line;
+  while (std::getline(is, line)) {
+    if (!line.empty() && line[0] != '#') {
+      options.roms.emplace_back(line);
+    }
+  }
+  return true;
+}
+
+void PrintUsage() {
+  std::cerr << "Usage: Emulator-Batch [--threads N] [--instructions N | "
+               "--frames N] [--ipf N]\n"
+               "                      "
+               "[--engine instructions|interpreter|threaded] [--no-jit]\n"
+               "                      [--seed N] "
+               "[--output FILE] [--list FILE] "
+               "<rom or directory>...\n";
+}
+
+bool ParseArguments(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    try {
+      if (arg == "--threads" && hasValue) {
+        options.threads = std::stoul(argv[++i]);
+      } else if (arg == "--instructions" && hasValue) {
+        options.instructions = std::stoull(argv[++i]);
+      } else if (arg == "--frames" && hasValue) {
+        options.frames = std::stoull(argv[++i]);
+      } else if (arg == "--ipf" && hasValue) {
+        options.instructionsPerFrame = std::max(1ULL, std::stoull(argv[++i]));
+      } else if (arg == "--engine" && hasValue) {
+        const std::string engine = argv[++i];
+        if (engine == "instructions") {
+          options.engine = emulator::Engine::Instructions;
+        } else if (engine == "interpreter") {
+          options.engine = emulator::Engine::Interpreter;
+        } else if (engine == "threaded") {
+          options.engine = emulator::Engine::Threaded;
+        } else {
+          std::cerr << "Unknown engine: " << engine << std::endl;
+          return false;
+        }
+      } else if (arg == "--no-jit") {
+        options.jit = false;
+      } else if (arg == "--seed" && hasValue) {
+        options.seed = std::stoull(argv[++i], nullptr, 0);
+      } else if (arg == "--output" && hasValue) {
+        options.output = argv[++i];
+      } else if (arg == "--list" && hasValue) {
+        if (!AddRomList(argv[++i], options)) {
+          return false;
+        }
+      } else if (arg.starts_with("--")) {
+        std::cerr << "Unknown argument: " << arg << std::endl;
+        return false;
+      } else if (!AddRoms(arg, options)) {
+        std::cerr << "Failed to list: " << arg << std::endl;
+        return false;
+      }
+    } catch (const std::exception &) {
+      std::cerr << "Invalid value for " << arg << ": " << argv[i]
+                << std::endl;
+      return false;
+    }
+  }
+  if (options.frames > 0) {
+    options.instructions = options.frames * options.instructionsPerFrame;
+  }
+  return !options.roms.empty();
+}
+
+void WriteResults(std::ostream &os, const Options &options,
+                  const std::vector<Result> &results) {
+  os << "rom\tstatus\tinstructions\tpc\tscreen\tregisters\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto &result = results[i];
+    os << options.roms[i].string() << "\t" << ToString(result.status) << "\t"
+       << std::dec << result.instructions << "\t0x" << std::hex << result.pc
+       << "\t" << result.screenHash << "\t" << result.registerHash << "\n";
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!ParseArguments(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  // Results are stored by ROM index so the output does not depend on which
+  // thread ran which ROM.
+  std::vector<Result> results(options.roms.size());
+  util::WorkStealingPool pool(options.threads);
+  pool.Run(options.roms.size(), [&](std::size_t index) {
+    results[index] = RunRom(options.roms[index], options);
+  });
+
+  if (options.output.empty()) {
+    WriteResults(std::cout, options, results);
+  } else {
+    std::ofstream output(options.output);
+    if (!output) {
+      std::cerr << "Failed to open output: " << options.output << std::endl;
+      return 1;
+    }
+    WriteResults(output, options, results);
+  }
+
+  return std::all_of(results.begin(), results.end(),
+                     [](const Result &result) {
+                       return result.status != Status::LoadFailed;
+                     })
+             ? 0
+             : 1;
+}
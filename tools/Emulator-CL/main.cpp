@@ -2,20 +2,150 @@
 #include <Instructions/Disassembler.h>
 #include <Util/Binary.h>
 
+#include <atomic>
+#include <csignal>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <string>
+
+namespace {
+// Set by SIGUSR1, the run loop toggles turbo on its next frame.
+std::atomic<bool> toggle_turbo = false;
+
+void RequestTurboToggle(int) { toggle_turbo = true; }
+
+/// Runs at speed times real time, as fast as possible for 0.
+void SetSpeed(emulator::Scheduler &scheduler, double speed) {
+  if (speed > 0) {
+    scheduler.SetSpeed(speed);
+    scheduler.SetPacing(emulator::Pacing::RealTime);
+  } else {
+    scheduler.SetPacing(emulator::Pacing::Unthrottled);
+  }
+}
+
+/// Runs the emulator, toggling between the normal and the turbo speed on
+/// SIGUSR1 without touching the machine.
+void Run(emulator::Emulator &emulator, double speed, double turboSpeed) {
+  SetSpeed(emulator.GetScheduler(), speed);
+  std::signal(SIGUSR1, RequestTurboToggle);
+  bool turbo = false;
+  emulator.Run([&](emulator::Emulator &running) {
+    if (toggle_turbo.exchange(false)) {
+      turbo = !turbo;
+      SetSpeed(running.GetScheduler(), turbo ? turboSpeed : speed);
+      std::cerr << "Turbo " << (turbo ? "on" : "off") << std::endl;
+    }
+  });
+}
+
+void PrintUsage() {
+  std::cerr << "Usage: Emulator-CL <rom> "
+               "[--engine instructions|interpreter|threaded] [--ipf N]\n"
+               "                   [--no-jit] [--seed N] [--unthrottled] "
+               "[--verbose]\n"
+               "                   [--speed X] [--turbo X]\n"
+               "                   [--trace FILE | --trace-text FILE]\n"
+               "       Emulator-CL --decode-trace FILE\n"
+               "--speed runs at X times real time, 0 runs as fast as "
+               "possible.\n"
+               "SIGUSR1 toggles turbo, running at the --turbo speed (default "
+               "0).\n";
+}
+
+int DecodeTrace(const std::string &path) {
+  std::ifstream is(path, std::ios::binary);
+  if (!is) {
+    std::cerr << "Failed to open trace: " << path << std::endl;
+    return 1;
+  }
+  if (!emulator::DecodeTrace(is, std::cout)) {
+    std::cerr << "Not a binary trace: " << path << std::endl;
+    return 1;
+  }
+  return 0;
+}
+} // namespace
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
     std::cerr << "Missing input file" << std::endl;
+    PrintUsage();
     return 1;
   }
+  if (std::string(argv[1]) == "--decode-trace") {
+    if (argc != 3) {
+      PrintUsage();
+      return 1;
+    }
+    return DecodeTrace(argv[2]);
+  }
 
   emulator::Emulator emulator;
+  double speed = 1;
+  double turboSpeed = 0;
+  bool verbose = false;
+  for (int i = 2; i < argc; ++i) {
+    const std::string arg = argv[i];
+    try {
+      if (arg == "--engine" && i + 1 < argc) {
+        const std::string engine = argv[++i];
+        if (engine == "instructions") {
+          emulator.SetEngine(emulator::Engine::Instructions);
+        } else if (engine == "interpreter") {
+          emulator.SetEngine(emulator::Engine::Interpreter);
+        } else if (engine == "threaded") {
+          emulator.SetEngine(emulator::Engine::Threaded);
+        } else {
+          std::cerr << "Unknown engine: " << engine << std::endl;
+          return 1;
+        }
+      } else if (arg == "--ipf" && i + 1 < argc) {
+        emulator.GetScheduler().SetInstructionsPerFrame(std::stoull(argv[++i]));
+      } else if (arg == "--no-jit") {
+        emulator.SetJitEnabled(false);
+      } else if (arg == "--seed" && i + 1 < argc) {
+        emulator.SetSeed(std::stoull(argv[++i], nullptr, 0));
+      } else if (arg == "--verbose") {
+        verbose = true;
+      } else if (arg == "--unthrottled") {
+        speed = 0;
+      } else if ((arg == "--speed" || arg == "--turbo") && i + 1 < argc) {
+        const double value = std::stod(argv[++i]);
+        if (!(value >= 0)) {
+          std::cerr << "Speed must not be negative: " << value << std::endl;
+          return 1;
+        }
+        (arg == "--speed" ? speed : turboSpeed) = value;
+      } else if ((arg == "--trace" || arg == "--trace-text") && i + 1 < argc) {
+        const auto format = arg == "--trace" ? emulator::TraceFormat::Binary
+                                             : emulator::TraceFormat::Text;
+        if (!emulator.StartTrace(argv[++i], format)) {
+          return 1;
+        }
+      } else {
+        std::cerr << "Unknown argument: " << arg << std::endl;
+        PrintUsage();
+        return 1;
+      }
+    } catch (const std::exception &) {
+      std::cerr << "Invalid value for " << arg << ": " << argv[i]
+                << std::endl;
+      PrintUsage();
+      return 1;
+    }
+  }
+  emulator.SetVerbose(verbose);
+
   if (!emulator.LoadGame(argv[1])) {
     return 1;
   }
 
-  emulator.Run(true);
+  Run(emulator, speed, turboSpeed);
+  if (verbose) {
+    emulator.DumpState(std::cout);
+  }
 
   return 0;
 }
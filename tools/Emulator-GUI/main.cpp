@@ -3,12 +3,139 @@
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
+#include <Emulator/EmulationThread.h>
+#include <Input/Keys.h>
+#include <Output/Display.h>
+
 // stdlib
-#include <iostream>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace {
+constexpr int window_scale = 10;
+constexpr Uint32 lit_colour = 0xFFE0E0E0;
+constexpr Uint32 unlit_colour = 0xFF101010;
+// Turbo speeds to pick from with - and =, 0 runs as fast as possible.
+constexpr std::array<double, 5> turbo_speeds{2, 4, 8, 16, 0};
+
+/// Everything the SDL callbacks share. Emulation runs on its own thread, the
+/// callbacks only send it commands and show the frames it publishes.
+struct App {
+  SDL_Window *window = nullptr;
+  SDL_Renderer *renderer = nullptr;
+  SDL_Texture *texture = nullptr;
+  emulator::EmulationThread emulation;
+  // Number of the frame last uploaded to the texture.
+  std::uint64_t uploaded = 0;
+  bool turbo = false;
+  std::size_t turboSpeed = turbo_speeds.size() - 1;
+  // Speed shown in the window title.
+  double titleSpeed = 1;
+  std::array<Uint32, Output::display_width> pixels{};
+};
+
+/// The usual mapping of the hex keypad onto the left of the keyboard, by
+/// position so it works with any layout:
+///   1 2 3 4      1 2 3 C
+///   Q W E R  ->  4 5 6 D
+///   A S D F      7 8 9 E
+///   Z X C V      A 0 B F
+std::optional<input::KEY> ToKey(SDL_Scancode scancode) {
+  using input::KEY;
+  switch (scancode) {
+  case SDL_SCANCODE_1:
+    return KEY::KEY_1;
+  case SDL_SCANCODE_2:
+    return KEY::KEY_2;
+  case SDL_SCANCODE_3:
+    return KEY::KEY_3;
+  case SDL_SCANCODE_4:
+    return KEY::KEY_C;
+  case SDL_SCANCODE_Q:
+    return KEY::KEY_4;
+  case SDL_SCANCODE_W:
+    return KEY::KEY_5;
+  case SDL_SCANCODE_E:
+    return KEY::KEY_6;
+  case SDL_SCANCODE_R:
+    return KEY::KEY_D;
+  case SDL_SCANCODE_A:
+    return KEY::KEY_7;
+  case SDL_SCANCODE_S:
+    return KEY::KEY_8;
+  case SDL_SCANCODE_D:
+    return KEY::KEY_9;
+  case SDL_SCANCODE_F:
+    return KEY::KEY_E;
+  case SDL_SCANCODE_Z:
+    return KEY::KEY_A;
+  case SDL_SCANCODE_X:
+    return KEY::KEY_0;
+  case SDL_SCANCODE_C:
+    return KEY::KEY_B;
+  case SDL_SCANCODE_V:
+    return KEY::KEY_F;
+  default:
+    return std::nullopt;
+  }
+}
+
+void Send(App &app, const emulator::Command &command) {
+  if (!app.emulation.Send(command)) {
+    SDL_Log("Emulation is not keeping up, dropped a command");
+  }
+}
+
+/// Switches speed on the emulation thread, the machine keeps running.
+void SendSpeed(App &app) {
+  emulator::Command command{emulator::CommandType::SetSpeed, {}};
+  command.speed = app.turbo ? turbo_speeds[app.turboSpeed] : 1;
+  Send(app, command);
+}
 
-/* We will use this renderer to draw into this window every frame. */
-static SDL_Window *window = NULL;
-static SDL_Renderer *renderer = NULL;
+void UpdateTitle(App &app, double speed) {
+  if (speed == app.titleSpeed) {
+    return;
+  }
+  app.titleSpeed = speed;
+  std::string title = "Chip8";
+  if (speed == 0) {
+    title += " (turbo, uncapped)";
+  } else if (speed != 1) {
+    title += " (turbo, " + std::to_string(static_cast<int>(speed)) + "x)";
+  }
+  SDL_SetWindowTitle(app.window, title.c_str());
+}
+
+/// Converts and uploads the rows of frame that differ from the texture.
+void Upload(App &app, const emulator::Frame &frame) {
+  // Damage is relative to the previous frame, after skipping frames every row
+  // may differ.
+  const auto damage = frame.number == app.uploaded + 1 ? frame.damage
+                                                       : ~Output::RowMask{0};
+  app.uploaded = frame.number;
+  for (std::size_t y = 0; y < frame.height; ++y) {
+    if (((damage >> y) & 1) == 0) {
+      continue;
+    }
+    const auto &row = frame.screen[y];
+    for (std::size_t x = 0; x < frame.width; ++x) {
+      const auto word = row[x / Output::row_word_bits];
+      const bool lit =
+          (word >> (Output::row_word_bits - 1 - x % Output::row_word_bits)) &
+          1;
+      app.pixels[x] = lit ? lit_colour : unlit_colour;
+    }
+    const SDL_Rect rect{0, static_cast<int>(y), static_cast<int>(frame.width),
+                        1};
+    SDL_UpdateTexture(app.texture, &rect, app.pixels.data(),
+                      static_cast<int>(sizeof(app.pixels)));
+  }
+}
+} // namespace
 
 /* This function runs once at startup. */
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
@@ -20,56 +147,127 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
 
   SDL_Log("Running binary: %s", argv[1]);
 
-  SDL_SetAppMetadata("Example Renderer Clear", "1.0",
-                     "com.example.renderer-clear");
+  SDL_SetAppMetadata("Chip8 Emulator", "1.0", "com.chip8emulator.gui");
 
   if (!SDL_Init(SDL_INIT_VIDEO)) {
     SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
     return SDL_APP_FAILURE;
   }
 
-  if (!SDL_CreateWindowAndRenderer("examples/renderer/clear", 640, 480,
-                                   SDL_WINDOW_RESIZABLE, &window, &renderer)) {
+  auto *app = new App;
+  *appstate = app;
+  constexpr int width = Output::display_width;
+  constexpr int height = Output::display_height;
+  if (!SDL_CreateWindowAndRenderer("Chip8", width * window_scale,
+                                   height * window_scale, SDL_WINDOW_RESIZABLE,
+                                   &app->window, &app->renderer)) {
     SDL_Log("Couldn't create window/renderer: %s", SDL_GetError());
     return SDL_APP_FAILURE;
   }
-  SDL_SetRenderLogicalPresentation(renderer, 640, 480,
+  // Both resolutions are 2:1, so one logical size fits either.
+  SDL_SetRenderLogicalPresentation(app->renderer, width, height,
                                    SDL_LOGICAL_PRESENTATION_LETTERBOX);
+  // Presenting waits for vsync, which only paces this thread.
+  SDL_SetRenderVSync(app->renderer, 1);
 
+  app->texture =
+      SDL_CreateTexture(app->renderer, SDL_PIXELFORMAT_ARGB8888,
+                        SDL_TEXTUREACCESS_STREAMING, width, height);
+  if (!app->texture) {
+    SDL_Log("Couldn't create texture: %s", SDL_GetError());
+    return SDL_APP_FAILURE;
+  }
+  SDL_SetTextureScaleMode(app->texture, SDL_SCALEMODE_NEAREST);
+
+  Send(*app, {emulator::CommandType::Load, argv[1]});
   return SDL_APP_CONTINUE; /* carry on with the program! */
 }
 
 /* This function runs when a new event (mouse input, keypresses, etc) occurs. */
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
-  if (event->type == SDL_EVENT_QUIT) {
+  auto &app = *static_cast<App *>(appstate);
+  switch (event->type) {
+  case SDL_EVENT_QUIT:
     return SDL_APP_SUCCESS; /* end the program, reporting success to the OS. */
+  case SDL_EVENT_DROP_FILE:
+    Send(app, {emulator::CommandType::Load, event->drop.data});
+    break;
+  case SDL_EVENT_KEY_UP:
+    if (const auto key = ToKey(event->key.scancode)) {
+      app.emulation.ReleaseKey(*key);
+    }
+    break;
+  case SDL_EVENT_KEY_DOWN:
+    if (event->key.repeat) {
+      break;
+    }
+    // Straight to the emulation thread, without waiting for this frame.
+    if (const auto key = ToKey(event->key.scancode)) {
+      app.emulation.PressKey(*key);
+      break;
+    }
+    switch (event->key.key) {
+    case SDLK_ESCAPE:
+      return SDL_APP_SUCCESS;
+    case SDLK_P:
+      Send(app, {emulator::CommandType::TogglePause, {}});
+      break;
+    case SDLK_N:
+      Send(app, {emulator::CommandType::Step, {}});
+      break;
+    case SDLK_F5:
+      Send(app, {emulator::CommandType::Reset, {}});
+      break;
+    case SDLK_T:
+      app.turbo = !app.turbo;
+      SendSpeed(app);
+      break;
+    case SDLK_MINUS:
+      if (app.turboSpeed > 0) {
+        --app.turboSpeed;
+        app.turbo = true;
+        SendSpeed(app);
+      }
+      break;
+    case SDLK_EQUALS:
+      if (app.turboSpeed + 1 < turbo_speeds.size()) {
+        ++app.turboSpeed;
+        app.turbo = true;
+        SendSpeed(app);
+      }
+      break;
+    default:
+      break;
+    }
+    break;
+  default:
+    break;
   }
   return SDL_APP_CONTINUE; /* carry on with the program! */
 }
 
 /* This function runs once per frame, and is the heart of the program. */
 SDL_AppResult SDL_AppIterate(void *appstate) {
-  const double now = ((double)SDL_GetTicks()) /
-                     1000.0; /* convert from milliseconds to seconds. */
-  /* choose the color for the frame we will draw. The sine wave trick makes it
-   * fade between colors smoothly. */
-  const float red = (float)(0.5 + 0.5 * SDL_sin(now));
-  const float green = (float)(0.5 + 0.5 * SDL_sin(now + SDL_PI_D * 2 / 3));
-  const float blue = (float)(0.5 + 0.5 * SDL_sin(now + SDL_PI_D * 4 / 3));
-  SDL_SetRenderDrawColorFloat(
-      renderer, red, green, blue,
-      SDL_ALPHA_OPAQUE_FLOAT); /* new color, full alpha. */
-
-  /* clear the window to the draw color. */
-  SDL_RenderClear(renderer);
-
-  /* put the newly-cleared rendering on the screen. */
-  SDL_RenderPresent(renderer);
-
+  auto &app = *static_cast<App *>(appstate);
+  // Only the newest frame is shown, frames emulated in between are dropped
+  // rather than queued behind vsync. In turbo the thread does not even
+  // publish them.
+  if (app.emulation.UpdateFrame()) {
+    Upload(app, app.emulation.GetFrame());
+    UpdateTitle(app, app.emulation.GetFrame().speed);
+  }
+  const auto &frame = app.emulation.GetFrame();
+  const SDL_FRect source{0, 0, static_cast<float>(frame.width),
+                         static_cast<float>(frame.height)};
+  SDL_SetRenderDrawColor(app.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+  SDL_RenderClear(app.renderer);
+  SDL_RenderTexture(app.renderer, app.texture, &source, nullptr);
+  SDL_RenderPresent(app.renderer);
   return SDL_APP_CONTINUE; /* carry on with the program! */
 }
 
 /* This function runs once at shutdown. */
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
-  /* SDL will clean up the window/renderer for us. */
+  // Stops the emulation thread, SDL cleans up the window and renderer.
+  delete static_cast<App *>(appstate);
 }